@@ -53,17 +53,27 @@ void QSvgAbstractAnimation::evaluateAnimation(qreal elapsedTime)
 
     qreal fractionOfCurrentIterationTime = fractionOfTotalTime - std::trunc(fractionOfTotalTime);
 
-    for (QSvgAbstractAnimatedProperty *animProperty : m_properties) {
-        const QList<qreal> keyFrames = animProperty->keyFrames();
-        for (int i = 1; i < keyFrames.size(); i++) {
-            qreal from = keyFrames.at(i - 1);
-            qreal to = keyFrames.at(i);
-            if (fractionOfCurrentIterationTime >= from && fractionOfCurrentIterationTime < to) {
-                qreal currFraction = (fractionOfCurrentIterationTime - from) / (to - from);
-                animProperty->interpolate(i, currFraction);
-            }
-        }
-    }
+    for (QSvgAbstractAnimatedProperty *animProperty : std::as_const(m_properties))
+        animProperty->evaluate(fractionOfCurrentIterationTime);
+}
+
+/*!
+    \internal
+
+    Pre-samples the properties of one iteration at \a fps frames per second,
+    see QSvgAbstractAnimatedProperty::bake(). A non-positive \a fps removes
+    the sampled tables again.
+*/
+void QSvgAbstractAnimation::bake(int fps)
+{
+    // Keep the tables bounded for very long iterations
+    constexpr qint64 MaxSamples = 1 << 16;
+    const int samples = (fps > 0 && m_duration > 0)
+            ? int(qBound<qint64>(1, (qint64(m_duration) * fps + 999) / 1000, MaxSamples))
+            : 0;
+
+    for (QSvgAbstractAnimatedProperty *animProperty : std::as_const(m_properties))
+        animProperty->bake(samples);
 }
 
 void QSvgAbstractAnimation::setRunningTime(int startMs, int durationMs)
@@ -35,6 +35,7 @@ public:
 
     virtual AnimationType animationType() const = 0;
     void evaluateAnimation(qreal elapsedTime);
+    void bake(int fps);
 
     void setRunningTime(int startMs, int durationMs);
     int start() const;
@@ -8,20 +8,26 @@
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qglobalstatic.h>
 
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
 Q_STATIC_LOGGING_CATEGORY(lcSvgAnimatedProperty, "qt.svg.animation.properties")
 
 typedef QHash<QString, QSvgAbstractAnimatedProperty::Type> AnimatableHashType;
-Q_GLOBAL_STATIC(AnimatableHashType, animatableProperties)
 
-static void initHash()
+static AnimatableHashType createAnimatableHash()
 {
-    animatableProperties->insert(QStringLiteral("fill"), QSvgAbstractAnimatedProperty::Color);
-    animatableProperties->insert(QStringLiteral("stroke"), QSvgAbstractAnimatedProperty::Color);
-    animatableProperties->insert(QStringLiteral("transform"), QSvgAbstractAnimatedProperty::Transform);
+    AnimatableHashType hash;
+    hash.insert(QStringLiteral("fill"), QSvgAbstractAnimatedProperty::Color);
+    hash.insert(QStringLiteral("stroke"), QSvgAbstractAnimatedProperty::Color);
+    hash.insert(QStringLiteral("transform"), QSvgAbstractAnimatedProperty::Transform);
+    return hash;
 }
 
+// Initialized on first use in a thread-safe manner, documents may be loaded concurrently
+Q_GLOBAL_STATIC(AnimatableHashType, animatableProperties, createAnimatableHash())
+
 static qreal q_lerp(qreal a, qreal b, qreal t)
 {
     return a + (b - a) * t;
@@ -39,6 +45,7 @@ static QPointF pointInterpolator(QPointF v1, QPointF v2, qreal t)
 QSvgAbstractAnimatedProperty::QSvgAbstractAnimatedProperty(const QString &name, Type type)
     : m_propertyName(name)
     , m_type(type)
+    , m_propertyId(propertyIdForName(name))
 {
 }
 
@@ -56,14 +63,10 @@ void QSvgAbstractAnimatedProperty::appendKeyFrame(qreal keyFrame)
     m_keyFrames.append(keyFrame);
 }
 
-QList<qreal> QSvgAbstractAnimatedProperty::keyFrames() const
-{
-    return m_keyFrames;
-}
-
 void QSvgAbstractAnimatedProperty::setPropertyName(const QString &name)
 {
     m_propertyName = name;
+    m_propertyId = propertyIdForName(name);
 }
 
 QStringView QSvgAbstractAnimatedProperty::propertyName() const
@@ -78,14 +81,98 @@ QSvgAbstractAnimatedProperty::Type QSvgAbstractAnimatedProperty::type() const
 
 QVariant QSvgAbstractAnimatedProperty::interpolatedValue() const
 {
-    return m_interpolatedValue;
+    switch (m_type) {
+    case QSvgAbstractAnimatedProperty::Color:
+        return m_interpolatedColor;
+    case QSvgAbstractAnimatedProperty::Transform:
+        return m_interpolatedTransform;
+    default:
+        break;
+    }
+    return QVariant();
 }
 
-QSvgAbstractAnimatedProperty *QSvgAbstractAnimatedProperty::createAnimatedProperty(const QString &name)
+bool QSvgAbstractAnimatedProperty::interpolateAt(qreal fraction)
+{
+    for (int i = 1; i < m_keyFrames.size(); i++) {
+        qreal from = m_keyFrames.at(i - 1);
+        qreal to = m_keyFrames.at(i);
+        if (fraction >= from && fraction < to) {
+            qreal currFraction = (fraction - from) / (to - from);
+            interpolate(i, currFraction);
+            return true;
+        }
+    }
+    return false;
+}
+
+void QSvgAbstractAnimatedProperty::evaluate(qreal fraction)
+{
+    if (m_bakedSampleCount > 0) {
+        // Snap times that fall on a sample up to rounding errors onto it
+        const qreal position = fraction * m_bakedSampleCount + 1e-9;
+        const int index = qBound(0, int(position), m_bakedSampleCount - 1);
+        if (!m_bakedFallback.at(index)) {
+            loadBakedSample(index);
+            return;
+        }
+    }
+    interpolateAt(fraction);
+}
+
+/*!
+    \internal
+
+    Samples one iteration of the property at \a samples evenly spaced
+    fractions into a lookup table, so that evaluate() becomes an index
+    computation. A sample holds the value at the start of its interval;
+    intervals that contain a key frame are still evaluated exactly, so the
+    key frame values themselves are never approximated. Passing 0 drops
+    the table.
+*/
+void QSvgAbstractAnimatedProperty::bake(int samples)
 {
-    if (animatableProperties->isEmpty())
-        initHash();
+    m_bakedSampleCount = 0;
+    m_bakedFallback.clear();
+    setBakedSampleCount(0);
+    if (samples <= 0 || m_keyFrames.size() < 2)
+        return;
 
+    const QColor color = m_interpolatedColor;
+    const QTransform transform = m_interpolatedTransform;
+
+    setBakedSampleCount(samples);
+    m_bakedFallback.resize(samples);
+    for (int i = 0; i < samples; ++i) {
+        const qreal from = qreal(i) / samples;
+        const qreal to = qreal(i + 1) / samples;
+        bool fallback = !interpolateAt(from);
+        for (qreal keyFrame : std::as_const(m_keyFrames)) {
+            if (keyFrame >= from && keyFrame < to)
+                fallback = true;
+        }
+        m_bakedFallback[i] = fallback;
+        storeBakedSample(i);
+    }
+    m_bakedSampleCount = samples;
+
+    m_interpolatedColor = color;
+    m_interpolatedTransform = transform;
+}
+
+QSvgAbstractAnimatedProperty::PropertyId QSvgAbstractAnimatedProperty::propertyIdForName(QStringView name)
+{
+    if (name == QLatin1String("fill"))
+        return PropertyId::Fill;
+    if (name == QLatin1String("stroke"))
+        return PropertyId::Stroke;
+    if (name == QLatin1String("transform"))
+        return PropertyId::Transform;
+    return PropertyId::Unknown;
+}
+
+QSvgAbstractAnimatedProperty *QSvgAbstractAnimatedProperty::createAnimatedProperty(const QString &name)
+{
     if (!animatableProperties->contains(name)) {
         qCDebug(lcSvgAnimatedProperty) << "Property : " << name << " is not animatable";
         return nullptr;
@@ -138,7 +225,23 @@ void QSvgAnimatedPropertyColor::interpolate(uint index, qreal t)
     int green  = q_lerp(c1.green(), c2.green(), t);
     int blue   = q_lerp(c1.blue(), c2.blue(), t);
 
-    m_interpolatedValue = QColor(red, green, blue, alpha);
+    m_interpolatedColor = QColor(red, green, blue, alpha);
+}
+
+void QSvgAnimatedPropertyColor::setBakedSampleCount(int samples)
+{
+    m_bakedColors.resize(samples);
+    m_bakedColors.squeeze();
+}
+
+void QSvgAnimatedPropertyColor::storeBakedSample(int index)
+{
+    m_bakedColors[index] = m_interpolatedColor.rgba();
+}
+
+void QSvgAnimatedPropertyColor::loadBakedSample(int index)
+{
+    m_interpolatedColor = QColor::fromRgba(m_bakedColors.at(index));
 }
 
 QSvgAnimatedPropertyTransform::QSvgAnimatedPropertyTransform(const QString &name)
@@ -147,115 +250,160 @@ QSvgAnimatedPropertyTransform::QSvgAnimatedPropertyTransform(const QString &name
 
 }
 
+void QSvgAnimatedPropertyTransform::reserveStride(qsizetype stride)
+{
+    if (stride <= m_stride)
+        return;
+
+    QList<qreal> components(2 * ComponentCount * stride, 0.0);
+    for (int row = 0; row < 2 * ComponentCount; ++row) {
+        std::copy_n(m_components.constBegin() + row * m_stride, m_sizes[row / 2],
+                    components.begin() + row * stride);
+    }
+    m_components = std::move(components);
+    m_stride = stride;
+}
+
+void QSvgAnimatedPropertyTransform::appendValues(Component component, qreal x, qreal y)
+{
+    const qsizetype index = m_sizes[component];
+    if (index == m_stride)
+        reserveStride(qMax<qsizetype>(4, m_stride * 2));
+
+    m_components[(component * 2) * m_stride + index] = x;
+    m_components[(component * 2 + 1) * m_stride + index] = y;
+    m_sizes[component] = index + 1;
+}
+
+void QSvgAnimatedPropertyTransform::setPoints(Component component, const QList<QPointF> &points)
+{
+    reserveStride(points.size());
+    m_sizes[component] = 0;
+    for (const QPointF &point : points)
+        appendValues(component, point.x(), point.y());
+}
+
+QList<QPointF> QSvgAnimatedPropertyTransform::points(Component component) const
+{
+    QList<QPointF> result;
+    result.reserve(m_sizes[component]);
+    for (qsizetype i = 0; i < m_sizes[component]; ++i)
+        result.append(point(component, i));
+    return result;
+}
+
 void QSvgAnimatedPropertyTransform::setTranslations(const QList<QPointF> &translations)
 {
-    m_translations = translations;
+    setPoints(Translation, translations);
 }
 
 void QSvgAnimatedPropertyTransform::appendTranslation(const QPointF &translation)
 {
-    m_translations.append(translation);
+    appendValues(Translation, translation.x(), translation.y());
 }
 
 QList<QPointF> QSvgAnimatedPropertyTransform::translations() const
 {
-    return m_translations;
+    return points(Translation);
 }
 
 void QSvgAnimatedPropertyTransform::setScales(const QList<QPointF> &scales)
 {
-    m_scales = scales;
+    setPoints(Scale, scales);
 }
 
 void QSvgAnimatedPropertyTransform::appendScale(const QPointF &scale)
 {
-    m_scales.append(scale);
+    appendValues(Scale, scale.x(), scale.y());
 }
 
 QList<QPointF> QSvgAnimatedPropertyTransform::scales() const
 {
-    return m_scales;
+    return points(Scale);
 }
 
 void QSvgAnimatedPropertyTransform::setRotations(const QList<qreal> &rotations)
 {
-    m_rotations = rotations;
+    reserveStride(rotations.size());
+    m_sizes[Rotation] = 0;
+    for (qreal rotation : rotations)
+        appendValues(Rotation, rotation, 0);
 }
 
 void QSvgAnimatedPropertyTransform::appendRotation(qreal rotation)
 {
-    m_rotations.append(rotation);
+    appendValues(Rotation, rotation, 0);
 }
 
 QList<qreal> QSvgAnimatedPropertyTransform::rotations() const
 {
-    return m_rotations;
+    QList<qreal> result;
+    result.reserve(m_sizes[Rotation]);
+    for (qsizetype i = 0; i < m_sizes[Rotation]; ++i)
+        result.append(value(Rotation, 0, i));
+    return result;
 }
 
 void QSvgAnimatedPropertyTransform::setCentersOfRotation(const QList<QPointF> &centersOfRotations)
 {
-    m_centersOfRotation = centersOfRotations;
+    setPoints(CenterOfRotation, centersOfRotations);
 }
 
 void QSvgAnimatedPropertyTransform::appendCenterOfRotation(const QPointF &centerOfRotation)
 {
-    m_centersOfRotation.append(centerOfRotation);
+    appendValues(CenterOfRotation, centerOfRotation.x(), centerOfRotation.y());
 }
 
 QList<QPointF> QSvgAnimatedPropertyTransform::centersOfRotations() const
 {
-    return m_centersOfRotation;
+    return points(CenterOfRotation);
 }
 
 void QSvgAnimatedPropertyTransform::setSkews(const QList<QPointF> &skews)
 {
-    m_skews = skews;
+    setPoints(Skew, skews);
 }
 
 void QSvgAnimatedPropertyTransform::appendSkew(const QPointF &skew)
 {
-    m_skews.append(skew);
+    appendValues(Skew, skew.x(), skew.y());
 }
 
 QList<QPointF> QSvgAnimatedPropertyTransform::skews() const
 {
-    return m_skews;
+    return points(Skew);
+}
+
+QPointF QSvgAnimatedPropertyTransform::interpolatedPoint(Component component, uint index, qreal t) const
+{
+    return pointInterpolator(point(component, index - 1), point(component, index), t);
 }
 
 qreal QSvgAnimatedPropertyTransform::interpolatedRotation(uint index, qreal t) const
 {
-    qreal r1 = m_rotations.at(index - 1);
-    qreal r2 = m_rotations.at(index);
+    qreal r1 = value(Rotation, 0, index - 1);
+    qreal r2 = value(Rotation, 0, index);
     return q_lerp(r1, r2, t);
 }
 
 QPointF QSvgAnimatedPropertyTransform::interpolatedCenterOfRotation(uint index, qreal t) const
 {
-    QPointF cor1 = m_centersOfRotation.at(index - 1);
-    QPointF cor2 = m_centersOfRotation.at(index);
-    return pointInterpolator(cor1, cor2, t);
+    return interpolatedPoint(CenterOfRotation, index, t);
 }
 
 QPointF QSvgAnimatedPropertyTransform::interpolatedSkew(uint index, qreal t) const
 {
-    QPointF skew1 = m_skews.at(index - 1);
-    QPointF skew2 = m_skews.at(index);
-
-    return pointInterpolator(skew1, skew2, t);
+    return interpolatedPoint(Skew, index, t);
 }
 
 QPointF QSvgAnimatedPropertyTransform::interpolatedTranslation(uint index, qreal t) const
 {
-    QPointF t1 = m_translations.at(index - 1);
-    QPointF t2 = m_translations.at(index);
-    return pointInterpolator(t1, t2, t);
+    return interpolatedPoint(Translation, index, t);
 }
 
 QPointF QSvgAnimatedPropertyTransform::interpolatedScale(uint index, qreal t) const
 {
-    QPointF s1 = m_scales.at(index - 1);
-    QPointF s2 = m_scales.at(index);
-    return pointInterpolator(s1, s2, t);
+    return interpolatedPoint(Scale, index, t);
 }
 
 void QSvgAnimatedPropertyTransform::interpolate(uint index, qreal t)
@@ -267,18 +415,17 @@ void QSvgAnimatedPropertyTransform::interpolate(uint index, qreal t)
 
     QTransform transform = QTransform();
 
-    if (m_skews.size() == m_keyFrames.size()) {
+    if (hasComponent(Skew)) {
         const QPointF skew = interpolatedSkew(index, t);
         transform.shear(qTan(qDegreesToRadians(skew.x())), qTan(qDegreesToRadians(skew.y())));
     }
 
-    if (m_scales.size() == m_keyFrames.size()) {
+    if (hasComponent(Scale)) {
         const QPointF scale = interpolatedScale(index, t);
         transform.scale(scale.x(), scale.y());
     }
 
-    if (m_rotations.size() == m_keyFrames.size() &&
-        m_centersOfRotation.size() == m_keyFrames.size()) {
+    if (hasComponent(Rotation) && hasComponent(CenterOfRotation)) {
         const qreal rotation = interpolatedRotation(index, t);
         const QPointF cor = interpolatedCenterOfRotation(index, t);
 
@@ -287,12 +434,35 @@ void QSvgAnimatedPropertyTransform::interpolate(uint index, qreal t)
         transform.translate(-cor.x(), -cor.y());
     }
 
-    if (m_translations.size() == m_keyFrames.size()) {
+    if (hasComponent(Translation)) {
         const QPointF translation = interpolatedTranslation(index, t);
         transform.translate(translation.x(), translation.y());
     }
 
-    m_interpolatedValue = transform;
+    m_interpolatedTransform = transform;
+}
+
+void QSvgAnimatedPropertyTransform::setBakedSampleCount(int samples)
+{
+    m_bakedMatrices.resize(6 * samples);
+    m_bakedMatrices.squeeze();
+}
+
+void QSvgAnimatedPropertyTransform::storeBakedSample(int index)
+{
+    float *m = m_bakedMatrices.data() + 6 * index;
+    m[0] = m_interpolatedTransform.m11();
+    m[1] = m_interpolatedTransform.m12();
+    m[2] = m_interpolatedTransform.m21();
+    m[3] = m_interpolatedTransform.m22();
+    m[4] = m_interpolatedTransform.dx();
+    m[5] = m_interpolatedTransform.dy();
+}
+
+void QSvgAnimatedPropertyTransform::loadBakedSample(int index)
+{
+    const float *m = m_bakedMatrices.constData() + 6 * index;
+    m_interpolatedTransform = QTransform(m[0], m[1], m[2], m[3], m[4], m[5]);
 }
 
 QT_END_NAMESPACE
@@ -21,6 +21,7 @@
 #include <QtCore/qstring.h>
 #include <QtCore/qpoint.h>
 #include <QtGui/qcolor.h>
+#include <QtGui/qtransform.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -35,26 +36,58 @@ public:
         Transform,
     };
 
+    // Resolved from the property name once, so that applying an animation
+    // does not need to compare strings
+    enum class PropertyId : quint8
+    {
+        Unknown,
+        Fill,
+        Stroke,
+        Transform,
+    };
+
     QSvgAbstractAnimatedProperty(const QString &name, Type type);
     virtual ~QSvgAbstractAnimatedProperty();
 
     void setKeyFrames(const QList<qreal> &keyFrames);
     void appendKeyFrame(qreal keyFrame);
-    QList<qreal> keyFrames() const;
+    const QList<qreal> &keyFrames() const { return m_keyFrames; }
     void setPropertyName(const QString &name);
     QStringView propertyName() const;
+    PropertyId propertyId() const { return m_propertyId; }
     Type type() const;
     QVariant interpolatedValue() const;
+    QColor interpolatedColor() const { return m_interpolatedColor; }
+    const QTransform &interpolatedTransform() const { return m_interpolatedTransform; }
     virtual void interpolate(uint index, qreal t) = 0;
 
+    void evaluate(qreal fraction);
+    void bake(int samples);
+    bool isBaked() const { return m_bakedSampleCount > 0; }
+
     static QSvgAbstractAnimatedProperty *createAnimatedProperty(const QString &name);
+    static PropertyId propertyIdForName(QStringView name);
+
 protected:
+    bool interpolateAt(qreal fraction);
+
+    // Typed storage of the pre-sampled values, see bake()
+    virtual void setBakedSampleCount(int samples) = 0;
+    virtual void storeBakedSample(int index) = 0;
+    virtual void loadBakedSample(int index) = 0;
+
     QList<qreal> m_keyFrames;
-    QVariant m_interpolatedValue;
+    QColor m_interpolatedColor;
+    QTransform m_interpolatedTransform;
 
 private:
     QString m_propertyName;
     Type m_type;
+    PropertyId m_propertyId;
+    int m_bakedSampleCount = 0;
+    // Samples whose interval contains a key frame, or no key frame
+    // segment at all, are evaluated exactly instead of looked up
+    QList<bool> m_bakedFallback;
 };
 
 class Q_SVG_EXPORT QSvgAnimatedPropertyColor : public QSvgAbstractAnimatedProperty
@@ -68,8 +101,14 @@ public:
 
     void interpolate(uint index, qreal t) override;
 
+protected:
+    void setBakedSampleCount(int samples) override;
+    void storeBakedSample(int index) override;
+    void loadBakedSample(int index) override;
+
 private:
     QList<QColor> m_colors;
+    QList<QRgb> m_bakedColors;
 };
 
 class Q_SVG_EXPORT QSvgAnimatedPropertyTransform : public QSvgAbstractAnimatedProperty
@@ -105,12 +144,46 @@ public:
     QPointF interpolatedTranslation(uint index, qreal t) const;
     QPointF interpolatedSkew(uint index, qreal t) const;
 
+protected:
+    void setBakedSampleCount(int samples) override;
+    void storeBakedSample(int index) override;
+    void loadBakedSample(int index) override;
+
 private:
-    QList<QPointF> m_translations;
-    QList<QPointF> m_scales;
-    QList<qreal> m_rotations;
-    QList<QPointF> m_centersOfRotation;
-    QList<QPointF> m_skews;
+    enum Component {
+        Translation,
+        Scale,
+        Rotation,
+        CenterOfRotation,
+        Skew,
+        ComponentCount
+    };
+
+    // Each component owns two consecutive rows (x and y, rotation only
+    // uses the first one) of m_stride values in m_components.
+    qreal value(Component component, int row, uint index) const
+    {
+        return m_components.at((component * 2 + row) * m_stride + index);
+    }
+    QPointF point(Component component, uint index) const
+    {
+        return QPointF(value(component, 0, index), value(component, 1, index));
+    }
+    QPointF interpolatedPoint(Component component, uint index, qreal t) const;
+    void reserveStride(qsizetype stride);
+    void appendValues(Component component, qreal x, qreal y);
+    void setPoints(Component component, const QList<QPointF> &points);
+    QList<QPointF> points(Component component) const;
+    bool hasComponent(Component component) const
+    {
+        return m_sizes[component] == m_keyFrames.size();
+    }
+
+    QList<qreal> m_components;
+    qsizetype m_stride = 0;
+    qsizetype m_sizes[ComponentCount] = {};
+    // 2x3 affine matrices: m11, m12, m21, m22, dx, dy
+    QList<float> m_bakedMatrices;
 };
 
 QT_END_NAMESPACE
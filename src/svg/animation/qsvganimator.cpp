@@ -15,52 +15,59 @@ QSvgAbstractAnimator::QSvgAbstractAnimator()
 
 QSvgAbstractAnimator::~QSvgAbstractAnimator()
 {
-    for (auto animationHash : {&m_animationsCSS, &m_animationsSMIL}) {
-        for (auto itr = animationHash->begin(); itr != animationHash->end(); itr++) {
-            QList<QSvgAbstractAnimation *> &nodeAnimations = itr.value();
-            for (QSvgAbstractAnimation *anim : nodeAnimations)
-                delete anim;
-        }
-    }
+    qDeleteAll(m_animationsCSS);
+    qDeleteAll(m_animationsSMIL);
 }
 
 
-void QSvgAbstractAnimator::appendAnimation(const QSvgNode *node, QSvgAbstractAnimation *anim)
+void QSvgAbstractAnimator::appendAnimation(QSvgNode *node, QSvgAbstractAnimation *anim)
 {
     if (!node)
         return;
 
+    node->appendAnimation(anim);
+
+    if (m_registered.contains(anim))
+        return;
+    m_registered.insert(anim);
+
     if (anim->animationType() == QSvgAbstractAnimation::SMIL)
-        m_animationsSMIL[node].append(anim);
+        m_animationsSMIL.append(anim);
     else
-        m_animationsCSS[node].append(anim);
+        m_animationsCSS.append(anim);
 }
 
 QList<QSvgAbstractAnimation *> QSvgAbstractAnimator::animationsForNode(const QSvgNode *node) const
 {
-    return combinedAnimationsForNode(node);
+    if (!node)
+        return QList<QSvgAbstractAnimation *>();
+
+    return node->animations();
 }
 
 void QSvgAbstractAnimator::advanceAnimations()
 {
     qreal elapsedTime = currentElapsed();
-    for (auto itr = m_animationsCSS.begin(); itr != m_animationsCSS.end(); itr++) {
-        QList<QSvgAbstractAnimation *> &nodeAnimations = itr.value();
-        for (QSvgAbstractAnimation *anim : nodeAnimations) {
-            if (!anim->finished())
-                anim->evaluateAnimation(elapsedTime);
-        }
+    for (QSvgAbstractAnimation *anim : std::as_const(m_animationsCSS)) {
+        if (!anim->finished())
+            anim->evaluateAnimation(elapsedTime);
     }
 
-    for (auto itr = m_animationsSMIL.begin(); itr != m_animationsSMIL.end(); itr++) {
-        QList<QSvgAbstractAnimation *> &nodeAnimations = itr.value();
-        for (QSvgAbstractAnimation *anim : nodeAnimations) {
-            if (!anim->finished())
-                anim->evaluateAnimation(elapsedTime);
-        }
+    for (QSvgAbstractAnimation *anim : std::as_const(m_animationsSMIL)) {
+        if (!anim->finished())
+            anim->evaluateAnimation(elapsedTime);
     }
 }
 
+void QSvgAbstractAnimator::bakeAnimations(int fps)
+{
+    for (QSvgAbstractAnimation *anim : std::as_const(m_animationsCSS))
+        anim->bake(fps);
+
+    for (QSvgAbstractAnimation *anim : std::as_const(m_animationsSMIL))
+        anim->bake(fps);
+}
+
 void QSvgAbstractAnimator::setAnimationDuration(qint64 dur)
 {
     m_animationDuration = dur;
@@ -71,14 +78,6 @@ qint64 QSvgAbstractAnimator::animationDuration() const
     return m_animationDuration;
 }
 
-QList<QSvgAbstractAnimation *> QSvgAbstractAnimator::combinedAnimationsForNode(const QSvgNode *node) const
-{
-    if (!node)
-        return QList<QSvgAbstractAnimation *>();
-
-    return m_animationsSMIL.value(node) + m_animationsCSS.value(node);
-}
-
 QSvgAnimator::QSvgAnimator()
 {
 }
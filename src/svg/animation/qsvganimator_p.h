@@ -19,6 +19,8 @@
 #include <QtSvg/private/qsvgnode_p.h>
 #include "qsvgabstractanimation_p.h"
 
+#include <QtCore/qset.h>
+
 QT_BEGIN_NAMESPACE
 
 class Q_SVG_EXPORT QSvgAbstractAnimator
@@ -27,10 +29,11 @@ public:
     QSvgAbstractAnimator();
     virtual ~QSvgAbstractAnimator();
 
-    void appendAnimation(const QSvgNode *node, QSvgAbstractAnimation *anim);
+    void appendAnimation(QSvgNode *node, QSvgAbstractAnimation *anim);
     QList<QSvgAbstractAnimation *> animationsForNode(const QSvgNode *node) const;
 
     void advanceAnimations();
+    void bakeAnimations(int fps);
     virtual void restartAnimation() = 0;
     virtual qint64 currentElapsed() = 0;
     virtual void setAnimatorTime(qint64 time) = 0;
@@ -43,11 +46,10 @@ protected:
     qint64 m_animationDuration;
 
 private:
-    QList<QSvgAbstractAnimation *> combinedAnimationsForNode(const QSvgNode *node) const;
-
-private:
-    QHash<const QSvgNode *, QList<QSvgAbstractAnimation *>> m_animationsSMIL;
-    QHash<const QSvgNode *, QList<QSvgAbstractAnimation *>> m_animationsCSS;
+    // Owned animations, each listed once even if bound to several nodes
+    QList<QSvgAbstractAnimation *> m_animationsSMIL;
+    QList<QSvgAbstractAnimation *> m_animationsCSS;
+    QSet<const QSvgAbstractAnimation *> m_registered;
 };
 
 class Q_SVG_EXPORT QSvgAnimator : public QSvgAbstractAnimator
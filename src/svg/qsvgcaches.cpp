@@ -0,0 +1,826 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qsvgcaches_p.h"
+#include "qsvgnode_p.h"
+#include "qsvgstructure_p.h"
+#include "qsvggraphics_p.h"
+#include "qsvgtinydocument_p.h"
+
+#include <QtGui/qimageiohandler.h>
+
+QT_BEGIN_NAMESPACE
+
+static constexpr int MaxCacheableDepth = 64;
+static constexpr qsizetype DefaultCacheBudget = 32 * 1024;
+static constexpr qsizetype DefaultUseCacheLimit = 4 * 1024;
+
+namespace {
+
+struct CacheBudget
+{
+    CacheBudget()
+    {
+        bool ok = false;
+        const int limit = qEnvironmentVariableIntValue("QT_SVG_CACHE_LIMIT", &ok);
+        maxCost = ok ? qMax(0, limit) : DefaultCacheBudget;
+    }
+
+    QMutex mutex;
+    qsizetype maxCost;
+    qsizetype totalCost = 0;
+};
+
+} // namespace
+
+Q_GLOBAL_STATIC(CacheBudget, cacheBudget)
+
+static bool isStaticSubtree(const QSvgNode *node, int depth)
+{
+    if (!node)
+        return true;
+    if (depth > MaxCacheableDepth || node->hasAnimations())
+        return false;
+
+    const QSvgTinyDocument *doc = node->document();
+    auto isStaticReference = [&](const QString &id) {
+        return id.isEmpty() || !doc || isStaticSubtree(doc->namedNode(id), depth + 1);
+    };
+    auto isStaticPaint = [&](QSvgPaintStyleProperty *paint) {
+        if (!paint || paint->type() != QSvgStyleProperty::PATTERN)
+            return true;
+        return isStaticSubtree(static_cast<QSvgPatternStyle *>(paint)->patternNode(), depth + 1);
+    };
+
+    if (!isStaticReference(node->maskId()) || !isStaticReference(node->filterId())
+        || !isStaticReference(node->clipPathId())
+        || !isStaticReference(node->markerStartId())
+        || !isStaticReference(node->markerMidId()) || !isStaticReference(node->markerEndId())) {
+        return false;
+    }
+
+    const QSvgStaticStyle &style = node->style();
+    if ((style.fill && !isStaticPaint(style.fill->style()))
+        || (style.stroke && !isStaticPaint(style.stroke->style()))) {
+        return false;
+    }
+
+    switch (node->type()) {
+    case QSvgNode::Doc:
+    case QSvgNode::Group:
+    case QSvgNode::Defs:
+    case QSvgNode::Switch:
+    case QSvgNode::Mask:
+    case QSvgNode::ClipPath:
+    case QSvgNode::Symbol:
+    case QSvgNode::Marker:
+    case QSvgNode::Pattern:
+    case QSvgNode::Filter: {
+        const auto *structure = static_cast<const QSvgStructureNode *>(node);
+        const QList<QSvgNode *> children = structure->renderers();
+        for (const QSvgNode *child : children) {
+            if (!isStaticSubtree(child, depth + 1))
+                return false;
+        }
+        break;
+    }
+    case QSvgNode::Use:
+        return isStaticSubtree(static_cast<const QSvgUse *>(node)->link(), depth + 1);
+    case QSvgNode::Video:
+        return false;
+    default:
+        break;
+    }
+    return true;
+}
+
+/*!
+    \internal
+    \class QSvgCacheBase
+
+    The common part of the caches that a document keeps between renders:
+    the size limit, the lock, the hit and miss counts, and whether the
+    content of a node is static enough for its rasters to be kept.
+
+    The limit is in kilobytes. Its default is given by each cache and can
+    be changed with an environment variable of its own. A limit of 0
+    disables the cache.
+
+    On top of their own limits, all caches of all documents in the process
+    share one budget, globalMaxCost(). When it is reached, a cache evicts
+    its own least recently used entries to make room for a new one, and
+    does not keep the new one if that is not enough. The budget is 32 MB by
+    default and can be changed with setGlobalMaxCost() or with the
+    \c QT_SVG_CACHE_LIMIT environment variable, in kilobytes. A budget of
+    0 disables all caches. Inserts that race in different caches may
+    briefly exceed the budget by the entries being inserted.
+*/
+
+QSvgCacheBase::QSvgCacheBase(const char *limitVariable, qsizetype defaultLimit)
+{
+    bool ok = false;
+    const int limit = qEnvironmentVariableIntValue(limitVariable, &ok);
+    m_maxCost = ok ? qMax(0, limit) : defaultLimit;
+}
+
+QSvgCacheBase::~QSvgCacheBase()
+{
+    if (CacheBudget *budget = cacheBudget()) {
+        QMutexLocker locker(&budget->mutex);
+        budget->totalCost -= m_budgeted;
+    }
+}
+
+void QSvgCacheBase::setMaxCost(qsizetype kilobytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxCost = qMax<qsizetype>(0, kilobytes);
+    setMaxCostLocked(m_maxCost);
+    updateBudgetLocked();
+}
+
+qsizetype QSvgCacheBase::maxCost() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxCost;
+}
+
+qsizetype QSvgCacheBase::totalCost() const
+{
+    QMutexLocker locker(&m_mutex);
+    return totalCostLocked();
+}
+
+void QSvgCacheBase::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    clearLocked();
+    m_cacheable.clear();
+    updateBudgetLocked();
+}
+
+/*!
+    \internal
+
+    Returns \c true if both the limit of the cache and the global budget
+    allow entries to be kept.
+*/
+bool QSvgCacheBase::isEnabled() const
+{
+    return maxCost() > 0 && globalMaxCost() > 0;
+}
+
+/*!
+    \internal
+
+    Returns \c true if rasters of \a node can be kept, that is if the
+    cache is enabled and the content of the node is static.
+*/
+bool QSvgCacheBase::isCacheable(const QSvgNode *node)
+{
+    if (globalMaxCost() <= 0)
+        return false;
+    QMutexLocker locker(&m_mutex);
+    if (m_maxCost <= 0)
+        return false;
+
+    auto it = m_cacheable.constFind(node);
+    if (it == m_cacheable.cend())
+        it = m_cacheable.insert(node, isCacheableNode(node));
+    return it.value();
+}
+
+bool QSvgCacheBase::isCacheableNode(const QSvgNode *node) const
+{
+    return isStaticContent(node);
+}
+
+/*!
+    \internal
+
+    Returns \c true if nothing \a node draws changes over time, that is if
+    neither the node, nor its descendants, nor the nodes it references have
+    animations.
+*/
+bool QSvgCacheBase::isStaticContent(const QSvgNode *node)
+{
+    return isStaticSubtree(node, 0);
+}
+
+qint64 QSvgCacheBase::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+qint64 QSvgCacheBase::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
+
+void QSvgCacheBase::resetStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+    m_hits = m_misses = 0;
+}
+
+/*!
+    \internal
+
+    Returns the cost of keeping \a image, in kilobytes.
+*/
+qsizetype QSvgCacheBase::imageCost(const QImage &image)
+{
+    return (image.sizeInBytes() + 1023) / 1024;
+}
+
+/*!
+    \internal
+
+    Sets the budget shared by all caches of the process to \a kilobytes.
+    Caches over a lowered budget shrink as they take new entries.
+*/
+void QSvgCacheBase::setGlobalMaxCost(qsizetype kilobytes)
+{
+    CacheBudget *budget = cacheBudget();
+    QMutexLocker locker(&budget->mutex);
+    budget->maxCost = qMax<qsizetype>(0, kilobytes);
+}
+
+qsizetype QSvgCacheBase::globalMaxCost()
+{
+    CacheBudget *budget = cacheBudget();
+    QMutexLocker locker(&budget->mutex);
+    return budget->maxCost;
+}
+
+qsizetype QSvgCacheBase::globalTotalCost()
+{
+    CacheBudget *budget = cacheBudget();
+    QMutexLocker locker(&budget->mutex);
+    return budget->totalCost;
+}
+
+/*!
+    \internal
+
+    Returns how many kilobytes the cache may hold, given its own limit and
+    what the other caches use of the global budget.
+*/
+qsizetype QSvgCacheBase::availableCostLocked() const
+{
+    CacheBudget *budget = cacheBudget();
+    QMutexLocker locker(&budget->mutex);
+    const qsizetype others = budget->totalCost - m_budgeted;
+    return qMin(m_maxCost, budget->maxCost - others);
+}
+
+/*!
+    \internal
+
+    Charges the change in the size of the cache to the global budget.
+*/
+void QSvgCacheBase::updateBudgetLocked()
+{
+    const qsizetype cost = totalCostLocked();
+    CacheBudget *budget = cacheBudget();
+    QMutexLocker locker(&budget->mutex);
+    budget->totalCost += cost - m_budgeted;
+    m_budgeted = cost;
+}
+
+/*!
+    \internal
+    \class QSvgRasterCache
+
+    A QSvgCacheBase that keeps entries of type \c T by \c Key in a QCache,
+    with the cost of each entry in kilobytes. The least recently used
+    entries are evicted first.
+*/
+
+QSvgPaintState QSvgPaintState::capture(const QPainter *p, const QSvgExtraStates &states)
+{
+    return QSvgPaintState{ p->pen(), p->brush(), p->font(), p->renderHints(),
+                           states.fillOpacity, states.strokeOpacity, states.strokeDashOffset,
+                           states.svgFont, states.textAnchor, states.fontWeight,
+                           states.fillRule, states.vectorEffect, states.imageRendering };
+}
+
+bool QSvgPaintState::operator==(const QSvgPaintState &other) const
+{
+    return pen == other.pen && brush == other.brush && font == other.font
+            && renderHints == other.renderHints
+            && fillOpacity == other.fillOpacity && strokeOpacity == other.strokeOpacity
+            && strokeDashOffset == other.strokeDashOffset && svgFont == other.svgFont
+            && textAnchor == other.textAnchor && fontWeight == other.fontWeight
+            && fillRule == other.fillRule && vectorEffect == other.vectorEffect
+            && imageRendering == other.imageRendering;
+}
+
+/*!
+    \internal
+    \class QSvgFilterCache
+
+    Keeps the filtered rasters of nodes between renders, so that a static
+    filtered subtree is drawn and filtered only once.
+
+    Entries are keyed by node, filter and device transform and are
+    validated against the inherited paint state before they are reused.
+    Subtrees that contain animations are never cached.
+
+    The default limit is 10 MB and can be changed with the
+    \c QT_SVG_FILTER_CACHE_LIMIT environment variable, in kilobytes.
+*/
+
+QSvgFilterCache::QSvgFilterCache()
+    : QSvgRasterCache("QT_SVG_FILTER_CACHE_LIMIT", 10 * 1024)
+{
+}
+
+/*!
+    \internal
+
+    Looks up the filtered raster of \a node drawn with \a filter in the
+    current state of \a p and \a states. Returns \c true and stores it in
+    \a image on a hit.
+*/
+bool QSvgFilterCache::find(const QSvgNode *node, const QSvgFilterContainer *filter,
+                           const QPainter *p, const QSvgExtraStates &states, QImage *image)
+{
+    if (!isCacheable(node))
+        return false;
+
+    const QSvgPaintState state = QSvgPaintState::capture(p, states);
+    QSvgPaintedRaster entry;
+    if (!lookup(QSvgFilterCacheKey{ node, filter, p->transform() }, &entry,
+                [&](const QSvgPaintedRaster &e) { return e.state == state; })) {
+        return false;
+    }
+    *image = entry.image;
+    return true;
+}
+
+void QSvgFilterCache::insert(const QSvgNode *node, const QSvgFilterContainer *filter,
+                             const QPainter *p, const QSvgExtraStates &states,
+                             const QImage &image)
+{
+    if (image.isNull() || !isCacheable(node))
+        return;
+
+    store(QSvgFilterCacheKey{ node, filter, p->transform() },
+          QSvgPaintedRaster{ QSvgPaintState::capture(p, states), image }, imageCost(image));
+}
+
+/*!
+    \internal
+    \class QSvgMaskCache
+
+    Keeps the masks of a document between renders, so that a mask shared
+    by many nodes, or drawn in many frames, is only rendered once for each
+    target.
+
+    Entries are keyed by mask node, the local rectangle of the target, the
+    device transform and the device rectangle the mask covers. Masks with
+    animated content are never cached.
+
+    The default limit is 4 MB and can be changed with the
+    \c QT_SVG_MASK_CACHE_LIMIT environment variable, in kilobytes.
+*/
+
+QSvgMaskCache::QSvgMaskCache()
+    : QSvgRasterCache("QT_SVG_MASK_CACHE_LIMIT", 4 * 1024)
+{
+}
+
+/*!
+    \internal
+
+    Looks up the mask rendered by \a mask for a target with the local
+    bounds \a localRect, drawn with \a transform, that covers \a deviceRect.
+    Returns \c true and stores it in \a image on a hit.
+*/
+bool QSvgMaskCache::find(const QSvgNode *mask, const QRectF &localRect, const QTransform &transform,
+                         const QRect &deviceRect, QImage *image)
+{
+    return isCacheable(mask)
+            && lookup(QSvgMaskCacheKey{ mask, localRect, transform, deviceRect }, image);
+}
+
+void QSvgMaskCache::insert(const QSvgNode *mask, const QRectF &localRect, const QTransform &transform,
+                           const QRect &deviceRect, const QImage &image)
+{
+    if (image.isNull() || !isCacheable(mask))
+        return;
+
+    store(QSvgMaskCacheKey{ mask, localRect, transform, deviceRect }, image, imageCost(image));
+}
+
+/*!
+    \internal
+    \class QSvgMarkerCache
+
+    Keeps rasters of the markers of a document, so that a marker drawn at
+    many vertices is rendered once and then stamped at each of them.
+
+    Entries are keyed by marker node, the transform of the marker relative
+    to its device pixel grid, the size of the marker viewport, which
+    depends on the stroke width for strokeWidth marker units, and the
+    painter opacity, which is part of the raster. They are
+    validated against the inherited paint state before they are reused.
+    Callers check isCacheable() first, markers with animated content are
+    never cached.
+
+    The default limit is 4 MB and can be changed with the
+    \c QT_SVG_MARKER_CACHE_LIMIT environment variable, in kilobytes.
+*/
+
+QSvgMarkerCache::QSvgMarkerCache()
+    : QSvgRasterCache("QT_SVG_MARKER_CACHE_LIMIT", 4 * 1024)
+{
+}
+
+/*!
+    \internal
+
+    Looks up the raster of \a marker drawn with \a transform into a
+    viewport of \a size, in the current state of \a p and \a states.
+    Returns \c true and stores it in \a image on a hit.
+*/
+bool QSvgMarkerCache::find(const QSvgNode *marker, const QTransform &transform, const QSizeF &size,
+                           const QPainter *p, const QSvgExtraStates &states, QImage *image)
+{
+    const QSvgPaintState state = QSvgPaintState::capture(p, states);
+    QSvgPaintedRaster entry;
+    if (!lookup(QSvgMarkerCacheKey{ marker, transform, size, p->opacity() }, &entry,
+                [&](const QSvgPaintedRaster &e) { return e.state == state; })) {
+        return false;
+    }
+    *image = entry.image;
+    return true;
+}
+
+void QSvgMarkerCache::insert(const QSvgNode *marker, const QTransform &transform, const QSizeF &size,
+                             const QPainter *p, const QSvgExtraStates &states, const QImage &image)
+{
+    if (image.isNull())
+        return;
+
+    store(QSvgMarkerCacheKey{ marker, transform, size, p->opacity() },
+          QSvgPaintedRaster{ QSvgPaintState::capture(p, states), image }, imageCost(image));
+}
+
+/*!
+    \internal
+    \class QSvgPatternCache
+
+    Keeps the rendered tiles of the patterns of a document, so that a
+    pattern filling many shapes, or drawn in many frames, is only rendered
+    once for each tile size and content scale.
+
+    Entries are keyed by pattern node, the size of the tile in device
+    pixels and the scale of the pattern content, which together depend on
+    the device scale and, for objectBoundingBox units, on the bounding box
+    of the filled shape. Content scales are quantized to 1/4096. Patterns
+    with animated content, or with animated ancestors, are never cached.
+
+    The default limit is 8 MB and can be changed with the
+    \c QT_SVG_PATTERN_CACHE_LIMIT environment variable, in kilobytes.
+*/
+
+QSvgPatternCacheKey QSvgPatternCacheKey::create(const QSvgNode *pattern, const QSize &size,
+                                                qreal contentScaleX, qreal contentScaleY)
+{
+    return QSvgPatternCacheKey{ pattern, size, qRound64(contentScaleX * 4096),
+                                qRound64(contentScaleY * 4096) };
+}
+
+QSvgPatternCache::QSvgPatternCache()
+    : QSvgRasterCache("QT_SVG_PATTERN_CACHE_LIMIT", 8 * 1024)
+{
+}
+
+bool QSvgPatternCache::isCacheableNode(const QSvgNode *pattern) const
+{
+    // The tile is rendered with the style of the ancestors of the pattern
+    bool cacheable = isStaticSubtree(pattern, 0);
+    for (const QSvgNode *node = pattern->parent(); cacheable && node; node = node->parent())
+        cacheable = !node->hasAnimations();
+    return cacheable;
+}
+
+/*!
+    \internal
+
+    Looks up the tile of \a pattern rendered at \a size with the content
+    scaled by \a contentScaleX and \a contentScaleY. Returns \c true and
+    stores it in \a image on a hit.
+*/
+bool QSvgPatternCache::find(const QSvgNode *pattern, const QSize &size,
+                            qreal contentScaleX, qreal contentScaleY, QImage *image)
+{
+    return isCacheable(pattern)
+            && lookup(QSvgPatternCacheKey::create(pattern, size, contentScaleX, contentScaleY),
+                      image);
+}
+
+void QSvgPatternCache::insert(const QSvgNode *pattern, const QSize &size,
+                              qreal contentScaleX, qreal contentScaleY, const QImage &image)
+{
+    if (image.isNull() || !isCacheable(pattern))
+        return;
+
+    store(QSvgPatternCacheKey::create(pattern, size, contentScaleX, contentScaleY), image,
+          imageCost(image));
+}
+
+/*!
+    \internal
+    \class QSvgStrokeCache
+
+    Keeps the stroke outlines of the nodes of a document, so that wide and
+    dashed strokes are only run through QPainterPathStroker once and then
+    filled on every draw.
+
+    Outlines are in the user space of the node and keyed by node, the
+    properties of the pen that shape the outline, and the device scale the
+    curves were flattened for, in steps of half an octave.
+
+    The default limit is 8 MB and can be changed with the
+    \c QT_SVG_STROKE_CACHE_LIMIT environment variable, in kilobytes.
+*/
+
+QSvgStrokeCacheKey QSvgStrokeCacheKey::create(const QSvgNode *node, const QPen &pen, int scaleStep)
+{
+    const bool dashed = pen.style() != Qt::SolidLine;
+    return QSvgStrokeCacheKey{ node, pen.widthF(), dashed ? pen.dashPattern() : QList<qreal>(),
+                               dashed ? pen.dashOffset() : 0, pen.capStyle(), pen.joinStyle(),
+                               pen.miterLimit(), scaleStep };
+}
+
+QSvgStrokeCache::QSvgStrokeCache()
+    : QSvgRasterCache("QT_SVG_STROKE_CACHE_LIMIT", 8 * 1024)
+{
+}
+
+/*!
+    \internal
+
+    Looks up the outline of \a node stroked with \a pen for the device
+    scale \a scaleStep. Returns \c true and stores the outline and its
+    bounds in \a outline and \a bounds on a hit. Either may be null.
+*/
+bool QSvgStrokeCache::find(const QSvgNode *node, const QPen &pen, int scaleStep,
+                           QPainterPath *outline, QRectF *bounds)
+{
+    QSvgStrokeOutline entry;
+    if (!lookup(QSvgStrokeCacheKey::create(node, pen, scaleStep), &entry))
+        return false;
+
+    if (outline)
+        *outline = entry.outline;
+    if (bounds)
+        *bounds = entry.bounds;
+    return true;
+}
+
+void QSvgStrokeCache::insert(const QSvgNode *node, const QPen &pen, int scaleStep,
+                             const QPainterPath &outline, const QRectF &bounds)
+{
+    const qsizetype bytes = outline.elementCount() * qsizetype(sizeof(QPainterPath::Element));
+    store(QSvgStrokeCacheKey::create(node, pen, scaleStep), QSvgStrokeOutline{ outline, bounds },
+          (bytes + 1023) / 1024);
+}
+
+/*!
+    \internal
+    \class QSvgUseCache
+
+    Keeps rasters of the targets of \c{<use>} elements, so that a symbol
+    or group referenced many times at one scale is rendered once and then
+    blitted at the translation of each reference.
+
+    Entries are keyed by target node, the transform of the target relative
+    to its device pixel grid, the painter opacity and a hash of the
+    inherited paint state, so that references with different inherited
+    fills or strokes get rasters of their own. The full paint state is
+    compared before an entry is reused. Callers check isCacheable() first,
+    targets with animated content are never cached.
+
+    The cache is disabled unless the document is loaded with the
+    QtSvg::CacheUseElements option, in which case it holds up to 4 MB. The
+    \c QT_SVG_USE_CACHE_LIMIT environment variable, in kilobytes, or
+    setMaxCost() override that limit. Hits and misses are counted, and
+    reported per frame in the \c qt.svg.draw logging category.
+*/
+
+QSvgUseCacheKey QSvgUseCacheKey::create(const QSvgNode *link, const QTransform &transform,
+                                        const QPainter *p, const QSvgPaintState &state)
+{
+    const QPen &pen = state.pen;
+    const QBrush &brush = state.brush;
+    const size_t paintKey = qHashMulti(0, quint64(pen.color().rgba64()), pen.widthF(),
+                                       int(pen.style()), int(pen.brush().style()),
+                                       quint64(brush.color().rgba64()), int(brush.style()),
+                                       state.font, int(state.renderHints), state.fillOpacity,
+                                       state.strokeOpacity, state.svgFont, int(state.textAnchor),
+                                       state.fontWeight, int(state.fillRule));
+    return QSvgUseCacheKey{ link, transform, p->opacity(), paintKey };
+}
+
+QSvgUseCache::QSvgUseCache(bool enabled)
+    : QSvgRasterCache("QT_SVG_USE_CACHE_LIMIT", enabled ? DefaultUseCacheLimit : 0)
+{
+}
+
+/*!
+    \internal
+
+    Looks up the raster of \a link drawn with \a transform in the current
+    state of \a p and \a states. Returns \c true and stores it in
+    \a image on a hit.
+*/
+bool QSvgUseCache::find(const QSvgNode *link, const QTransform &transform, const QPainter *p,
+                        const QSvgExtraStates &states, QImage *image)
+{
+    const QSvgPaintState state = QSvgPaintState::capture(p, states);
+    QSvgPaintedRaster entry;
+    if (!lookup(QSvgUseCacheKey::create(link, transform, p, state), &entry,
+                [&](const QSvgPaintedRaster &e) { return e.state == state; })) {
+        return false;
+    }
+    *image = entry.image;
+    return true;
+}
+
+void QSvgUseCache::insert(const QSvgNode *link, const QTransform &transform, const QPainter *p,
+                          const QSvgExtraStates &states, const QImage &image)
+{
+    if (image.isNull())
+        return;
+
+    const QSvgPaintState state = QSvgPaintState::capture(p, states);
+    store(QSvgUseCacheKey::create(link, transform, p, state), QSvgPaintedRaster{ state, image },
+          imageCost(image));
+}
+
+/*!
+    \internal
+
+    Reports the hits and misses of the frame that was drawn since the last
+    call, if there were any.
+*/
+void QSvgUseCache::endFrame()
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 frameHits = m_hits - m_reportedHits;
+    const qint64 frameMisses = m_misses - m_reportedMisses;
+    if (frameHits + frameMisses > 0) {
+        qCDebug(lcSvgDraw, "<use> cache: %lld hits, %lld misses (%.1f%% hit rate), %lld KB",
+                frameHits, frameMisses, 100.0 * frameHits / (frameHits + frameMisses),
+                qint64(totalCostLocked()));
+    }
+    m_reportedHits = m_hits;
+    m_reportedMisses = m_misses;
+}
+
+/*!
+    \internal
+    \class QSvgScratchBufferPool
+
+    Keeps the offscreen buffers that nodes are drawn into for group
+    opacity, filters and masks, so that they are reused by later nodes and
+    frames instead of being allocated and faulted in again.
+
+    Buffers are kept in buckets of their exact size and their contents are
+    undefined when handed out. Buffers that were not used again during a
+    whole frame are released by endFrame(), which the document calls after
+    drawing itself or one of its elements. The buffers used in the last
+    frame are released by releaseIdle() once the pool has not been used
+    for IdleTimeout milliseconds; QSvgRenderer calls it after rendering
+    stops. An allocation that reuses a buffer counts as a hit.
+
+    The default limit is 16 MB and can be changed with the
+    \c QT_SVG_SCRATCH_BUFFER_LIMIT environment variable, in kilobytes.
+*/
+
+QSvgScratchBufferPool::QSvgScratchBufferPool()
+    : QSvgCacheBase("QT_SVG_SCRATCH_BUFFER_LIMIT", 16 * 1024)
+{
+    m_lastUse.start();
+}
+
+void QSvgScratchBufferPool::setMaxCostLocked(qsizetype kilobytes)
+{
+    if (m_bytes > kilobytes * 1024)
+        clearLocked();
+}
+
+qsizetype QSvgScratchBufferPool::totalCostLocked() const
+{
+    return (m_bytes + 1023) / 1024;
+}
+
+void QSvgScratchBufferPool::clearLocked()
+{
+    m_buckets.clear();
+    m_bytes = 0;
+}
+
+/*!
+    \internal
+
+    Stores an ARGB32_Premultiplied image of \a size in \a image, reusing a
+    kept buffer if there is one. The contents of the image are undefined.
+    Returns \c false if the image could not be allocated.
+*/
+bool QSvgScratchBufferPool::allocate(const QSize &size, QImage *image)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastUse.restart();
+        auto it = m_buckets.find(bucketKey(size));
+        if (it != m_buckets.end() && !it->isEmpty()) {
+            *image = std::move(it->last().image);
+            it->removeLast();
+            m_bytes -= image->sizeInBytes();
+            image->setOffset(QPoint());
+            ++m_hits;
+            updateBudgetLocked();
+            return true;
+        }
+        ++m_misses;
+    }
+    return QImageIOHandler::allocateImage(size, QImage::Format_ARGB32_Premultiplied, image);
+}
+
+/*!
+    \internal
+
+    Takes \a image for later reuse, unless its pixels are still shared with
+    another image, for example one in a cache.
+*/
+void QSvgScratchBufferPool::recycle(QImage &&image)
+{
+    if (image.isNull() || !image.isDetached()
+        || image.format() != QImage::Format_ARGB32_Premultiplied) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_lastUse.restart();
+    const qsizetype bytes = image.sizeInBytes();
+    if (m_bytes + bytes > availableCostLocked() * 1024)
+        return;
+    m_bytes += bytes;
+    const QSize size = image.size();
+    m_buckets[bucketKey(size)].append(Entry{ std::move(image), m_frame });
+    updateBudgetLocked();
+}
+
+/*!
+    \internal
+
+    Marks the end of a frame and releases the buffers that were kept since
+    before the frame and not used during it.
+*/
+void QSvgScratchBufferPool::endFrame()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+        it->removeIf([&](const Entry &entry) {
+            if (entry.frame == m_frame)
+                return false;
+            m_bytes -= entry.image.sizeInBytes();
+            return true;
+        });
+        if (it->isEmpty())
+            it = m_buckets.erase(it);
+        else
+            ++it;
+    }
+    ++m_frame;
+    m_lastUse.restart();
+    updateBudgetLocked();
+}
+
+/*!
+    \internal
+
+    Releases all buffers if the pool has not been used for \a timeout
+    milliseconds. Returns the time in milliseconds until the kept buffers
+    would be idle for that long, or 0 if the pool is empty.
+*/
+int QSvgScratchBufferPool::releaseIdle(int timeout)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_buckets.isEmpty())
+        return 0;
+    const qint64 idle = m_lastUse.elapsed();
+    if (idle < timeout)
+        return int(timeout - idle);
+    clearLocked();
+    updateBudgetLocked();
+    return 0;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,417 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSVGCACHES_P_H
+#define QSVGCACHES_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtSvg/private/qtsvgglobal_p.h>
+#include <QtCore/qcache.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qrect.h>
+#include <QtGui/qbrush.h>
+#include <QtGui/qfont.h>
+#include <QtGui/qimage.h>
+#include <QtGui/qpainter.h>
+#include <QtGui/qpainterpath.h>
+#include <QtGui/qpen.h>
+#include <QtGui/qtransform.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSvgNode;
+class QSvgFont;
+class QSvgFilterContainer;
+struct QSvgExtraStates;
+
+class Q_SVG_EXPORT QSvgCacheBase
+{
+public:
+    virtual ~QSvgCacheBase();
+
+    void setMaxCost(qsizetype kilobytes);
+    qsizetype maxCost() const;
+    qsizetype totalCost() const;
+    void clear();
+
+    bool isEnabled() const;
+    bool isCacheable(const QSvgNode *node);
+
+    qint64 hits() const;
+    qint64 misses() const;
+    void resetStatistics();
+
+    static qsizetype imageCost(const QImage &image);
+    static bool isStaticContent(const QSvgNode *node);
+
+    static void setGlobalMaxCost(qsizetype kilobytes);
+    static qsizetype globalMaxCost();
+    static qsizetype globalTotalCost();
+
+protected:
+    QSvgCacheBase(const char *limitVariable, qsizetype defaultLimit);
+
+    virtual bool isCacheableNode(const QSvgNode *node) const;
+
+    // Called with m_mutex held
+    virtual void setMaxCostLocked(qsizetype kilobytes) = 0;
+    virtual qsizetype totalCostLocked() const = 0;
+    virtual void clearLocked() = 0;
+
+    qsizetype availableCostLocked() const;
+    void updateBudgetLocked();
+
+    mutable QMutex m_mutex;
+    qsizetype m_maxCost = 0;
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+
+private:
+    QHash<const QSvgNode *, bool> m_cacheable;
+    qsizetype m_budgeted = 0;
+};
+
+template <typename Key, typename T>
+class QSvgRasterCache : public QSvgCacheBase
+{
+protected:
+    QSvgRasterCache(const char *limitVariable, qsizetype defaultLimit)
+        : QSvgCacheBase(limitVariable, defaultLimit)
+    {
+        m_cache.setMaxCost(m_maxCost);
+    }
+
+    // Copies the entry of key to value if there is one and accept() takes it
+    template <typename Accept>
+    bool lookup(const Key &key, T *value, Accept accept)
+    {
+        QMutexLocker locker(&m_mutex);
+        const T *entry = m_cache.object(key);
+        if (!entry || !accept(*entry)) {
+            ++m_misses;
+            return false;
+        }
+        ++m_hits;
+        *value = *entry;
+        return true;
+    }
+
+    bool lookup(const Key &key, T *value)
+    {
+        return lookup(key, value, [](const T &) { return true; });
+    }
+
+    // Evicts the least recently used entries to keep within the limit and the global budget
+    void store(const Key &key, T value, qsizetype kilobytes)
+    {
+        QMutexLocker locker(&m_mutex);
+        const qsizetype available = availableCostLocked();
+        if (available <= 0)
+            return;
+        m_cache.setMaxCost(available);
+        m_cache.insert(key, new T(std::move(value)), qMax<qsizetype>(1, kilobytes));
+        m_cache.setMaxCost(m_maxCost);
+        updateBudgetLocked();
+    }
+
+    void setMaxCostLocked(qsizetype kilobytes) override { m_cache.setMaxCost(kilobytes); }
+    qsizetype totalCostLocked() const override { return m_cache.totalCost(); }
+    void clearLocked() override { m_cache.clear(); }
+
+private:
+    QCache<Key, T> m_cache;
+};
+
+// Everything a node inherits that changes how it is drawn into a buffer
+struct Q_SVG_EXPORT QSvgPaintState
+{
+    QPen pen;
+    QBrush brush;
+    QFont font;
+    QPainter::RenderHints renderHints;
+    qreal fillOpacity;
+    qreal strokeOpacity;
+    qreal strokeDashOffset;
+    QSvgFont *svgFont;
+    Qt::Alignment textAnchor;
+    int fontWeight;
+    Qt::FillRule fillRule;
+    bool vectorEffect;
+    qint8 imageRendering;
+
+    static QSvgPaintState capture(const QPainter *p, const QSvgExtraStates &states);
+    bool operator==(const QSvgPaintState &other) const;
+};
+
+// A raster that is only valid in the paint state it was drawn in
+struct QSvgPaintedRaster
+{
+    QSvgPaintState state;
+    QImage image;
+};
+
+struct QSvgFilterCacheKey
+{
+    const QSvgNode *node;
+    const QSvgFilterContainer *filter;
+    QTransform transform;
+
+    friend bool operator==(const QSvgFilterCacheKey &a, const QSvgFilterCacheKey &b) noexcept
+    {
+        return a.node == b.node && a.filter == b.filter && a.transform == b.transform;
+    }
+    friend size_t qHash(const QSvgFilterCacheKey &key, size_t seed = 0) noexcept
+    {
+        const QTransform &t = key.transform;
+        return qHashMulti(seed, key.node, key.filter, t.m11(), t.m12(), t.m13(),
+                          t.m21(), t.m22(), t.m23(), t.m31(), t.m32(), t.m33());
+    }
+};
+
+class Q_SVG_EXPORT QSvgFilterCache : public QSvgRasterCache<QSvgFilterCacheKey, QSvgPaintedRaster>
+{
+public:
+    QSvgFilterCache();
+
+    bool find(const QSvgNode *node, const QSvgFilterContainer *filter,
+              const QPainter *p, const QSvgExtraStates &states, QImage *image);
+    void insert(const QSvgNode *node, const QSvgFilterContainer *filter,
+                const QPainter *p, const QSvgExtraStates &states, const QImage &image);
+};
+
+struct QSvgMaskCacheKey
+{
+    const QSvgNode *mask;
+    QRectF localRect;
+    QTransform transform;
+    QRect deviceRect;
+
+    friend bool operator==(const QSvgMaskCacheKey &a, const QSvgMaskCacheKey &b) noexcept
+    {
+        return a.mask == b.mask && a.localRect == b.localRect && a.transform == b.transform
+                && a.deviceRect == b.deviceRect;
+    }
+    friend size_t qHash(const QSvgMaskCacheKey &key, size_t seed = 0) noexcept
+    {
+        const QTransform &t = key.transform;
+        const QRectF &r = key.localRect;
+        return qHashMulti(seed, key.mask, r.x(), r.y(), r.width(), r.height(),
+                          t.m11(), t.m12(), t.m13(), t.m21(), t.m22(), t.m23(),
+                          t.m31(), t.m32(), t.m33(), key.deviceRect.x(), key.deviceRect.y(),
+                          key.deviceRect.width(), key.deviceRect.height());
+    }
+};
+
+class Q_SVG_EXPORT QSvgMaskCache : public QSvgRasterCache<QSvgMaskCacheKey, QImage>
+{
+public:
+    QSvgMaskCache();
+
+    bool find(const QSvgNode *mask, const QRectF &localRect, const QTransform &transform,
+              const QRect &deviceRect, QImage *image);
+    void insert(const QSvgNode *mask, const QRectF &localRect, const QTransform &transform,
+                const QRect &deviceRect, const QImage &image);
+};
+
+struct QSvgMarkerCacheKey
+{
+    const QSvgNode *marker;
+    QTransform transform;
+    QSizeF size;
+    qreal opacity;
+
+    friend bool operator==(const QSvgMarkerCacheKey &a, const QSvgMarkerCacheKey &b) noexcept
+    {
+        return a.marker == b.marker && a.transform == b.transform && a.size == b.size
+                && a.opacity == b.opacity;
+    }
+    friend size_t qHash(const QSvgMarkerCacheKey &key, size_t seed = 0) noexcept
+    {
+        const QTransform &t = key.transform;
+        return qHashMulti(seed, key.marker, t.m11(), t.m12(), t.m21(), t.m22(),
+                          t.dx(), t.dy(), key.size.width(), key.size.height(), key.opacity);
+    }
+};
+
+class Q_SVG_EXPORT QSvgMarkerCache : public QSvgRasterCache<QSvgMarkerCacheKey, QSvgPaintedRaster>
+{
+public:
+    QSvgMarkerCache();
+
+    bool find(const QSvgNode *marker, const QTransform &transform, const QSizeF &size,
+              const QPainter *p, const QSvgExtraStates &states, QImage *image);
+    void insert(const QSvgNode *marker, const QTransform &transform, const QSizeF &size,
+                const QPainter *p, const QSvgExtraStates &states, const QImage &image);
+};
+
+struct QSvgPatternCacheKey
+{
+    const QSvgNode *pattern;
+    QSize size;
+    qint64 contentScaleX;
+    qint64 contentScaleY;
+
+    static QSvgPatternCacheKey create(const QSvgNode *pattern, const QSize &size,
+                                      qreal contentScaleX, qreal contentScaleY);
+
+    friend bool operator==(const QSvgPatternCacheKey &a, const QSvgPatternCacheKey &b) noexcept
+    {
+        return a.pattern == b.pattern && a.size == b.size
+                && a.contentScaleX == b.contentScaleX && a.contentScaleY == b.contentScaleY;
+    }
+    friend size_t qHash(const QSvgPatternCacheKey &key, size_t seed = 0) noexcept
+    {
+        return qHashMulti(seed, key.pattern, key.size.width(), key.size.height(),
+                          key.contentScaleX, key.contentScaleY);
+    }
+};
+
+class Q_SVG_EXPORT QSvgPatternCache : public QSvgRasterCache<QSvgPatternCacheKey, QImage>
+{
+public:
+    QSvgPatternCache();
+
+    bool find(const QSvgNode *pattern, const QSize &size, qreal contentScaleX, qreal contentScaleY,
+              QImage *image);
+    void insert(const QSvgNode *pattern, const QSize &size, qreal contentScaleX, qreal contentScaleY,
+                const QImage &image);
+
+protected:
+    bool isCacheableNode(const QSvgNode *pattern) const override;
+};
+
+struct QSvgStrokeCacheKey
+{
+    const QSvgNode *node;
+    qreal width;
+    QList<qreal> dashPattern;
+    qreal dashOffset;
+    Qt::PenCapStyle capStyle;
+    Qt::PenJoinStyle joinStyle;
+    qreal miterLimit;
+    int scaleStep;
+
+    static QSvgStrokeCacheKey create(const QSvgNode *node, const QPen &pen, int scaleStep);
+
+    friend bool operator==(const QSvgStrokeCacheKey &a, const QSvgStrokeCacheKey &b) noexcept
+    {
+        return a.node == b.node && a.width == b.width && a.dashPattern == b.dashPattern
+                && a.dashOffset == b.dashOffset && a.capStyle == b.capStyle
+                && a.joinStyle == b.joinStyle && a.miterLimit == b.miterLimit
+                && a.scaleStep == b.scaleStep;
+    }
+    friend size_t qHash(const QSvgStrokeCacheKey &key, size_t seed = 0) noexcept
+    {
+        seed = qHashRange(key.dashPattern.cbegin(), key.dashPattern.cend(), seed);
+        return qHashMulti(seed, key.node, key.width, key.dashOffset, int(key.capStyle),
+                          int(key.joinStyle), key.miterLimit, key.scaleStep);
+    }
+};
+
+struct QSvgStrokeOutline
+{
+    QPainterPath outline;
+    QRectF bounds;
+};
+
+class Q_SVG_EXPORT QSvgStrokeCache : public QSvgRasterCache<QSvgStrokeCacheKey, QSvgStrokeOutline>
+{
+public:
+    QSvgStrokeCache();
+
+    bool find(const QSvgNode *node, const QPen &pen, int scaleStep,
+              QPainterPath *outline, QRectF *bounds);
+    void insert(const QSvgNode *node, const QPen &pen, int scaleStep,
+                const QPainterPath &outline, const QRectF &bounds);
+};
+
+struct QSvgUseCacheKey
+{
+    const QSvgNode *link;
+    QTransform transform;
+    qreal opacity;
+    size_t paintKey;
+
+    static QSvgUseCacheKey create(const QSvgNode *link, const QTransform &transform,
+                                  const QPainter *p, const QSvgPaintState &state);
+
+    friend bool operator==(const QSvgUseCacheKey &a, const QSvgUseCacheKey &b) noexcept
+    {
+        return a.link == b.link && a.transform == b.transform && a.opacity == b.opacity
+                && a.paintKey == b.paintKey;
+    }
+    friend size_t qHash(const QSvgUseCacheKey &key, size_t seed = 0) noexcept
+    {
+        const QTransform &t = key.transform;
+        return qHashMulti(seed, key.link, t.m11(), t.m12(), t.m21(), t.m22(),
+                          t.dx(), t.dy(), key.opacity, key.paintKey);
+    }
+};
+
+class Q_SVG_EXPORT QSvgUseCache : public QSvgRasterCache<QSvgUseCacheKey, QSvgPaintedRaster>
+{
+public:
+    explicit QSvgUseCache(bool enabled = false);
+
+    bool find(const QSvgNode *link, const QTransform &transform, const QPainter *p,
+              const QSvgExtraStates &states, QImage *image);
+    void insert(const QSvgNode *link, const QTransform &transform, const QPainter *p,
+                const QSvgExtraStates &states, const QImage &image);
+    void endFrame();
+
+private:
+    qint64 m_reportedHits = 0;
+    qint64 m_reportedMisses = 0;
+};
+
+class Q_SVG_EXPORT QSvgScratchBufferPool : public QSvgCacheBase
+{
+public:
+    QSvgScratchBufferPool();
+
+    // Buffers are released when the pool was not used for this long, in ms
+    static constexpr int IdleTimeout = 2000;
+
+    bool allocate(const QSize &size, QImage *image);
+    void recycle(QImage &&image);
+    void endFrame();
+    int releaseIdle(int timeout = IdleTimeout);
+
+private:
+    struct Entry
+    {
+        QImage image;
+        quint64 frame;
+    };
+
+    static quint64 bucketKey(const QSize &size)
+    {
+        return (quint64(uint(size.width())) << 32) | uint(size.height());
+    }
+
+    void setMaxCostLocked(qsizetype kilobytes) override;
+    qsizetype totalCostLocked() const override;
+    void clearLocked() override;
+
+    QHash<quint64, QList<Entry>> m_buckets;
+    qsizetype m_bytes = 0;
+    quint64 m_frame = 0;
+    QElapsedTimer m_lastUse;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSVGCACHES_P_H
@@ -9,11 +9,159 @@
 #include "qpainter.h"
 
 #include <QLoggingCategory>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qvarlengtharray.h>
 #include <QtGui/qimageiohandler.h>
 #include <QVector4D>
 
+#include <QtCore/private/qsimd_p.h>
+#include <QtGui/private/qguiapplication_p.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+
 QT_BEGIN_NAMESPACE
 
+/*!
+    \internal
+    \class QSvgFilterBuffer
+
+    The value of one filter result: either an image placed at a position in
+    device coordinates, or a rectangle of a constant color that is only
+    turned into pixels when a primitive needs them. Moving a result is a
+    change of its position and does not touch the pixels.
+*/
+
+QSvgFilterBuffer::QSvgFilterBuffer(const QImage &image)
+    : m_image(image)
+    , m_rect(image.offset(), image.size())
+{
+}
+
+QSvgFilterBuffer QSvgFilterBuffer::flood(const QRect &rect, const QColor &color)
+{
+    QSvgFilterBuffer buffer;
+    buffer.m_rect = rect;
+    buffer.m_color = color;
+    buffer.m_flood = true;
+    return buffer;
+}
+
+bool QSvgFilterBuffer::isNull() const
+{
+    return m_flood ? m_rect.isEmpty() : m_image.isNull();
+}
+
+/*!
+    \internal
+
+    Returns the pixels of this result. Their top left corner is at offset(),
+    the offset of the returned image itself is not meaningful.
+*/
+QImage QSvgFilterBuffer::image() const
+{
+    if (!m_flood)
+        return m_image;
+
+    QImage image;
+    if (!QImageIOHandler::allocateImage(m_rect.size(), QImage::Format_ARGB32_Premultiplied, &image)) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return image;
+    }
+    image.fill(m_color);
+    return image;
+}
+
+/*!
+    \internal
+
+    Returns the pixels of this result as an image with its offset set.
+*/
+QImage QSvgFilterBuffer::toImage() const
+{
+    QImage image = this->image();
+    if (!image.isNull() && image.offset() != offset())
+        image.setOffset(offset());
+    return image;
+}
+
+/*!
+    \internal
+
+    Draws this result with \a p, whose device origin is at \a origin in the
+    coordinates of this result.
+*/
+void QSvgFilterBuffer::draw(QPainter *p, const QPoint &origin) const
+{
+    if (m_flood)
+        p->fillRect(m_rect.translated(-origin), m_color);
+    else if (!m_image.isNull())
+        p->drawImage(offset() - origin, m_image);
+}
+
+void QSvgFilterBuffer::translate(const QPoint &delta)
+{
+    m_rect.translate(delta);
+}
+
+/*!
+    \internal
+    \class QSvgFilterBufferPool
+
+    Keeps the images of filter results that are no longer needed during one
+    application of a filter, so that later primitives can reuse them instead
+    of allocating new ones. Images are only reused for the exact same size,
+    and their contents are undefined.
+*/
+
+bool QSvgFilterBufferPool::allocate(const QSize &size, QImage *image)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        for (qsizetype i = 0; i < m_free.size(); ++i) {
+            if (m_free.at(i).size() == size) {
+                *image = m_free.takeAt(i);
+                image->setOffset(QPoint());
+                return true;
+            }
+        }
+    }
+    return QImageIOHandler::allocateImage(size, QImage::Format_ARGB32_Premultiplied, image);
+}
+
+/*!
+    \internal
+
+    Takes \a image for later reuse, unless its pixels are still shared with
+    another image.
+*/
+void QSvgFilterBufferPool::recycle(QImage &&image)
+{
+    if (image.isNull() || !image.isDetached()
+        || image.format() != QImage::Format_ARGB32_Premultiplied) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_free.append(std::move(image));
+}
+
+/*!
+    \internal
+
+    Returns the part of \a rect that lies in the region being evaluated.
+    When a filter is evaluated in tiles, this is the tile and the margin
+    around it that later primitives read; otherwise the region is null and
+    \a rect is returned unchanged.
+*/
+QRect QSvgFilterBufferPool::clipToRegion(const QRect &rect) const
+{
+    return m_region.isNull() ? rect : rect.intersected(m_region);
+}
+
 QSvgFeFilterPrimitive::QSvgFeFilterPrimitive(QSvgNode *parent, const QString &input,
                                              const QString &result, const QSvgRectF &rect)
     : QSvgStructureNode(parent)
@@ -74,9 +222,48 @@ void QSvgFeFilterPrimitive::clipToTransformedBounds(QImage *buffer, QPainter *p,
     painter.fillPath(clipPath, Qt::transparent);
 }
 
-bool QSvgFeFilterPrimitive::requiresSourceAlpha() const
+/*!
+    \internal
+
+    Returns the names of the results this primitive reads, in the order in
+    which apply() receives them.
+*/
+QStringList QSvgFeFilterPrimitive::inputs() const
+{
+    return { m_input };
+}
+
+/*!
+    \internal
+
+    Lets a primitive produce \a output without rendering into a buffer of its
+    own, for example by referring to an input at a different position. Returns
+    \c false if the primitive has to be applied with apply() instead.
+*/
+bool QSvgFeFilterPrimitive::applyWithoutBuffer(const QSvgFilterInputs &, QPainter *,
+                                               const QRectF &, const QRectF &,
+                                               QtSvg::UnitTypes, QtSvg::UnitTypes,
+                                               QSvgFilterBuffer *) const
+{
+    return false;
+}
+
+/*!
+    \internal
+
+    Returns how far, in device pixels, the pixels this primitive reads extend
+    beyond the pixel they produce, in each direction. A pixel at x reads
+    inputs from x - left to x + right.
+*/
+QMargins QSvgFeFilterPrimitive::footprint(QPainter *, const QRectF &, QtSvg::UnitTypes) const
+{
+    return QMargins();
+}
+
+bool QSvgFeFilterPrimitive::hasDefaultSubRegion() const
 {
-    return m_input == QLatin1StringView("SourceAlpha");
+    return m_rect.unitX() == QtSvg::UnitTypes::unknown && m_rect.unitY() == QtSvg::UnitTypes::unknown
+        && m_rect.unitW() == QtSvg::UnitTypes::unknown && m_rect.unitH() == QtSvg::UnitTypes::unknown;
 }
 
 const QSvgFeFilterPrimitive *QSvgFeFilterPrimitive::castToFilterPrimitive(const QSvgNode *node)
@@ -87,7 +274,12 @@ const QSvgFeFilterPrimitive *QSvgFeFilterPrimitive::castToFilterPrimitive(const
         node->type() == QSvgNode::FeOffset ||
         node->type() == QSvgNode::FeComposite ||
         node->type() == QSvgNode::FeFlood ||
-        node->type() == QSvgNode::FeBlend ) {
+        node->type() == QSvgNode::FeBlend ||
+        node->type() == QSvgNode::FeConvolvematrix ||
+        node->type() == QSvgNode::FeMorphology ||
+        node->type() == QSvgNode::FeTurbulence ||
+        node->type() == QSvgNode::FeComponenttransfer ||
+        node->type() == QSvgNode::FeDropshadow ) {
         return reinterpret_cast<const QSvgFeFilterPrimitive*>(node);
     } else {
         return nullptr;
@@ -188,6 +380,57 @@ QSvgFeColorMatrix::QSvgFeColorMatrix(QSvgNode *parent, const QString &input, con
         m_matrix.data()[1+3*5] = 0.7154;
         m_matrix.data()[2+3*5] = 0.0721;
     }
+
+    prepareKernel();
+}
+
+/*!
+    \internal
+
+    Converts the matrix to single precision, with the offsets scaled to the
+    0-255 range of the pixels, and picks the cheapest kernel that evaluates
+    it: a copy for the identity, a kernel on premultiplied color for
+    matrices that only mix the color channels, as generated by saturate and
+    hueRotate, and an alpha-only kernel for luminanceToAlpha.
+*/
+void QSvgFeColorMatrix::prepareKernel()
+{
+    const qreal *m = m_matrix.constData();
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 5; ++column)
+            m_coefficients[5 * row + column] = float(m[column + row * 5] * (column == 4 ? 255. : 1.));
+    }
+
+    // Below 1/4096 a coefficient cannot change an 8-bit channel
+    auto isZero = [&](int row, int column) {
+        return qAbs(m[column + row * 5]) < 1. / 4096;
+    };
+    auto isUnitRow = [&](int row) {
+        for (int column = 0; column < 5; ++column) {
+            if (column == row ? qAbs(m[column + row * 5] - 1.) >= 1. / 4096 : !isZero(row, column))
+                return false;
+        }
+        return true;
+    };
+
+    bool colorOnly = isUnitRow(3);
+    bool identity = colorOnly;
+    bool alphaOnly = true;
+    for (int row = 0; row < 3; ++row) {
+        identity = identity && isUnitRow(row);
+        colorOnly = colorOnly && isZero(row, 3) && isZero(row, 4);
+        for (int column = 0; column < 5; ++column)
+            alphaOnly = alphaOnly && isZero(row, column);
+    }
+
+    if (identity)
+        m_kernel = Kernel::Identity;
+    else if (colorOnly)
+        m_kernel = Kernel::Rgb;
+    else if (alphaOnly)
+        m_kernel = Kernel::LuminanceToAlpha;
+    else
+        m_kernel = Kernel::General;
 }
 
 QSvgNode::Type QSvgFeColorMatrix::type() const
@@ -195,20 +438,226 @@ QSvgNode::Type QSvgFeColorMatrix::type() const
     return QSvgNode::FeColormatrix;
 }
 
-QImage QSvgFeColorMatrix::apply(const QMap<QString, QImage> &sources, QPainter *p,
+namespace {
+
+// Runs function(begin, end) over row segments [0, height) on the Qt GUI thread
+// pool, the same way QImage conversions split their work.
+template <typename Function>
+void runSegmented(int height, qsizetype pixelCount, Function &&function)
+{
+#if QT_CONFIG(thread) && !defined(Q_OS_WASM)
+    const int segments = int(qMin<qsizetype>(pixelCount >> 16, height));
+    QThreadPool *threadPool = QGuiApplicationPrivate::qtGuiThreadPool();
+    if (segments > 1 && threadPool && !threadPool->contains(QThread::currentThread())) {
+        QSemaphore semaphore;
+        int y = 0;
+        for (int i = 0; i < segments; ++i) {
+            const int yn = (height - y) / (segments - i);
+            threadPool->start([&, y, yn]() {
+                function(y, y + yn);
+                semaphore.release(1);
+            });
+            y += yn;
+        }
+        semaphore.acquire(segments);
+        return;
+    }
+#endif
+    function(0, height);
+}
+
+enum class ColorMatrixMode {
+    Rgb,                // color rows only, alpha is kept: works on premultiplied color
+    LuminanceToAlpha,   // color rows are zero: only alpha is computed
+    General
+};
+
+// Channels are never negative and rounded half up, as storePixels() does
+inline int roundChannel(float v)
+{
+    return int(v + 0.5f);
+}
+
+// One premultiplied pixel through the row-major 4x5 matrix m, whose offsets
+// are in the 0-255 range.
+template <ColorMatrixMode Mode>
+QRgb colorMatrixPixel(const float *m, QRgb pixel)
+{
+    float r = qRed(pixel);
+    float g = qGreen(pixel);
+    float b = qBlue(pixel);
+    const float a = qAlpha(pixel);
+
+    if constexpr (Mode == ColorMatrixMode::Rgb) {
+        auto channel = [&](const float *row) {
+            return roundChannel(qBound(0.f, row[0] * r + row[1] * g + row[2] * b, a));
+        };
+        return qRgba(channel(m), channel(m + 5), channel(m + 10), qAlpha(pixel));
+    } else {
+        const float reciprocal = a > 0 ? 255.f / a : 0.f;
+        r *= reciprocal;
+        g *= reciprocal;
+        b *= reciprocal;
+        auto channel = [&](const float *row) {
+            return qBound(0.f, row[0] * r + row[1] * g + row[2] * b + row[3] * a + row[4], 255.f);
+        };
+        const float alpha = channel(m + 15);
+        if constexpr (Mode == ColorMatrixMode::LuminanceToAlpha)
+            return qRgba(0, 0, 0, roundChannel(alpha));
+
+        const float scale = alpha * (1.f / 255);
+        return qRgba(roundChannel(channel(m) * scale), roundChannel(channel(m + 5) * scale),
+                     roundChannel(channel(m + 10) * scale), roundChannel(alpha));
+    }
+}
+
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+#  if defined(__SSE2__)
+using Float4 = __m128;
+
+inline Float4 splat(float v) { return _mm_set1_ps(v); }
+inline Float4 add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 bound(Float4 lo, Float4 v, Float4 hi) { return _mm_min_ps(_mm_max_ps(v, lo), hi); }
+
+// 255 / a, and 0 where a is 0
+inline Float4 reciprocal255(Float4 a)
+{
+    return _mm_and_ps(_mm_div_ps(_mm_set1_ps(255.f), a), _mm_cmpgt_ps(a, _mm_setzero_ps()));
+}
+
+inline void loadPixels(const QRgb *src, Float4 *r, Float4 *g, Float4 *b, Float4 *a)
+{
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    const __m128i mask = _mm_set1_epi32(0xff);
+    *r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), mask));
+    *g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), mask));
+    *b = _mm_cvtepi32_ps(_mm_and_si128(pixels, mask));
+    *a = _mm_cvtepi32_ps(_mm_srli_epi32(pixels, 24));
+}
+
+// Rounds half up like roundChannel(), not to even like _mm_cvtps_epi32
+inline void storePixels(QRgb *dst, Float4 r, Float4 g, Float4 b, Float4 a)
+{
+    const Float4 half = _mm_set1_ps(0.5f);
+    __m128i pixels = _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(a, half)), 24);
+    pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(r, half)), 16));
+    pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(g, half)), 8));
+    pixels = _mm_or_si128(pixels, _mm_cvttps_epi32(_mm_add_ps(b, half)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), pixels);
+}
+#  else
+using Float4 = float32x4_t;
+
+inline Float4 splat(float v) { return vdupq_n_f32(v); }
+inline Float4 add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 bound(Float4 lo, Float4 v, Float4 hi) { return vminq_f32(vmaxq_f32(v, lo), hi); }
+
+inline Float4 reciprocal255(Float4 a)
+{
+    Float4 reciprocal = vrecpeq_f32(a);
+    reciprocal = vmulq_f32(vrecpsq_f32(a, reciprocal), reciprocal);
+    reciprocal = vmulq_f32(vrecpsq_f32(a, reciprocal), reciprocal);
+    const uint32x4_t nonZero = vcgtq_f32(a, vdupq_n_f32(0.f));
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_n_f32(reciprocal, 255.f)),
+                                           nonZero));
+}
+
+inline void loadPixels(const QRgb *src, Float4 *r, Float4 *g, Float4 *b, Float4 *a)
+{
+    const uint32x4_t pixels = vld1q_u32(src);
+    const uint32x4_t mask = vdupq_n_u32(0xff);
+    *r = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(pixels, 16), mask));
+    *g = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(pixels, 8), mask));
+    *b = vcvtq_f32_u32(vandq_u32(pixels, mask));
+    *a = vcvtq_f32_u32(vshrq_n_u32(pixels, 24));
+}
+
+inline void storePixels(QRgb *dst, Float4 r, Float4 g, Float4 b, Float4 a)
+{
+    const Float4 half = vdupq_n_f32(0.5f);
+    uint32x4_t pixels = vshlq_n_u32(vcvtq_u32_f32(vaddq_f32(a, half)), 24);
+    pixels = vorrq_u32(pixels, vshlq_n_u32(vcvtq_u32_f32(vaddq_f32(r, half)), 16));
+    pixels = vorrq_u32(pixels, vshlq_n_u32(vcvtq_u32_f32(vaddq_f32(g, half)), 8));
+    pixels = vorrq_u32(pixels, vcvtq_u32_f32(vaddq_f32(b, half)));
+    vst1q_u32(dst, pixels);
+}
+#  endif
+
+// Four pixels per iteration, channels in separate vectors
+template <ColorMatrixMode Mode>
+int colorMatrixSpanSimd(const float *m, const QRgb *src, QRgb *dst, int count)
+{
+    Float4 row[20];
+    for (int i = 0; i < 20; ++i)
+        row[i] = splat(m[i]);
+    const Float4 zero = splat(0.f);
+    const Float4 max = splat(255.f);
+    const Float4 inverse255 = splat(1.f / 255);
+
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        Float4 r, g, b, a;
+        loadPixels(src + x, &r, &g, &b, &a);
+
+        if constexpr (Mode == ColorMatrixMode::Rgb) {
+            auto channel = [&](const Float4 *c) {
+                return bound(zero, add(add(mul(c[0], r), mul(c[1], g)), mul(c[2], b)), a);
+            };
+            storePixels(dst + x, channel(row), channel(row + 5), channel(row + 10), a);
+        } else {
+            const Float4 reciprocal = reciprocal255(a);
+            r = mul(r, reciprocal);
+            g = mul(g, reciprocal);
+            b = mul(b, reciprocal);
+            auto channel = [&](const Float4 *c) {
+                const Float4 color = add(add(mul(c[0], r), mul(c[1], g)), mul(c[2], b));
+                return bound(zero, add(color, add(mul(c[3], a), c[4])), max);
+            };
+            const Float4 alpha = channel(row + 15);
+            if constexpr (Mode == ColorMatrixMode::LuminanceToAlpha) {
+                storePixels(dst + x, zero, zero, zero, alpha);
+            } else {
+                const Float4 scale = mul(alpha, inverse255);
+                storePixels(dst + x, mul(channel(row), scale), mul(channel(row + 5), scale),
+                            mul(channel(row + 10), scale), alpha);
+            }
+        }
+    }
+    return x;
+}
+#endif
+
+template <ColorMatrixMode Mode>
+void colorMatrixSpan(const float *m, const QRgb *src, QRgb *dst, int count)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+    x = colorMatrixSpanSimd<Mode>(m, src, dst, count);
+#endif
+    for (; x < count; ++x)
+        dst[x] = colorMatrixPixel<Mode>(m, src[x]);
+}
+
+} // anonymous namespace
+
+QImage QSvgFeColorMatrix::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
                                 const QRectF &itemBounds, const QRectF &filterBounds,
                                 QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
 {
-    if (!sources.contains(m_input))
+    if (inputs.value(0).isNull())
         return QImage();
-    QImage source = sources[m_input];
+    const QImage source = inputs.at(0).image();
+    const QPoint sourceOffset = inputs.at(0).offset();
 
     QRect clipRectGlob = globalSubRegion(p, itemBounds, filterBounds, primitiveUnits, filterUnits).toRect();
+    clipRectGlob = pool->clipToRegion(clipRectGlob);
     if (clipRectGlob.isEmpty())
         return QImage();
 
     QImage result;
-    if (!QImageIOHandler::allocateImage(clipRectGlob.size(), QImage::Format_ARGB32_Premultiplied, &result)) {
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
         qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
         return QImage();
     }
@@ -217,60 +666,380 @@ QImage QSvgFeColorMatrix::apply(const QMap<QString, QImage> &sources, QPainter *
 
     Q_ASSERT(source.depth() == 32);
 
-    for (int i = 0; i < result.height(); i++) {
-        int sourceI = i - source.offset().y() + result.offset().y();
+    // Pixels outside of the input stay transparent
+    const QRect span = QRect(sourceOffset, source.size()).intersected(clipRectGlob);
+    if (!span.isEmpty()) {
+        const qsizetype sourceBytesPerLine = source.bytesPerLine();
+        const qsizetype resultBytesPerLine = result.bytesPerLine();
+        const uchar *sourceBits = source.constBits() + (span.top() - sourceOffset.y()) * sourceBytesPerLine
+                + (span.left() - sourceOffset.x()) * sizeof(QRgb);
+        uchar *resultBits = result.bits() + (span.top() - clipRectGlob.top()) * resultBytesPerLine
+                + (span.left() - clipRectGlob.left()) * sizeof(QRgb);
+        const int width = span.width();
+        const float *m = m_coefficients.data();
+
+        runSegmented(span.height(), qsizetype(width) * span.height(), [&](int y0, int y1) {
+            for (int y = y0; y < y1; ++y) {
+                const QRgb *src = reinterpret_cast<const QRgb *>(sourceBits + y * sourceBytesPerLine);
+                QRgb *dst = reinterpret_cast<QRgb *>(resultBits + y * resultBytesPerLine);
+                switch (m_kernel) {
+                case Kernel::Identity:
+                    memcpy(dst, src, width * sizeof(QRgb));
+                    break;
+                case Kernel::Rgb:
+                    colorMatrixSpan<ColorMatrixMode::Rgb>(m, src, dst, width);
+                    break;
+                case Kernel::LuminanceToAlpha:
+                    colorMatrixSpan<ColorMatrixMode::LuminanceToAlpha>(m, src, dst, width);
+                    break;
+                case Kernel::General:
+                    colorMatrixSpan<ColorMatrixMode::General>(m, src, dst, width);
+                    break;
+                }
+            }
+        });
+    }
 
-        if (sourceI < 0 || sourceI >= source.height())
-            continue;
+    clipToTransformedBounds(&result, p, localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits));
+    return result;
+}
 
-        QRgb *sourceLine = reinterpret_cast<QRgb *>(source.scanLine(sourceI));
-        QRgb *resultLine = reinterpret_cast<QRgb *>(result.scanLine(i));
+/*!
+    \internal
 
-        for (int j = 0; j < result.width(); j++) {
-            int sourceJ = j - source.offset().x() + result.offset().x();
+    Passes the input on unchanged for an identity matrix, and maps the color
+    of a flood input without turning it into pixels.
+*/
+bool QSvgFeColorMatrix::applyWithoutBuffer(const QSvgFilterInputs &inputs, QPainter *p,
+                                           const QRectF &, const QRectF &,
+                                           QtSvg::UnitTypes, QtSvg::UnitTypes,
+                                           QSvgFilterBuffer *output) const
+{
+    if (!hasDefaultSubRegion() || p->transform().type() > QTransform::TxScale)
+        return false;
 
-            if (sourceJ < 0 || sourceJ >= source.width())
-                continue;
+    const QSvgFilterBuffer input = inputs.value(0);
+    if (m_kernel == Kernel::Identity || input.isNull()) {
+        *output = input;
+        return true;
+    }
+    if (!input.isFlood())
+        return false;
+
+    const QRgb color = qPremultiply(input.floodColor().rgba());
+    QRgb mapped;
+    switch (m_kernel) {
+    case Kernel::Rgb:
+        mapped = colorMatrixPixel<ColorMatrixMode::Rgb>(m_coefficients.data(), color);
+        break;
+    case Kernel::LuminanceToAlpha:
+        mapped = colorMatrixPixel<ColorMatrixMode::LuminanceToAlpha>(m_coefficients.data(), color);
+        break;
+    default:
+        mapped = colorMatrixPixel<ColorMatrixMode::General>(m_coefficients.data(), color);
+        break;
+    }
+    *output = QSvgFilterBuffer::flood(input.rect(), QColor::fromRgba(qUnpremultiply(mapped)));
+    return true;
+}
 
-            QRgb sourceColor = qUnpremultiply(sourceLine[sourceJ]);
-            qreal a = qAlpha(sourceColor);
-            qreal r = qRed(sourceColor);
-            qreal g = qGreen(sourceColor);
-            qreal b = qBlue(sourceColor);
-
-            qreal r2 = m_matrix.data()[0+0*5] * r +
-                       m_matrix.data()[1+0*5] * g +
-                       m_matrix.data()[2+0*5] * b +
-                       m_matrix.data()[3+0*5] * a +
-                       m_matrix.data()[4+0*5] * 255.;
-            qreal g2 = m_matrix.data()[0+1*5] * r +
-                       m_matrix.data()[1+1*5] * g +
-                       m_matrix.data()[2+1*5] * b +
-                       m_matrix.data()[3+1*5] * a +
-                       m_matrix.data()[4+1*5] * 255.;
-            qreal b2 = m_matrix.data()[0+2*5] * r +
-                       m_matrix.data()[1+2*5] * g +
-                       m_matrix.data()[2+2*5] * b +
-                       m_matrix.data()[3+2*5] * a +
-                       m_matrix.data()[4+2*5] * 255.;
-            qreal a2 = m_matrix.data()[0+3*5] * r +
-                       m_matrix.data()[1+3*5] * g +
-                       m_matrix.data()[2+3*5] * b +
-                       m_matrix.data()[3+3*5] * a +
-                       m_matrix.data()[4+3*5] * 255.;
-
-            QRgb rgba = qRgba(qBound(0, int(r2), 255),
-                              qBound(0, int(g2), 255),
-                              qBound(0, int(b2), 255),
-                              qBound(0, int(a2), 255));
-            resultLine[j] = qPremultiply(rgba);
+namespace {
+
+struct BoxBlurPass
+{
+    int left;
+    int right;
+    int top;
+    int bottom;
+};
+
+// Window sums of one row, four channels per pixel: sums[4 * x + c] is the sum
+// of channel c over the pixels (max(0, x - left), min(width - 1, x + right)].
+// As in the summed-area formulation this replaces, the window bounds are
+// clamped to the row and its lower bound is exclusive.
+void boxBlurRowSums(const QRgb *line, int width, int left, int right,
+                    quint32 *prefix, quint32 *sums)
+{
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for (int x = 0; x < width; ++x) {
+        __m128i pixel = _mm_cvtsi32_si128(int(line[x]));
+        pixel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(pixel, zero), zero);
+        sum = _mm_add_epi32(sum, pixel);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(prefix + 4 * x), sum);
+    }
+    for (int x = 0; x < width; ++x) {
+        const int lo = qMax(0, x - left);
+        const int hi = qMin(width - 1, x + right);
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prefix + 4 * hi));
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prefix + 4 * lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + 4 * x), _mm_sub_epi32(high, low));
+    }
+#elif defined(__ARM_NEON__)
+    uint32x4_t sum = vdupq_n_u32(0);
+    for (int x = 0; x < width; ++x) {
+        const uint16x8_t pixel = vmovl_u8(vcreate_u8(line[x]));
+        sum = vaddq_u32(sum, vmovl_u16(vget_low_u16(pixel)));
+        vst1q_u32(prefix + 4 * x, sum);
+    }
+    for (int x = 0; x < width; ++x) {
+        const int lo = qMax(0, x - left);
+        const int hi = qMin(width - 1, x + right);
+        vst1q_u32(sums + 4 * x, vsubq_u32(vld1q_u32(prefix + 4 * hi), vld1q_u32(prefix + 4 * lo)));
+    }
+#else
+    quint32 sum[4] = {};
+    for (int x = 0; x < width; ++x) {
+        for (int c = 0; c < 4; ++c) {
+            sum[c] += (line[x] >> (8 * c)) & 0xff;
+            prefix[4 * x + c] = sum[c];
         }
     }
+    for (int x = 0; x < width; ++x) {
+        const int lo = qMax(0, x - left);
+        const int hi = qMin(width - 1, x + right);
+        for (int c = 0; c < 4; ++c)
+            sums[4 * x + c] = prefix[4 * hi + c] - prefix[4 * lo + c];
+    }
+#endif
+}
 
-    clipToTransformedBounds(&result, p, localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits));
-    return result;
+// The same for a row of alpha values, one channel per pixel
+void boxBlurRowSums(const uchar *line, int width, int left, int right,
+                    quint32 *prefix, quint32 *sums)
+{
+    quint32 sum = 0;
+    for (int x = 0; x < width; ++x) {
+        sum += line[x];
+        prefix[x] = sum;
+    }
+    for (int x = 0; x < width; ++x)
+        sums[x] = prefix[qMin(width - 1, x + right)] - prefix[qMax(0, x - left)];
+}
+
+// One box blur of the three that approximate the Gaussian. The horizontal
+// window sums of a row are accumulated into a running vertical window that
+// moves down one row at a time, so the image is only ever walked row by row.
+// Each channel is the exact integer window sum divided by the full box area,
+// rounded down, which makes the result identical to a 2D box sum.
+struct BoxBlurImage
+{
+    const uchar *source;
+    qsizetype sourceBytesPerLine;
+    uchar *target;
+    qsizetype targetBytesPerLine;
+    int width;
+    int height;
+};
+
+template <typename Accumulator, int Channels>
+void boxBlurSegment(const BoxBlurImage &image, const BoxBlurPass &pass, int y0, int y1)
+{
+    static_assert(Channels == 1 || Channels == 4);
+    using Pixel = std::conditional_t<Channels == 4, QRgb, uchar>;
+    const int width = image.width;
+    const int height = image.height;
+    const quint64 area = quint64(pass.left + pass.right) * quint64(pass.top + pass.bottom);
+    const bool useReciprocal = area < (1u << 20);
+    const double reciprocal = 1.0 / double(area);
+
+    // The row sums of the rows in the vertical window are kept in a ring, so
+    // that a row leaving the window is subtracted without summing it again
+    const int ringRows = qMin(pass.top + pass.bottom, height);
+    const qsizetype rowLength = qsizetype(Channels) * width;
+    QVarLengthArray<quint32, 4 * 256> prefix(rowLength);
+    QVarLengthArray<quint32, 4 * 256> ring(rowLength * ringRows);
+    QVarLengthArray<Accumulator, 4 * 256> window(rowLength);
+    std::fill(window.begin(), window.end(), Accumulator(0));
+
+    auto ringRow = [&](int y) {
+        return ring.data() + rowLength * (y % ringRows);
+    };
+    auto addRow = [&](int y) {
+        quint32 *sums = ringRow(y);
+        boxBlurRowSums(reinterpret_cast<const Pixel *>(image.source + y * image.sourceBytesPerLine), width,
+                       pass.left, pass.right, prefix.data(), sums);
+        for (qsizetype i = 0; i < rowLength; ++i)
+            window[i] += sums[i];
+    };
+    auto removeRow = [&](int y) {
+        const quint32 *sums = ringRow(y);
+        for (qsizetype i = 0; i < rowLength; ++i)
+            window[i] -= sums[i];
+    };
+
+    int top = qMax(0, y0 - pass.top);
+    int bottom = qMin(height - 1, y0 + pass.bottom);
+    for (int y = top + 1; y <= bottom; ++y)
+        addRow(y);
+
+    for (int y = y0; y < y1; ++y) {
+        Pixel *line = reinterpret_cast<Pixel *>(image.target + y * image.targetBytesPerLine);
+        for (int x = 0; x < width; ++x) {
+            const Accumulator *sum = window.constData() + Channels * x;
+            Pixel pixel = 0;
+            for (int c = 0; c < Channels; ++c) {
+                // (sum + 0.5) / area lies strictly between two integers, far
+                // enough from both for the double product to round down exactly
+                const uint value = useReciprocal ? uint((double(sum[c]) + 0.5) * reciprocal)
+                                                 : uint(sum[c] / area);
+                pixel |= value << (8 * c);
+            }
+            line[x] = pixel;
+        }
+
+        if (y + 1 == y1)
+            break;
+        const int nextTop = qMax(0, y + 1 - pass.top);
+        const int nextBottom = qMin(height - 1, y + 1 + pass.bottom);
+        // Rows leave the window before new ones take their place in the ring
+        for (int row = top + 1; row <= nextTop; ++row)
+            removeRow(row);
+        for (int row = bottom + 1; row <= nextBottom; ++row)
+            addRow(row);
+        top = nextTop;
+        bottom = nextBottom;
+    }
+}
+
+// Blurs premultiplied 32-bit images, or Format_Alpha8 ones
+template <int Channels>
+void boxBlur(const QImage &source, QImage *target, const BoxBlurPass &pass)
+{
+    // Resolve the pointers up front, the segments must not detach the images
+    const BoxBlurImage image = { source.constBits(), source.bytesPerLine(),
+                                 target->bits(), target->bytesPerLine(),
+                                 source.width(), source.height() };
+    const quint64 area = quint64(pass.left + pass.right) * quint64(pass.top + pass.bottom);
+    const bool fits32 = area * 255 <= std::numeric_limits<quint32>::max();
+    runSegmented(image.height, qsizetype(image.width) * image.height * Channels / 4, [&](int y0, int y1) {
+        if (fits32)
+            boxBlurSegment<quint32, Channels>(image, pass, y0, y1);
+        else
+            boxBlurSegment<quint64, Channels>(image, pass, y0, y1);
+    });
+}
+
+void boxBlur(const QImage &source, QImage *target, const BoxBlurPass &pass)
+{
+    Q_ASSERT(source.format() == target->format());
+    if (source.format() == QImage::Format_Alpha8)
+        boxBlur<1>(source, target, pass);
+    else
+        boxBlur<4>(source, target, pass);
 }
 
+// Three successive box blurs build a piece-wise quadratic convolution kernel,
+// which approximates the Gaussian kernel of the deviations sigmaX and sigmaY,
+// see https://www.w3.org/TR/SVG11/filters.html#feGaussianBlurElement. The
+// result ends up in image, and scratch, of the same size and format, holds
+// the intermediate passes.
+void gaussianBoxBlur(QImage *image, QImage *scratch, qreal sigmaX, qreal sigmaY)
+{
+    constexpr double sd = 3. * M_SQRT1_2 / M_2_SQRTPI; // 3 * sqrt(2 * pi) / 4
+    const int dx = floor(sigmaX * sd + 0.5);
+    const int dy = floor(sigmaY * sd + 0.5);
+
+    for (int m = 0; m < 3; m++) {
+        // If d is odd, use three box-blurs of size 'd', centered on the output pixel.
+        // If d is even, two box-blurs of size 'd' (the first one centered on the pixel
+        // boundary between the output pixel and the one to the left, the second one
+        // centered on the pixel boundary between the output pixel and the one to the
+        // right) and one box blur of size 'd+1' centered on the output pixel.
+        auto adjustD = [](int d, int iteration) {
+            d = qMax(1, d);     // Treat d == 0 just like d == 1
+            std::pair<int, int> result;
+            if (d % 2 == 1)
+                result = {d / 2 + 1, d / 2};
+            else if (iteration == 0)
+                result = {d / 2 + 1, d / 2 - 1};
+            else if (iteration == 1)
+                result = {d / 2, d / 2};
+            else
+                result = {d / 2 + 1, d / 2};
+            Q_ASSERT(result.first + result.second > 0);
+            return result;
+        };
+
+        const auto [dxleft, dxright] = adjustD(dx, m);
+        const auto [dytop, dybottom] = adjustD(dy, m);
+        boxBlur(*image, scratch, { dxleft, dxright, dytop, dybottom });
+        image->swap(*scratch);
+    }
+}
+
+// The margins around the origin that extent, a rectangle around it, covers
+// once mapped by the linear part of xf, and slack pixels more on each side.
+QMargins deviceMargins(const QTransform &xf, const QRectF &extent, int slack)
+{
+    const QTransform linear(xf.m11(), xf.m12(), xf.m21(), xf.m22(), 0, 0);
+    const QRectF mapped = linear.mapRect(extent);
+    return QMargins(qMax(0, qCeil(-mapped.left())) + slack, qMax(0, qCeil(-mapped.top())) + slack,
+                    qMax(0, qCeil(mapped.right())) + slack, qMax(0, qCeil(mapped.bottom())) + slack);
+}
+
+constexpr qreal BlurDownsampleThreshold = 8;
+constexpr int MaxBlurDownsampleFactor = 16;
+
+// The largest power of two that keeps the reduced standard deviation at or
+// above BlurDownsampleThreshold, so that the three box blurs still resolve
+// the kernel with enough taps.
+int blurDownsampleFactor(qreal sigma)
+{
+    int factor = 1;
+    while (factor < MaxBlurDownsampleFactor && sigma >= 2 * factor * BlurDownsampleThreshold)
+        factor *= 2;
+    return factor;
+}
+
+// Averages blocks of factorX x factorY pixels. Blocks that extend past the
+// image are treated as transparent outside of it, matching the zero padding
+// of the box blur.
+QImage boxDownsample(const QImage &source, int factorX, int factorY)
+{
+    QImage target;
+    const QSize size((source.width() + factorX - 1) / factorX,
+                     (source.height() + factorY - 1) / factorY);
+    if (!QImageIOHandler::allocateImage(size, QImage::Format_ARGB32_Premultiplied, &target))
+        return target;
+
+    const uchar *sourceBits = source.constBits();
+    const qsizetype sourceBytesPerLine = source.bytesPerLine();
+    uchar *targetBits = target.bits();
+    const qsizetype targetBytesPerLine = target.bytesPerLine();
+    const int sourceWidth = source.width();
+    const int sourceHeight = source.height();
+    const int width = size.width();
+    const quint32 area = quint32(factorX * factorY);
+
+    runSegmented(size.height(), qsizetype(sourceWidth) * sourceHeight, [&](int y0, int y1) {
+        QVarLengthArray<quint32, 4 * 256> sums(4 * width);
+        for (int y = y0; y < y1; ++y) {
+            std::fill(sums.begin(), sums.end(), 0);
+            const int rowEnd = qMin(sourceHeight, (y + 1) * factorY);
+            for (int row = y * factorY; row < rowEnd; ++row) {
+                const QRgb *line = reinterpret_cast<const QRgb *>(sourceBits + row * sourceBytesPerLine);
+                for (int x = 0; x < sourceWidth; ++x) {
+                    quint32 *sum = sums.data() + 4 * (x / factorX);
+                    for (int c = 0; c < 4; ++c)
+                        sum[c] += (line[x] >> (8 * c)) & 0xff;
+                }
+            }
+            QRgb *line = reinterpret_cast<QRgb *>(targetBits + y * targetBytesPerLine);
+            for (int x = 0; x < width; ++x) {
+                QRgb pixel = 0;
+                for (int c = 0; c < 4; ++c)
+                    pixel |= ((sums[4 * x + c] + area / 2) / area) << (8 * c);
+                line[x] = pixel;
+            }
+        }
+    });
+    return target;
+}
+
+} // anonymous namespace
+
 QSvgFeGaussianBlur::QSvgFeGaussianBlur(QSvgNode *parent, const QString &input,
                                        const QString &result, const QSvgRectF &rect,
                                        qreal stdDeviationX, qreal stdDeviationY, EdgeMode edgemode)
@@ -287,17 +1056,16 @@ QSvgNode::Type QSvgFeGaussianBlur::type() const
     return QSvgNode::FeGaussianblur;
 }
 
-QImage QSvgFeGaussianBlur::apply(const QMap<QString, QImage> &sources, QPainter *p,
+QImage QSvgFeGaussianBlur::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
                                  const QRectF &itemBounds, const QRectF &filterBounds,
                                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
 {
-    if (!sources.contains(m_input))
+    if (inputs.value(0).isNull())
         return QImage();
-    QImage source = sources[m_input];
-    Q_ASSERT(source.depth() == 32);
+    const QSvgFilterBuffer &source = inputs.at(0);
 
     if (m_stdDeviationX == 0 && m_stdDeviationY == 0)
-        return source;
+        return source.toImage();
 
     const qreal scaleX = qHypot(p->transform().m11(), p->transform().m21());
     const qreal scaleY = qHypot(p->transform().m12(), p->transform().m22());
@@ -309,19 +1077,17 @@ QImage QSvgFeGaussianBlur::apply(const QMap<QString, QImage> &sources, QPainter
         sigma_y *= itemBounds.height();
     }
 
-    constexpr double sd = 3. * M_SQRT1_2 / M_2_SQRTPI; // 3 * sqrt(2 * pi) / 4
-    const int dx = floor(sigma_x * sd + 0.5);
-    const int dy = floor(sigma_y * sd + 0.5);
-
     const QTransform scaleXr = QTransform::fromScale(scaleX, scaleY);
     const QTransform restXr = scaleXr.inverted() * p->transform();
 
     QRect clipRectGlob = scaleXr.mapRect(localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits)).toRect();
+    if (!pool->region().isNull())
+        clipRectGlob &= restXr.inverted().mapRect(QRectF(pool->region())).toAlignedRect();
     if (clipRectGlob.isEmpty())
         return QImage();
 
     QImage tempSource;
-    if (!QImageIOHandler::allocateImage(clipRectGlob.size(), QImage::Format_ARGB32_Premultiplied, &tempSource)) {
+    if (!pool->allocate(clipRectGlob.size(), &tempSource)) {
         qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
         return QImage();
     }
@@ -330,100 +1096,99 @@ QImage QSvgFeGaussianBlur::apply(const QMap<QString, QImage> &sources, QPainter
     QPainter copyPainter(&tempSource);
     copyPainter.translate(-tempSource.offset());
     copyPainter.setTransform(restXr.inverted(), true);
-    copyPainter.drawImage(source.offset(), source);
+    source.draw(&copyPainter, QPoint());
     copyPainter.end();
 
-    QVarLengthArray<uint64_t, 32 * 32> buffer(tempSource.width() * tempSource.height());
-
-    const int sourceHeight = tempSource.height();
-    const int sourceWidth = tempSource.width();
-    QRgb *rawImage = reinterpret_cast<QRgb *>(tempSource.bits());
-
-    // https://www.w3.org/TR/SVG11/filters.html#feGaussianBlurElement:
-    // Three successive box-blurs build a piece-wise quadratic convolution kernel,
-    // which approximates the Gaussian kernel
-    for (int m = 0; m < 3; m++) {
-        for (int col = 0; col < 4 * 8; col += 8 ){
-            // Generating the partial sum of color values from the top left corner
-            // These sums can be combined to yield the partial sum of any rectangular subregion
-            for (int i = 0; i < sourceWidth; i++) {
-                for (int j = 0; j < sourceHeight; j++) {
-                    buffer[i + j * sourceWidth] = (rawImage[i + j * sourceWidth] >> col) & 0xff;
-                    if (i > 0)
-                        buffer[i + j * sourceWidth] += buffer[(i - 1) + j * sourceWidth];
-                    if (j > 0)
-                        buffer[i + j * sourceWidth] += buffer[i + (j - 1) * sourceWidth];
-                    if (i > 0 && j > 0)
-                        buffer[i + j * sourceWidth] -= buffer[(i - 1) + (j - 1) * sourceWidth];
-                }
-            }
-
-            // https://www.w3.org/TR/SVG11/filters.html#feGaussianBlurElement:
-            // if d is odd, use three box-blurs of size 'd', centered on the output pixel.
-            // if d is even, two box-blurs of size 'd' (the first one centered on the pixel boundary
-            // between the output pixel and the one to the left, the second one centered on the pixel
-            // boundary between the output pixel and the one to the right) and one box blur of size
-            // 'd+1' centered on the output pixel.
-            auto adjustD = [](int d, int iteration) {
-                d = qMax(1, d);     // Treat d == 0 just like d == 1
-                std::pair<int, int> result;
-                if (d % 2 == 1)
-                    result = {d / 2 + 1, d / 2};
-                else if (iteration == 0)
-                    result = {d / 2 + 1, d / 2 - 1};
-                else if (iteration == 1)
-                    result = {d / 2, d / 2};
-                else
-                    result = {d / 2 + 1, d / 2};
-                Q_ASSERT(result.first + result.second > 0);
-                return result;
-            };
-
-            const auto [dxleft, dxright] = adjustD(dx, m);
-            const auto [dytop, dybottom] = adjustD(dy, m);
-            for (int i = 0; i < sourceWidth; i++) {
-                for (int j = 0; j < sourceHeight; j++) {
-                    const int i1 = qMax(0, i - dxleft);
-                    const int i2 = qMin(sourceWidth - 1, i + dxright);
-                    const int j1 = qMax(0, j - dytop);
-                    const int j2 = qMin(sourceHeight - 1, j + dybottom);
-
-                    uint64_t colorValue64 = buffer[i2 + j2 * sourceWidth];
-                    colorValue64 -= buffer[i1 + j2 * sourceWidth];
-                    colorValue64 -= buffer[i2 + j1 * sourceWidth];
-                    colorValue64 += buffer[i1 + j1 * sourceWidth];
-                    colorValue64 /= uint64_t(dxleft + dxright) * uint64_t(dytop + dybottom);
-
-                    const unsigned int colorValue = colorValue64;
-                    rawImage[i + j * sourceWidth] &= ~(0xff << col);
-                    rawImage[i + j * sourceWidth] |= colorValue << col;
-
-                }
-            }
+    // For large deviations, blur a box-downsampled copy and scale the result
+    // back up bilinearly. Downsampling and bilinear upsampling widen the
+    // kernel by a variance of about (factor^2 - 1) / 4, which is taken off
+    // the deviation used at the reduced resolution.
+    int factorX = 1;
+    int factorY = 1;
+    if (document() && document()->options().testFlag(QtSvg::ApproximateLargeBlurs)) {
+        factorX = blurDownsampleFactor(sigma_x);
+        factorY = blurDownsampleFactor(sigma_y);
+    }
+    if (factorX > 1 || factorY > 1) {
+        QImage reduced = boxDownsample(tempSource, factorX, factorY);
+        pool->recycle(std::move(tempSource));
+        tempSource = std::move(reduced);
+        if (tempSource.isNull()) {
+            qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+            return QImage();
         }
+        sigma_x = qSqrt(qMax(0., sigma_x * sigma_x - (factorX * factorX - 1) / 4.)) / factorX;
+        sigma_y = qSqrt(qMax(0., sigma_y * sigma_y - (factorY * factorY - 1) / 4.)) / factorY;
+    }
+
+    QImage blurred;
+    if (!pool->allocate(tempSource.size(), &blurred)) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QImage();
     }
+    blurred.setOffset(tempSource.offset());
+    gaussianBoxBlur(&tempSource, &blurred, sigma_x, sigma_y);
+    pool->recycle(std::move(blurred));
 
-    QRectF trueClipRectGlob = globalSubRegion(p, itemBounds, filterBounds, primitiveUnits, filterUnits);
+    const QRect trueClipRectGlob = pool->clipToRegion(
+            globalSubRegion(p, itemBounds, filterBounds, primitiveUnits, filterUnits).toRect());
+    if (trueClipRectGlob.isEmpty())
+        return QImage();
 
     QImage result;
-    if (!QImageIOHandler::allocateImage(trueClipRectGlob.toRect().size(), QImage::Format_ARGB32_Premultiplied, &result)) {
+    if (!pool->allocate(trueClipRectGlob.size(), &result)) {
         qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
         return QImage();
     }
-    result.setOffset(trueClipRectGlob.toRect().topLeft());
+    result.setOffset(trueClipRectGlob.topLeft());
     result.fill(Qt::transparent);
     QPainter transformPainter(&result);
     transformPainter.setRenderHint(QPainter::Antialiasing, true);
 
     transformPainter.translate(-result.offset());
     transformPainter.setTransform(restXr, true);
-    transformPainter.drawImage(clipRectGlob.topLeft(), tempSource);
+    if (factorX > 1 || factorY > 1) {
+        transformPainter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        transformPainter.drawImage(QRectF(clipRectGlob.topLeft(),
+                                          QSizeF(tempSource.width() * factorX,
+                                                 tempSource.height() * factorY)),
+                                   tempSource);
+    } else {
+        transformPainter.drawImage(clipRectGlob.topLeft(), tempSource);
+    }
     transformPainter.end();
+    pool->recycle(std::move(tempSource));
 
     clipToTransformedBounds(&result, p, localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits));
     return result;
 }
 
+/*!
+    \internal
+
+    The three box blurs reach about 2.8 deviations from a pixel; 3 deviations
+    and a few pixels for rounding, and for the grid of the reduced resolution
+    when large blurs are approximated, are a safe bound.
+*/
+QMargins QSvgFeGaussianBlur::footprint(QPainter *p, const QRectF &itemBounds,
+                                       QtSvg::UnitTypes primitiveUnits) const
+{
+    qreal deviationX = m_stdDeviationX;
+    qreal deviationY = m_stdDeviationY;
+    if (primitiveUnits == QtSvg::UnitTypes::objectBoundingBox) {
+        deviationX *= itemBounds.width();
+        deviationY *= itemBounds.height();
+    }
+
+    int slack = 3;
+    if (document() && document()->options().testFlag(QtSvg::ApproximateLargeBlurs))
+        slack += 2 * MaxBlurDownsampleFactor;
+
+    // The deviations are along the axes of the user space
+    return deviceMargins(p->transform(), QRectF(-3 * deviationX, -3 * deviationY,
+                                                6 * deviationX, 6 * deviationY), slack);
+}
+
 QSvgFeOffset::QSvgFeOffset(QSvgNode *parent, const QString &input, const QString &result,
                            const QSvgRectF &rect, qreal dx, qreal dy)
     : QSvgFeFilterPrimitive(parent, input, result, rect)
@@ -438,45 +1203,78 @@ QSvgNode::Type QSvgFeOffset::type() const
     return QSvgNode::FeOffset;
 }
 
-QImage QSvgFeOffset::apply(const QMap<QString, QImage> &sources, QPainter *p,
+QPoint QSvgFeOffset::deviceOffset(QPainter *p, const QRectF &itemBounds,
+                                  QtSvg::UnitTypes primitiveUnits) const
+{
+    QPoint offset(m_dx, m_dy);
+    if (primitiveUnits == QtSvg::UnitTypes::objectBoundingBox) {
+        offset = QPoint(m_dx * itemBounds.width(),
+                        m_dy * itemBounds.height());
+    }
+    return p->transform().map(offset) - p->transform().map(QPoint(0, 0));
+}
+
+QImage QSvgFeOffset::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
                            const QRectF &itemBounds, const QRectF &filterBounds,
                            QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
 {
-    if (!sources.contains(m_input))
+    if (inputs.value(0).isNull())
         return QImage();
 
-    const QImage &source = sources[m_input];
+    QSvgFilterBuffer source = inputs.at(0);
 
     QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
-    QRect clipRectGlob = p->transform().mapRect(clipRect).toRect();
-
-    QPoint offset(m_dx, m_dy);
-    if (primitiveUnits == QtSvg::UnitTypes::objectBoundingBox) {
-        offset = QPoint(m_dx * itemBounds.width(),
-                        m_dy * itemBounds.height());
-    }
-    offset = p->transform().map(offset) - p->transform().map(QPoint(0, 0));
+    QRect clipRectGlob = pool->clipToRegion(p->transform().mapRect(clipRect).toRect());
 
     if (clipRectGlob.isEmpty())
         return QImage();
 
     QImage result;
-    if (!QImageIOHandler::allocateImage(clipRectGlob.size(), QImage::Format_ARGB32_Premultiplied, &result)) {
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
         qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
         return QImage();
     }
     result.setOffset(clipRectGlob.topLeft());
     result.fill(Qt::transparent);
 
+    source.translate(deviceOffset(p, itemBounds, primitiveUnits));
     QPainter copyPainter(&result);
-    copyPainter.drawImage(source.offset()
-                        - result.offset() + offset, source);
+    source.draw(&copyPainter, result.offset());
     copyPainter.end();
 
     clipToTransformedBounds(&result, p, clipRect);
     return result;
 }
 
+/*!
+    \internal
+
+    With the default subregion, every consumer of the result clips to the
+    same filter region, so for axis aligned transforms the offset does not
+    need its own buffer and only moves its input.
+*/
+bool QSvgFeOffset::applyWithoutBuffer(const QSvgFilterInputs &inputs, QPainter *p,
+                                      const QRectF &itemBounds, const QRectF &,
+                                      QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes,
+                                      QSvgFilterBuffer *output) const
+{
+    if (!hasDefaultSubRegion() || p->transform().type() > QTransform::TxScale)
+        return false;
+
+    *output = inputs.value(0);
+    if (!output->isNull())
+        output->translate(deviceOffset(p, itemBounds, primitiveUnits));
+    return true;
+}
+
+QMargins QSvgFeOffset::footprint(QPainter *p, const QRectF &itemBounds,
+                                 QtSvg::UnitTypes primitiveUnits) const
+{
+    // A pixel at x reads its input at x - offset
+    const QPoint offset = deviceOffset(p, itemBounds, primitiveUnits);
+    return QMargins(qMax(0, offset.x()), qMax(0, offset.y()),
+                    qMax(0, -offset.x()), qMax(0, -offset.y()));
+}
 
 QSvgFeMerge::QSvgFeMerge(QSvgNode *parent, const QString &input,
                          const QString &result, const QSvgRectF &rect)
@@ -490,26 +1288,17 @@ QSvgNode::Type QSvgFeMerge::type() const
     return QSvgNode::FeMerge;
 }
 
-QImage QSvgFeMerge::apply(const QMap<QString, QImage> &sources, QPainter *p,
+QImage QSvgFeMerge::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
                           const QRectF &itemBounds, const QRectF &filterBounds,
                           QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
 {
-    QList<QImage> mergeNodeResults;
-    for (int i = 0; i < renderers().size(); i++) {
-        QSvgNode *child = renderers().at(i);
-        if (child->type() == QSvgNode::FeMergenode) {
-            QSvgFeMergeNode *filter = static_cast<QSvgFeMergeNode*>(child);
-            mergeNodeResults.append(filter->apply(sources, p, itemBounds, filterBounds, primitiveUnits, filterUnits));
-        }
-    }
-
     QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
-    QRect clipRectGlob = p->transform().mapRect(clipRect).toRect();
+    QRect clipRectGlob = pool->clipToRegion(p->transform().mapRect(clipRect).toRect());
     if (clipRectGlob.isEmpty())
         return QImage();
 
     QImage result;
-    if (!QImageIOHandler::allocateImage(clipRectGlob.size(), QImage::Format_ARGB32_Premultiplied, &result)) {
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
         qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
         return QImage();
     }
@@ -517,26 +1306,23 @@ QImage QSvgFeMerge::apply(const QMap<QString, QImage> &sources, QPainter *p,
     result.fill(Qt::transparent);
 
     QPainter proxyPainter(&result);
-    for (const QImage &i : mergeNodeResults) {
-        proxyPainter.drawImage(QRect(i.offset() - result.offset(), i.size()), i);
-    }
+    for (const QSvgFilterBuffer &input : inputs)
+        input.draw(&proxyPainter, result.offset());
     proxyPainter.end();
 
     clipToTransformedBounds(&result, p, clipRect);
     return result;
 }
 
-bool QSvgFeMerge::requiresSourceAlpha() const
+QStringList QSvgFeMerge::inputs() const
 {
+    QStringList result;
     for (int i = 0; i < renderers().size(); i++) {
         QSvgNode *child = renderers().at(i);
-        if (child->type() == QSvgNode::FeMergenode) {
-            QSvgFeMergeNode *filter = static_cast<QSvgFeMergeNode *>(child);
-            if (filter->requiresSourceAlpha())
-                return true;
-        }
+        if (child->type() == QSvgNode::FeMergenode)
+            result.append(static_cast<QSvgFeMergeNode *>(child)->input());
     }
-    return false;
+    return result;
 }
 
 QSvgFeMergeNode::QSvgFeMergeNode(QSvgNode *parent, const QString &input,
@@ -551,10 +1337,10 @@ QSvgNode::Type QSvgFeMergeNode::type() const
     return QSvgNode::FeMergenode;
 }
 
-QImage QSvgFeMergeNode::apply(const QMap<QString, QImage> &sources, QPainter *,
+QImage QSvgFeMergeNode::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *, QPainter *,
                               const QRectF &, const QRectF &, QtSvg::UnitTypes, QtSvg::UnitTypes) const
 {
-    return sources.value(m_input);
+    return inputs.value(0).toImage();
 }
 
 QSvgFeComposite::QSvgFeComposite(QSvgNode *parent, const QString &input, const QString &result,
@@ -573,27 +1359,152 @@ QSvgNode::Type QSvgFeComposite::type() const
     return QSvgNode::FeComposite;
 }
 
-QImage QSvgFeComposite::apply(const QMap<QString, QImage> &sources, QPainter *p,
-                              const QRectF &itemBounds, const QRectF &filterBounds,
-                              QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
+namespace {
+
+// Splits every row of result into the spans covered by both inputs, by one
+// of them and by neither, and calls function(dst, count, src1, src2) for
+// each span with the pixels of the inputs, or null for an input that does
+// not cover it. Rows are split over the thread pool on large buffers.
+template <typename Function>
+void forEachInputSpan(QImage *result, const QImage &source1, const QPoint &offset1,
+                      const QImage &source2, const QPoint &offset2, Function &&function)
 {
-    if (!sources.contains(m_input))
-        return QImage();
-    if (!sources.contains(m_input2))
-        return QImage();
-    QImage source1 = sources[m_input];
-    QImage source2 = sources[m_input2];
-    Q_ASSERT(source1.depth() == 32);
-    Q_ASSERT(source2.depth() == 32);
+    const QRect target(result->offset(), result->size());
+    const QRect rect1(offset1, source1.size());
+    const QRect rect2(offset2, source2.size());
+    const qsizetype resultBytesPerLine = result->bytesPerLine();
+    uchar *resultBits = result->bits();
+    const int width = target.width();
+
+    runSegmented(target.height(), qsizetype(width) * target.height(), [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const int deviceY = y + target.top();
+            QRgb *dst = reinterpret_cast<QRgb *>(resultBits + y * resultBytesPerLine);
+
+            // The columns of the row covered by an input, in result
+            // coordinates, and the input pixels at the first of them
+            auto span = [&](const QImage &source, const QRect &rect, const QRgb **line) {
+                if (deviceY < rect.top() || deviceY > rect.bottom())
+                    return std::pair(0, 0);
+                const int begin = qBound(0, rect.left() - target.left(), width);
+                const int end = qBound(0, rect.right() + 1 - target.left(), width);
+                if (begin < end) {
+                    *line = reinterpret_cast<const QRgb *>(source.constScanLine(deviceY - rect.top()))
+                            + target.left() + begin - rect.left();
+                }
+                return std::pair(begin, end);
+            };
+            const QRgb *line1 = nullptr;
+            const QRgb *line2 = nullptr;
+            const auto [begin1, end1] = span(source1, rect1, &line1);
+            const auto [begin2, end2] = span(source2, rect2, &line2);
+
+            int bounds[6] = { 0, begin1, end1, begin2, end2, width };
+            std::sort(std::begin(bounds), std::end(bounds));
+            for (int i = 0; i < 5; ++i) {
+                const int x = bounds[i];
+                const int count = bounds[i + 1] - x;
+                if (count <= 0)
+                    continue;
+                const bool in1 = x >= begin1 && x < end1;
+                const bool in2 = x >= begin2 && x < end2;
+                function(dst + x, count, in1 ? line1 + x - begin1 : nullptr,
+                         in2 ? line2 + x - begin2 : nullptr);
+            }
+        }
+    });
+}
 
-    QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
-    QRect clipRectGlob = p->transform().mapRect(clipRect).toRect();
+// k1 pre-divided by 255 and k4 pre-multiplied by 255, for 0-255 channels
+struct ArithmeticCoefficients
+{
+    float k1;
+    float k2;
+    float k3;
+    float k4;
+};
+
+// k1 * i1 * i2 + k2 * i1 + k3 * i2 + k4 on premultiplied pixels, where an
+// input that is not present is transparent black
+template <bool First, bool Second>
+QRgb arithmeticPixel(const ArithmeticCoefficients &k, QRgb pixel1, QRgb pixel2)
+{
+    auto channel = [&](int c1, int c2) {
+        float value = k.k4;
+        if constexpr (First)
+            value += k.k2 * c1;
+        if constexpr (Second)
+            value += k.k3 * c2;
+        if constexpr (First && Second)
+            value += k.k1 * c1 * c2;
+        return value;
+    };
+    const float a = qBound(0.f, channel(qAlpha(pixel1), qAlpha(pixel2)), 255.f);
+    return qRgba(roundChannel(qBound(0.f, channel(qRed(pixel1), qRed(pixel2)), a)),
+                 roundChannel(qBound(0.f, channel(qGreen(pixel1), qGreen(pixel2)), a)),
+                 roundChannel(qBound(0.f, channel(qBlue(pixel1), qBlue(pixel2)), a)),
+                 roundChannel(a));
+}
+
+template <bool First, bool Second>
+void arithmeticSpan(const ArithmeticCoefficients &k, const QRgb *src1, const QRgb *src2,
+                    QRgb *dst, int count)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+    const Float4 k1 = splat(k.k1);
+    const Float4 k2 = splat(k.k2);
+    const Float4 k3 = splat(k.k3);
+    const Float4 k4 = splat(k.k4);
+    const Float4 zero = splat(0.f);
+    const Float4 max = splat(255.f);
+
+    for (; x + 4 <= count; x += 4) {
+        Float4 r1 = zero, g1 = zero, b1 = zero, a1 = zero;
+        Float4 r2 = zero, g2 = zero, b2 = zero, a2 = zero;
+        if constexpr (First)
+            loadPixels(src1 + x, &r1, &g1, &b1, &a1);
+        if constexpr (Second)
+            loadPixels(src2 + x, &r2, &g2, &b2, &a2);
+
+        auto channel = [&](Float4 c1, Float4 c2) {
+            Float4 value = k4;
+            if constexpr (First)
+                value = add(value, mul(k2, c1));
+            if constexpr (Second)
+                value = add(value, mul(k3, c2));
+            if constexpr (First && Second)
+                value = add(value, mul(k1, mul(c1, c2)));
+            return value;
+        };
+        const Float4 a = bound(zero, channel(a1, a2), max);
+        storePixels(dst + x, bound(zero, channel(r1, r2), a), bound(zero, channel(g1, g2), a),
+                    bound(zero, channel(b1, b2), a), a);
+    }
+#endif
+    for (; x < count; ++x)
+        dst[x] = arithmeticPixel<First, Second>(k, First ? src1[x] : 0, Second ? src2[x] : 0);
+}
+
+} // anonymous namespace
+
+QImage QSvgFeComposite::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
+                              const QRectF &itemBounds, const QRectF &filterBounds,
+                              QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
+{
+    if (inputs.value(0).isNull() || inputs.value(1).isNull())
+        return QImage();
+    const QSvgFilterBuffer &input1 = inputs.at(0);
+    const QSvgFilterBuffer &input2 = inputs.at(1);
+
+    QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
+    QRect clipRectGlob = pool->clipToRegion(p->transform().mapRect(clipRect).toRect());
 
     if (clipRectGlob.isEmpty())
         return QImage();
 
     QImage result;
-    if (!QImageIOHandler::allocateImage(clipRectGlob.size(), QImage::Format_ARGB32_Premultiplied, &result)) {
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
         qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
         return QImage();
     }
@@ -601,62 +1512,28 @@ QImage QSvgFeComposite::apply(const QMap<QString, QImage> &sources, QPainter *p,
     result.fill(Qt::transparent);
 
     if (m_operator == Operator::Arithmetic) {
-        const qreal k1 = m_k.x();
-        const qreal k2 = m_k.y();
-        const qreal k3 = m_k.z();
-        const qreal k4 = m_k.w();
-
-        for (int j = 0; j < result.height(); j++) {
-            int jj1 = j - source1.offset().y() + result.offset().y();
-            int jj2 = j - source2.offset().y() + result.offset().y();
-
-            QRgb *resultLine = reinterpret_cast<QRgb *>(result.scanLine(j));
-            QRgb *source1Line = nullptr;
-            QRgb *source2Line = nullptr;
-
-            if (jj1 >= 0 && jj1 < source1.size().height())
-                source1Line = reinterpret_cast<QRgb *>(source1.scanLine(jj1));
-            if (jj2 >= 0 && jj2 < source2.size().height())
-                 source2Line = reinterpret_cast<QRgb *>(source2.scanLine(jj2));
-
-            for (int i = 0; i < result.width(); i++) {
-                int ii1 = i - source1.offset().x() + result.offset().x();
-                int ii2 = i - source2.offset().x() + result.offset().x();
-
-                QVector4D s1 = QVector4D(0, 0, 0, 0);
-                QVector4D s2 = QVector4D(0, 0, 0, 0);
-
-                if (ii1 >= 0 && ii1 < source1.size().width() && source1Line) {
-                    QRgb pixel1 = source1Line[ii1];
-                    s1 = QVector4D(qRed(pixel1),
-                                   qGreen(pixel1),
-                                   qBlue(pixel1),
-                                   qAlpha(pixel1));
-                }
-
-                if (ii2 >= 0 && ii2 < source2.size().width() && source2Line) {
-                    QRgb pixel2 = source2Line[ii2];
-                    s2 = QVector4D(qRed(pixel2),
-                                   qGreen(pixel2),
-                                   qBlue(pixel2),
-                                   qAlpha(pixel2));
-                }
-
-                int r = k1 * s1.x() * s2.x() / 255. + k2 * s1.x() + k3 * s2.x() + k4 * 255.;
-                int g = k1 * s1.y() * s2.y() / 255. + k2 * s1.y() + k3 * s2.y() + k4 * 255.;
-                int b = k1 * s1.z() * s2.z() / 255. + k2 * s1.z() + k3 * s2.z() + k4 * 255.;
-                int a = k1 * s1.w() * s2.w() / 255. + k2 * s1.w() + k3 * s2.w() + k4 * 255.;
-
-                a = qBound(0, a, 255);
-                resultLine[i] =  qRgba(qBound(0, r, a),
-                                       qBound(0, g, a),
-                                       qBound(0, b, a),
-                                       a);
-            }
-        }
+        const QImage source1 = input1.image();
+        const QImage source2 = input2.image();
+        const ArithmeticCoefficients k{ float(m_k.x() / 255.), float(m_k.y()),
+                                        float(m_k.z()), float(m_k.w() * 255.) };
+
+        // Outside of both inputs the result is the constant k4
+        const QRgb background = arithmeticPixel<false, false>(k, 0, 0);
+
+        forEachInputSpan(&result, source1, input1.offset(), source2, input2.offset(),
+                         [&](QRgb *dst, int count, const QRgb *src1, const QRgb *src2) {
+            if (src1 && src2)
+                arithmeticSpan<true, true>(k, src1, src2, dst, count);
+            else if (src1)
+                arithmeticSpan<true, false>(k, src1, nullptr, dst, count);
+            else if (src2)
+                arithmeticSpan<false, true>(k, nullptr, src2, dst, count);
+            else if (background)
+                std::fill_n(dst, count, background);
+        });
     } else {
         QPainter proxyPainter(&result);
-        proxyPainter.drawImage(QRect(source1.offset() - result.offset(), source1.size()), source1);
+        input1.draw(&proxyPainter, result.offset());
 
         switch (m_operator) {
         case Operator::In:
@@ -681,7 +1558,7 @@ QImage QSvgFeComposite::apply(const QMap<QString, QImage> &sources, QPainter *p,
             Q_UNREACHABLE();
             break;
         }
-        proxyPainter.drawImage(QRect(source2.offset()-result.offset(), source2.size()), source2);
+        input2.draw(&proxyPainter, result.offset());
         proxyPainter.end();
     }
 
@@ -689,11 +1566,9 @@ QImage QSvgFeComposite::apply(const QMap<QString, QImage> &sources, QPainter *p,
     return result;
 }
 
-bool QSvgFeComposite::requiresSourceAlpha() const
+QStringList QSvgFeComposite::inputs() const
 {
-    if (QSvgFeFilterPrimitive::requiresSourceAlpha())
-        return true;
-    return m_input2 == QLatin1StringView("SourceAlpha");
+    return { m_input, m_input2 };
 }
 
 
@@ -710,26 +1585,53 @@ QSvgNode::Type QSvgFeFlood::type() const
     return QSvgNode::FeFlood;
 }
 
-QImage QSvgFeFlood::apply(const QMap<QString, QImage> &,
+QStringList QSvgFeFlood::inputs() const
+{
+    return {};
+}
+
+QImage QSvgFeFlood::apply(const QSvgFilterInputs &, QSvgFilterBufferPool *pool,
                           QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                           QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
 {
 
     QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
-    QRect clipRectGlob = p->transform().mapRect(clipRect).toRect();
+    QRect clipRectGlob = pool->clipToRegion(p->transform().mapRect(clipRect).toRect());
+    if (clipRectGlob.isEmpty())
+        return QImage();
 
     QImage result;
-    if (!QImageIOHandler::allocateImage(clipRectGlob.size(), QImage::Format_ARGB32_Premultiplied, &result)) {
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
         qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
         return QImage();
     }
     result.setOffset(clipRectGlob.topLeft());
-    result.fill(m_color);
+    result.fill(colorInColorSpace(m_color));
 
     clipToTransformedBounds(&result, p, clipRect);
     return result;
 }
 
+/*!
+    \internal
+
+    For axis aligned transforms the flood is a rectangle of a constant color,
+    which is only filled into a buffer by the primitives that read pixels.
+*/
+bool QSvgFeFlood::applyWithoutBuffer(const QSvgFilterInputs &, QPainter *p,
+                                     const QRectF &itemBounds, const QRectF &filterBounds,
+                                     QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits,
+                                     QSvgFilterBuffer *output) const
+{
+    if (p->transform().type() > QTransform::TxScale)
+        return false;
+
+    const QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
+    *output = QSvgFilterBuffer::flood(p->transform().mapRect(clipRect).toRect(),
+                                      colorInColorSpace(m_color));
+    return true;
+}
+
 QSvgFeBlend::QSvgFeBlend(QSvgNode *parent, const QString &input, const QString &result,
                          const QSvgRectF &rect, const QString &input2, Mode mode)
     : QSvgFeFilterPrimitive(parent, input, result, rect)
@@ -744,106 +1646,1749 @@ QSvgNode::Type QSvgFeBlend::type() const
     return QSvgNode::FeBlend;
 }
 
-QImage QSvgFeBlend::apply(const QMap<QString, QImage> &sources, QPainter *p,
+namespace {
+
+// The blend of premultiplied pixels, with in on top of in2: every mode
+// reduces to a function of the two colors and the two alphas
+template <QSvgFeBlend::Mode Mode, typename T, typename Ops>
+T blendChannel(const Ops &ops, T c1, T c2, T a1, T a2)
+{
+    using M = QSvgFeBlend::Mode;
+    if constexpr (Mode == M::Normal) {
+        return ops.add(c1, ops.mul(c2, ops.inverse(a1)));
+    } else if constexpr (Mode == M::Multiply) {
+        // c1 (1 - a2) + c2 (1 - a1) + c1 c2
+        return ops.add(ops.mul(c2, ops.inverse(a1)), ops.mul(c1, ops.add(ops.inverse(a2), ops.scale(c2))));
+    } else if constexpr (Mode == M::Screen) {
+        return ops.add(c2, ops.mul(c1, ops.inverse(c2)));
+    } else {
+        const T over1 = ops.add(c1, ops.mul(c2, ops.inverse(a1)));
+        const T over2 = ops.add(c2, ops.mul(c1, ops.inverse(a2)));
+        if constexpr (Mode == M::Darken)
+            return ops.min(over1, over2);
+        else
+            return ops.max(over1, over2);
+    }
+}
+
+struct ScalarBlendOps
+{
+    float add(float a, float b) const { return a + b; }
+    float mul(float a, float b) const { return a * b; }
+    float min(float a, float b) const { return qMin(a, b); }
+    float max(float a, float b) const { return qMax(a, b); }
+    float scale(float a) const { return a * (1.f / 255); }
+    float inverse(float a) const { return 1.f - a * (1.f / 255); }
+};
+
+template <QSvgFeBlend::Mode Mode>
+QRgb blendPixel(QRgb pixel1, QRgb pixel2)
+{
+    const ScalarBlendOps ops;
+    const float a1 = qAlpha(pixel1);
+    const float a2 = qAlpha(pixel2);
+    const float a = qBound(0.f, a1 + a2 - a1 * a2 * (1.f / 255), 255.f);
+    auto channel = [&](int c1, int c2) {
+        return roundChannel(qBound(0.f, blendChannel<Mode>(ops, float(c1), float(c2), a1, a2), a));
+    };
+    return qRgba(channel(qRed(pixel1), qRed(pixel2)), channel(qGreen(pixel1), qGreen(pixel2)),
+                 channel(qBlue(pixel1), qBlue(pixel2)), roundChannel(a));
+}
+
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+struct SimdBlendOps
+{
+#  if defined(__SSE2__)
+    Float4 add(Float4 a, Float4 b) const { return _mm_add_ps(a, b); }
+    Float4 mul(Float4 a, Float4 b) const { return _mm_mul_ps(a, b); }
+    Float4 min(Float4 a, Float4 b) const { return _mm_min_ps(a, b); }
+    Float4 max(Float4 a, Float4 b) const { return _mm_max_ps(a, b); }
+    Float4 inverse(Float4 a) const { return _mm_sub_ps(one, _mm_mul_ps(a, inverse255)); }
+#  else
+    Float4 add(Float4 a, Float4 b) const { return vaddq_f32(a, b); }
+    Float4 mul(Float4 a, Float4 b) const { return vmulq_f32(a, b); }
+    Float4 min(Float4 a, Float4 b) const { return vminq_f32(a, b); }
+    Float4 max(Float4 a, Float4 b) const { return vmaxq_f32(a, b); }
+    Float4 inverse(Float4 a) const { return vsubq_f32(one, vmulq_f32(a, inverse255)); }
+#  endif
+    Float4 scale(Float4 a) const { return mul(a, inverse255); }
+
+    Float4 one = splat(1.f);
+    Float4 inverse255 = splat(1.f / 255);
+};
+#endif
+
+template <QSvgFeBlend::Mode Mode>
+void blendSpan(const QRgb *src1, const QRgb *src2, QRgb *dst, int count)
+{
+    int x = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+    const SimdBlendOps ops;
+    const Float4 zero = splat(0.f);
+    const Float4 max = splat(255.f);
+    for (; x + 4 <= count; x += 4) {
+        Float4 r1, g1, b1, a1, r2, g2, b2, a2;
+        loadPixels(src1 + x, &r1, &g1, &b1, &a1);
+        loadPixels(src2 + x, &r2, &g2, &b2, &a2);
+        const Float4 a = bound(zero, add(a1, mul(a2, ops.inverse(a1))), max);
+        storePixels(dst + x,
+                    bound(zero, blendChannel<Mode>(ops, r1, r2, a1, a2), a),
+                    bound(zero, blendChannel<Mode>(ops, g1, g2, a1, a2), a),
+                    bound(zero, blendChannel<Mode>(ops, b1, b2, a1, a2), a), a);
+    }
+#endif
+    for (; x < count; ++x)
+        dst[x] = blendPixel<Mode>(src1[x], src2[x]);
+}
+
+} // anonymous namespace
+
+QImage QSvgFeBlend::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
                           const QRectF &itemBounds, const QRectF &filterBounds,
                           QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
 {
-    if (!sources.contains(m_input))
+    if (inputs.value(0).isNull() || inputs.value(1).isNull())
         return QImage();
-    if (!sources.contains(m_input2))
-        return QImage();
-    QImage source1 = sources[m_input];
-    QImage source2 = sources[m_input2];
+    const QImage source1 = inputs.at(0).image();
+    const QImage source2 = inputs.at(1).image();
     Q_ASSERT(source1.depth() == 32);
     Q_ASSERT(source2.depth() == 32);
 
     QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
-    QRect clipRectGlob = p->transform().mapRect(clipRect).toRect();
+    QRect clipRectGlob = pool->clipToRegion(p->transform().mapRect(clipRect).toRect());
+    if (clipRectGlob.isEmpty())
+        return QImage();
 
     QImage result;
-    if (!QImageIOHandler::allocateImage(clipRectGlob.size(), QImage::Format_ARGB32_Premultiplied, &result)) {
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
         qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
         return QImage();
     }
     result.setOffset(clipRectGlob.topLeft());
     result.fill(Qt::transparent);
 
-    for (int j = 0; j < result.height(); j++) {
-        int jj1 = j - source1.offset().y() + result.offset().y();
-        int jj2 = j - source2.offset().y() + result.offset().y();
-
-        QRgb *resultLine = reinterpret_cast<QRgb *>(result.scanLine(j));
-        QRgb *source1Line = nullptr;
-        QRgb *source2Line = nullptr;
-
-        if (jj1 >= 0 && jj1 < source1.size().height())
-            source1Line = reinterpret_cast<QRgb *>(source1.scanLine(jj1));
-        if (jj2 >= 0 && jj2 < source2.size().height())
-            source2Line = reinterpret_cast<QRgb *>(source2.scanLine(jj2));
-
-        for (int i = 0; i < result.width(); i++) {
-            int ii1 = i - source1.offset().x() + result.offset().x();
-            int ii2 = i - source2.offset().x() + result.offset().x();
-
-            QRgb pixel1 = (ii1 >= 0 && ii1 < source1.size().width() && source1Line) ?
-                    source1Line[ii1] : qRgba(0, 0, 0, 0);
-            QRgb pixel2 = (ii2 >= 0 && ii2 < source2.size().width() && source2Line) ?
-                    source2Line[ii2] : qRgba(0, 0, 0, 0);
-
-            qreal r = 0, g = 0, b = 0;
-            qreal red1 = qRed(pixel1);
-            qreal red2 = qRed(pixel2);
-            qreal green1 = qGreen(pixel1);
-            qreal green2 = qGreen(pixel2);
-            qreal blue1 = qBlue(pixel1);
-            qreal blue2 = qBlue(pixel2);
-            qreal alpha1 = qAlpha(pixel1) / 255.;
-            qreal alpha2 = qAlpha(pixel2) / 255.;
-            qreal a = 255 - (1 - alpha1) * (1 - alpha2) * 255.;
-
-            switch (m_mode) {
-            case Mode::Normal:
-                r = (1 - alpha1) * red2 + red1;
-                g = (1 - alpha1) * green2 + green1;
-                b = (1 - alpha1) * blue2 + blue1;
-                break;
-            case Mode::Multiply:
-                r = (1 - alpha1) * red2 + (1 - alpha2) * red1 + red1 * red2;
-                g = (1 - alpha1) * green2 + (1 - alpha2) * green1 + green1 * green2;
-                b = (1 - alpha1) * blue2 + (1 - alpha2) * blue1 + blue1 * blue2;
-                break;
-            case Mode::Screen:
-                r = red2 + red1 - red1 * red2;
-                g = green2 + green1 - green1 * green2;
-                b = blue2 + blue1 - blue1 * blue2;
-                break;
-            case Mode::Darken:
-                r = qMin((1 - alpha1) * red2 + red1, (1 - alpha2) * red1 + red2);
-                g = qMin((1 - alpha1) * green2 + green1, (1 - alpha2) * green1 + green2);
-                b = qMin((1 - alpha1) * blue2 + blue1, (1 - alpha2) * blue1 + blue2);
-                break;
-            case Mode::Lighten:
-                r = qMax((1 - alpha1) * red2 + red1, (1 - alpha2) * red1 + red2);
-                g = qMax((1 - alpha1) * green2 + green1, (1 - alpha2) * green1 + green2);
-                b = qMax((1 - alpha1) * blue2 + blue1, (1 - alpha2) * blue1 + blue2);
-                break;
+    void (*blend)(const QRgb *, const QRgb *, QRgb *, int) = nullptr;
+    switch (m_mode) {
+    case Mode::Normal:
+        blend = blendSpan<Mode::Normal>;
+        break;
+    case Mode::Multiply:
+        blend = blendSpan<Mode::Multiply>;
+        break;
+    case Mode::Screen:
+        blend = blendSpan<Mode::Screen>;
+        break;
+    case Mode::Darken:
+        blend = blendSpan<Mode::Darken>;
+        break;
+    case Mode::Lighten:
+        blend = blendSpan<Mode::Lighten>;
+        break;
+    }
+
+    // Blending with transparent black leaves a pixel unchanged in every mode
+    forEachInputSpan(&result, source1, inputs.at(0).offset(), source2, inputs.at(1).offset(),
+                     [&](QRgb *dst, int count, const QRgb *src1, const QRgb *src2) {
+        if (src1 && src2)
+            blend(src1, src2, dst, count);
+        else if (src1 || src2)
+            memcpy(dst, src1 ? src1 : src2, count * sizeof(QRgb));
+    });
+
+    clipToTransformedBounds(&result, p, clipRect);
+    return result;
+}
+
+QStringList QSvgFeBlend::inputs() const
+{
+    return { m_input, m_input2 };
+}
+
+namespace {
+
+// Primitives whose kernels are laid out along the axes of the user space run,
+// like feGaussianBlur, in the device space without its rotation and shear.
+// scale maps the user space into this kernel space, and rest maps the kernel
+// space onto the device.
+struct KernelSpace
+{
+    explicit KernelSpace(const QTransform &xf)
+        : scaleX(qHypot(xf.m11(), xf.m21()))
+        , scaleY(qHypot(xf.m12(), xf.m22()))
+        , scale(QTransform::fromScale(scaleX, scaleY))
+        , rest(scale.inverted() * xf)
+    {
+    }
+
+    QRect bufferRect(const QRectF &localRect, const QSvgFilterBufferPool *pool) const
+    {
+        QRect rect = scale.mapRect(localRect).toRect();
+        if (!pool->region().isNull())
+            rect &= rest.inverted().mapRect(QRectF(pool->region())).toAlignedRect();
+        return rect;
+    }
+
+    qreal scaleX;
+    qreal scaleY;
+    QTransform scale;
+    QTransform rest;
+};
+
+// Draws source into a transparent buffer covering rect of the kernel space
+QImage toKernelSpace(const QSvgFilterBuffer &source, const QRect &rect, const KernelSpace &space,
+                     QSvgFilterBufferPool *pool)
+{
+    QImage buffer;
+    if (!pool->allocate(rect.size(), &buffer))
+        return buffer;
+    buffer.setOffset(rect.topLeft());
+    buffer.fill(Qt::transparent);
+
+    QPainter painter(&buffer);
+    painter.translate(-buffer.offset());
+    painter.setTransform(space.rest.inverted(), true);
+    source.draw(&painter, QPoint());
+    return buffer;
+}
+
+// Draws buffer, in the kernel space, into a new buffer covering rect of the device
+QImage fromKernelSpace(const QImage &buffer, const QRect &rect, const KernelSpace &space,
+                       QSvgFilterBufferPool *pool)
+{
+    QImage result;
+    if (!pool->allocate(rect.size(), &result))
+        return result;
+    result.setOffset(rect.topLeft());
+    result.fill(Qt::transparent);
+
+    QPainter painter(&result);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.translate(-result.offset());
+    painter.setTransform(space.rest, true);
+    painter.drawImage(buffer.offset(), buffer);
+    return result;
+}
+
+// With edgeMode="wrap", every pixel can depend on every other pixel of the
+// subregion. Larger than any buffer, this keeps the region in one tile.
+constexpr int UnboundedFootprint = 1 << 20;
+
+// The four channels of one pixel, in the order of their bits in a QRgb:
+// blue, green, red and alpha. Kernels that combine neighboring pixels
+// vectorize over the channels of one pixel.
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+using Channels = Float4;
+
+#  if defined(__SSE2__)
+inline Channels loadChannels(const float *src) { return _mm_loadu_ps(src); }
+inline void storeChannels(float *dst, Channels c) { _mm_storeu_ps(dst, c); }
+inline Channels alphaOf(Channels c) { return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 3, 3)); }
+
+inline Channels unpackPixel(QRgb pixel)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_cvtsi32_si128(int(pixel));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+// Channels within 0 to 255
+inline QRgb packPixel(Channels c)
+{
+    const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(c), _mm_setzero_si128());
+    return QRgb(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+}
+#  else
+inline Channels loadChannels(const float *src) { return vld1q_f32(src); }
+inline void storeChannels(float *dst, Channels c) { vst1q_f32(dst, c); }
+inline Channels alphaOf(Channels c) { return vdupq_n_f32(vgetq_lane_f32(c, 3)); }
+
+inline Channels unpackPixel(QRgb pixel)
+{
+    const uint8x8_t bytes = vreinterpret_u8_u32(vdup_n_u32(pixel));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(bytes))));
+}
+
+inline QRgb packPixel(Channels c)
+{
+    const uint16x4_t words = vmovn_u32(vcvtq_u32_f32(vaddq_f32(c, vdupq_n_f32(0.5f))));
+    const uint8x8_t bytes = vmovn_u16(vcombine_u16(words, words));
+    return vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+}
+#  endif
+#else
+struct Channels
+{
+    float c[4];
+};
+
+inline Channels splat(float v) { return { { v, v, v, v } }; }
+inline Channels add(Channels a, Channels b)
+{
+    return { { a.c[0] + b.c[0], a.c[1] + b.c[1], a.c[2] + b.c[2], a.c[3] + b.c[3] } };
+}
+inline Channels mul(Channels a, Channels b)
+{
+    return { { a.c[0] * b.c[0], a.c[1] * b.c[1], a.c[2] * b.c[2], a.c[3] * b.c[3] } };
+}
+inline Channels bound(Channels lo, Channels v, Channels hi)
+{
+    Channels result;
+    for (int i = 0; i < 4; ++i)
+        result.c[i] = qMin(qMax(v.c[i], lo.c[i]), hi.c[i]);
+    return result;
+}
+inline Channels loadChannels(const float *src) { return { { src[0], src[1], src[2], src[3] } }; }
+inline void storeChannels(float *dst, Channels c) { std::copy(c.c, c.c + 4, dst); }
+inline Channels alphaOf(Channels c) { return splat(c.c[3]); }
+
+inline Channels unpackPixel(QRgb pixel)
+{
+    return { { float(pixel & 0xff), float((pixel >> 8) & 0xff),
+               float((pixel >> 16) & 0xff), float(pixel >> 24) } };
+}
+
+inline QRgb packPixel(Channels c)
+{
+    return QRgb(qRound(c.c[0])) | QRgb(qRound(c.c[1])) << 8
+            | QRgb(qRound(c.c[2])) << 16 | QRgb(qRound(c.c[3])) << 24;
+}
+#endif
+
+// Copies source into padded, which is larger by the kernel size minus one,
+// so that padded(x + left, y + top) is source(x, y). Pixels around the
+// source are filled in as edgeMode says.
+void padForConvolution(const QImage &source, QImage *padded, int left, int top,
+                       QSvgFeConvolveMatrix::EdgeMode edgeMode, bool unpremultiply)
+{
+    using EdgeMode = QSvgFeConvolveMatrix::EdgeMode;
+    auto sourceIndex = [edgeMode](int i, int size) {
+        if (i >= 0 && i < size)
+            return i;
+        switch (edgeMode) {
+        case EdgeMode::Duplicate:
+            return qBound(0, i, size - 1);
+        case EdgeMode::Wrap:
+            return (i % size + size) % size;
+        case EdgeMode::None:
+            break;
+        }
+        return -1;
+    };
+
+    const int width = source.width();
+    const int height = source.height();
+    const int paddedWidth = padded->width();
+    const uchar *sourceBits = source.constBits();
+    const qsizetype sourceBytesPerLine = source.bytesPerLine();
+    uchar *paddedBits = padded->bits();
+    const qsizetype paddedBytesPerLine = padded->bytesPerLine();
+
+    runSegmented(padded->height(), qsizetype(paddedWidth) * padded->height(), [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            QRgb *dst = reinterpret_cast<QRgb *>(paddedBits + y * paddedBytesPerLine);
+            const int sy = sourceIndex(y - top, height);
+            if (sy < 0) {
+                std::fill(dst, dst + paddedWidth, 0);
+                continue;
+            }
+            const QRgb *src = reinterpret_cast<const QRgb *>(sourceBits + sy * sourceBytesPerLine);
+            for (int x = 0; x < paddedWidth; ++x) {
+                const int sx = sourceIndex(x - left, width);
+                const QRgb pixel = sx < 0 ? 0 : src[sx];
+                dst[x] = unpremultiply ? qUnpremultiply(pixel) : pixel;
+            }
+        }
+    });
+}
+
+// Clamps the convolved channels and premultiplies them. With preserveAlpha
+// the color was convolved unpremultiplied and the alpha is the original's.
+template <bool PreserveAlpha>
+inline QRgb finishConvolution(Channels sum, QRgb original)
+{
+    const Channels zero = splat(0.f);
+    sum = bound(zero, sum, splat(255.f));
+    if constexpr (PreserveAlpha)
+        return qPremultiply((packPixel(sum) & 0x00ffffff) | (original & 0xff000000));
+    else
+        return packPixel(bound(zero, sum, alphaOf(sum)));
+}
+
+struct ConvolutionImages
+{
+    const uchar *paddedBits;
+    qsizetype paddedBytesPerLine;
+    const uchar *sourceBits;
+    qsizetype sourceBytesPerLine;
+    uchar *resultBits;
+    qsizetype resultBytesPerLine;
+    int width;
+    int height;
+};
+
+// result(x, y) is the sum of weights(j, i) * padded(x + j, y + i)
+template <bool PreserveAlpha>
+void convolve(const ConvolutionImages &images, const QSize &order, const float *weights, float bias)
+{
+    const int columns = order.width();
+    const int rows = order.height();
+    QVarLengthArray<float, 4 * 25> splatWeights(4 * columns * rows);
+    for (int i = 0; i < columns * rows; ++i)
+        std::fill_n(splatWeights.data() + 4 * i, 4, weights[i]);
+    const Channels biasChannels = splat(bias);
+
+    runSegmented(images.height, qsizetype(images.width) * images.height * columns * rows,
+                 [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const QRgb *original = reinterpret_cast<const QRgb *>(images.sourceBits + y * images.sourceBytesPerLine);
+            QRgb *dst = reinterpret_cast<QRgb *>(images.resultBits + y * images.resultBytesPerLine);
+            for (int x = 0; x < images.width; ++x) {
+                Channels sum = biasChannels;
+                const float *weight = splatWeights.constData();
+                for (int i = 0; i < rows; ++i) {
+                    const QRgb *line = reinterpret_cast<const QRgb *>(
+                            images.paddedBits + (y + i) * images.paddedBytesPerLine) + x;
+                    for (int j = 0; j < columns; ++j, weight += 4)
+                        sum = add(sum, mul(unpackPixel(line[j]), loadChannels(weight)));
+                }
+                dst[x] = finishConvolution<PreserveAlpha>(sum, original[x]);
+            }
+        }
+    });
+}
+
+// The same for weights(j, i) = rowWeights(j) * columnWeights(i), as a pass
+// along the rows into intermediate, followed by one along the columns.
+template <bool PreserveAlpha>
+void convolveSeparable(const ConvolutionImages &images, const QSize &order,
+                       const float *rowWeights, const float *columnWeights, float bias,
+                       QImage *intermediate)
+{
+    const int columns = order.width();
+    const int rows = order.height();
+    QVarLengthArray<float, 4 * 16> splatRowWeights(4 * columns);
+    for (int j = 0; j < columns; ++j)
+        std::fill_n(splatRowWeights.data() + 4 * j, 4, rowWeights[j]);
+    QVarLengthArray<float, 4 * 16> splatColumnWeights(4 * rows);
+    for (int i = 0; i < rows; ++i)
+        std::fill_n(splatColumnWeights.data() + 4 * i, 4, columnWeights[i]);
+    const Channels biasChannels = splat(bias);
+
+    uchar *intermediateBits = intermediate->bits();
+    const qsizetype intermediateBytesPerLine = intermediate->bytesPerLine();
+
+    runSegmented(intermediate->height(), qsizetype(images.width) * intermediate->height() * columns,
+                 [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(images.paddedBits + y * images.paddedBytesPerLine);
+            float *dst = reinterpret_cast<float *>(intermediateBits + y * intermediateBytesPerLine);
+            for (int x = 0; x < images.width; ++x) {
+                Channels sum = splat(0.f);
+                const float *weight = splatRowWeights.constData();
+                for (int j = 0; j < columns; ++j, weight += 4)
+                    sum = add(sum, mul(unpackPixel(line[x + j]), loadChannels(weight)));
+                storeChannels(dst + 4 * x, sum);
+            }
+        }
+    });
+
+    runSegmented(images.height, qsizetype(images.width) * images.height * rows, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const QRgb *original = reinterpret_cast<const QRgb *>(images.sourceBits + y * images.sourceBytesPerLine);
+            QRgb *dst = reinterpret_cast<QRgb *>(images.resultBits + y * images.resultBytesPerLine);
+            for (int x = 0; x < images.width; ++x) {
+                Channels sum = biasChannels;
+                const float *weight = splatColumnWeights.constData();
+                for (int i = 0; i < rows; ++i, weight += 4) {
+                    const float *line = reinterpret_cast<const float *>(
+                            intermediateBits + (y + i) * intermediateBytesPerLine);
+                    sum = add(sum, mul(loadChannels(line + 4 * x), loadChannels(weight)));
+                }
+                dst[x] = finishConvolution<PreserveAlpha>(sum, original[x]);
+            }
+        }
+    });
+}
+
+} // anonymous namespace
+
+QSvgFeConvolveMatrix::QSvgFeConvolveMatrix(QSvgNode *parent, const QString &input,
+                                           const QString &result, const QSvgRectF &rect,
+                                           const QSize &order, const QList<qreal> &kernel,
+                                           qreal divisor, qreal bias, const QPoint &target,
+                                           EdgeMode edgeMode, bool preserveAlpha)
+    : QSvgFeFilterPrimitive(parent, input, result, rect)
+    , m_order(order)
+    , m_kernel(kernel)
+    , m_divisor(divisor)
+    , m_bias(bias)
+    , m_target(target)
+    , m_edgeMode(edgeMode)
+    , m_preserveAlpha(preserveAlpha)
+{
+    Q_ASSERT(m_kernel.size() == m_order.width() * m_order.height());
+    prepareKernel();
+}
+
+QSvgNode::Type QSvgFeConvolveMatrix::type() const
+{
+    return QSvgNode::FeConvolvematrix;
+}
+
+/*!
+    \internal
+
+    Turns the kernel into the weights of the source pixels, and factors it
+    into a row and a column vector if it has rank one, like box, Gaussian
+    and Sobel kernels. A separable kernel of m x n takes m + n instead of
+    m * n multiplications per pixel.
+*/
+void QSvgFeConvolveMatrix::prepareKernel()
+{
+    const int columns = m_order.width();
+    const int rows = m_order.height();
+
+    qreal divisor = m_divisor;
+    if (divisor == 0) {
+        divisor = std::accumulate(m_kernel.cbegin(), m_kernel.cend(), qreal(0));
+        if (divisor == 0)
+            divisor = 1;
+    }
+
+    // The kernel is applied turned: its last entry weighs the pixel at the
+    // top left of the target
+    m_weights.resize(columns * rows);
+    qsizetype pivot = 0;
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < columns; ++j) {
+            const qsizetype index = i * columns + j;
+            m_weights[index] = float(m_kernel.at((rows - 1 - i) * columns + columns - 1 - j) / divisor);
+            if (qAbs(m_weights.at(index)) > qAbs(m_weights.at(pivot)))
+                pivot = index;
+        }
+    }
+
+    m_rowWeights.clear();
+    m_columnWeights.clear();
+    const float largest = qAbs(m_weights.at(pivot));
+    if (columns == 1 || rows == 1 || largest == 0)
+        return;
+
+    QList<float> rowWeights(columns);
+    QList<float> columnWeights(rows);
+    for (int j = 0; j < columns; ++j)
+        rowWeights[j] = m_weights.at(pivot / columns * columns + j) / m_weights.at(pivot);
+    for (int i = 0; i < rows; ++i)
+        columnWeights[i] = m_weights.at(i * columns + pivot % columns);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < columns; ++j) {
+            if (qAbs(m_weights.at(i * columns + j) - columnWeights.at(i) * rowWeights.at(j)) > largest * 1e-5f)
+                return;
+        }
+    }
+    m_rowWeights = std::move(rowWeights);
+    m_columnWeights = std::move(columnWeights);
+}
+
+QImage QSvgFeConvolveMatrix::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
+                                   const QRectF &itemBounds, const QRectF &filterBounds,
+                                   QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
+{
+    if (inputs.value(0).isNull())
+        return QImage();
+
+    // The kernel steps one pixel of the kernel space: kernelUnitLength is not supported
+    const QRectF localRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
+    const KernelSpace space(p->transform());
+    const QRect bufferRect = space.bufferRect(localRect, pool);
+    if (bufferRect.isEmpty())
+        return QImage();
+
+    QImage source = toKernelSpace(inputs.at(0), bufferRect, space, pool);
+    QImage padded;
+    QImage convolved;
+    if (source.isNull()
+        || !pool->allocate(bufferRect.size() + m_order - QSize(1, 1), &padded)
+        || !pool->allocate(bufferRect.size(), &convolved)) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QImage();
+    }
+    convolved.setOffset(bufferRect.topLeft());
+    padForConvolution(source, &padded, m_target.x(), m_target.y(), m_edgeMode, m_preserveAlpha);
+
+    const ConvolutionImages images = {
+        padded.constBits(), padded.bytesPerLine(),
+        source.constBits(), source.bytesPerLine(),
+        convolved.bits(), convolved.bytesPerLine(),
+        bufferRect.width(), bufferRect.height()
+    };
+    const float bias = float(m_bias * 255);
+
+    if (!m_rowWeights.isEmpty()) {
+        // Four floats per pixel, in the order of the channels
+        QImage intermediate;
+        if (!QImageIOHandler::allocateImage(QSize(bufferRect.width(), padded.height()),
+                                            QImage::Format_RGBA32FPx4_Premultiplied, &intermediate)) {
+            qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+            return QImage();
+        }
+        if (m_preserveAlpha) {
+            convolveSeparable<true>(images, m_order, m_rowWeights.constData(),
+                                    m_columnWeights.constData(), bias, &intermediate);
+        } else {
+            convolveSeparable<false>(images, m_order, m_rowWeights.constData(),
+                                     m_columnWeights.constData(), bias, &intermediate);
+        }
+    } else if (m_preserveAlpha) {
+        convolve<true>(images, m_order, m_weights.constData(), bias);
+    } else {
+        convolve<false>(images, m_order, m_weights.constData(), bias);
+    }
+    pool->recycle(std::move(padded));
+    pool->recycle(std::move(source));
+
+    const QRect clipRectGlob = pool->clipToRegion(
+            globalSubRegion(p, itemBounds, filterBounds, primitiveUnits, filterUnits).toRect());
+    if (clipRectGlob.isEmpty())
+        return QImage();
+
+    QImage result = fromKernelSpace(convolved, clipRectGlob, space, pool);
+    pool->recycle(std::move(convolved));
+    if (result.isNull()) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QImage();
+    }
+
+    clipToTransformedBounds(&result, p, localRect);
+    return result;
+}
+
+QMargins QSvgFeConvolveMatrix::footprint(QPainter *p, const QRectF &, QtSvg::UnitTypes) const
+{
+    if (m_edgeMode == EdgeMode::Wrap)
+        return QMargins(UnboundedFootprint, UnboundedFootprint, UnboundedFootprint, UnboundedFootprint);
+
+    // A pixel reads the kernel around it, placed by the target, in the kernel space
+    const KernelSpace space(p->transform());
+    return deviceMargins(space.rest, QRectF(-m_target.x(), -m_target.y(),
+                                            m_order.width() - 1, m_order.height() - 1), 2);
+}
+
+namespace {
+
+// One channel-wise minimum or maximum of pixels, which keeps premultiplied
+// pixels valid.
+template <bool Dilate>
+inline QRgb morphologyPixel(QRgb a, QRgb b)
+{
+#if defined(__SSE2__)
+    const __m128i va = _mm_cvtsi32_si128(int(a));
+    const __m128i vb = _mm_cvtsi32_si128(int(b));
+    return QRgb(_mm_cvtsi128_si32(Dilate ? _mm_max_epu8(va, vb) : _mm_min_epu8(va, vb)));
+#elif defined(__ARM_NEON__)
+    const uint8x8_t va = vreinterpret_u8_u32(vdup_n_u32(a));
+    const uint8x8_t vb = vreinterpret_u8_u32(vdup_n_u32(b));
+    return vget_lane_u32(vreinterpret_u32_u8(Dilate ? vmax_u8(va, vb) : vmin_u8(va, vb)), 0);
+#else
+    QRgb result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const QRgb ca = (a >> shift) & 0xff;
+        const QRgb cb = (b >> shift) & 0xff;
+        result |= (Dilate ? qMax(ca, cb) : qMin(ca, cb)) << shift;
+    }
+    return result;
+#endif
+}
+
+template <bool Dilate>
+void morphologySpan(const QRgb *a, const QRgb *b, QRgb *dst, int count)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         Dilate ? _mm_max_epu8(va, vb) : _mm_min_epu8(va, vb));
+    }
+#elif defined(__ARM_NEON__)
+    for (; i + 4 <= count; i += 4) {
+        const uint8x16_t va = vreinterpretq_u8_u32(vld1q_u32(a + i));
+        const uint8x16_t vb = vreinterpretq_u8_u32(vld1q_u32(b + i));
+        vst1q_u32(dst + i, vreinterpretq_u32_u8(Dilate ? vmaxq_u8(va, vb) : vminq_u8(va, vb)));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = morphologyPixel<Dilate>(a[i], b[i]);
+}
+
+// The van Herk/Gil-Werman algorithm: the padded input is cut into blocks of
+// the window size, and every window covers the end of one block and the
+// start of the next. With the running extremes from the start of each block
+// and from its end, every output pixel costs three operations whatever the
+// radius. Pixels outside of the input do not take part.
+template <bool Dilate>
+void morphologyRows(const QImage &source, QImage *target, int radius)
+{
+    const int width = source.width();
+    const int window = 2 * radius + 1;
+    const int paddedWidth = width + 2 * radius;
+    const QRgb identity = Dilate ? 0 : ~QRgb(0);
+    const uchar *sourceBits = source.constBits();
+    const qsizetype sourceBytesPerLine = source.bytesPerLine();
+    uchar *targetBits = target->bits();
+    const qsizetype targetBytesPerLine = target->bytesPerLine();
+
+    runSegmented(source.height(), qsizetype(paddedWidth) * source.height(), [&](int y0, int y1) {
+        QVarLengthArray<QRgb, 1024> padded(paddedWidth);
+        QVarLengthArray<QRgb, 1024> fromStart(paddedWidth);
+        QVarLengthArray<QRgb, 1024> fromEnd(paddedWidth);
+        std::fill(padded.begin(), padded.begin() + radius, identity);
+        std::fill(padded.end() - radius, padded.end(), identity);
+
+        for (int y = y0; y < y1; ++y) {
+            const QRgb *src = reinterpret_cast<const QRgb *>(sourceBits + y * sourceBytesPerLine);
+            std::copy(src, src + width, padded.begin() + radius);
+            for (int start = 0; start < paddedWidth; start += window) {
+                const int end = qMin(start + window, paddedWidth);
+                fromStart[start] = padded[start];
+                for (int x = start + 1; x < end; ++x)
+                    fromStart[x] = morphologyPixel<Dilate>(fromStart[x - 1], padded[x]);
+                fromEnd[end - 1] = padded[end - 1];
+                for (int x = end - 2; x >= start; --x)
+                    fromEnd[x] = morphologyPixel<Dilate>(fromEnd[x + 1], padded[x]);
+            }
+
+            QRgb *dst = reinterpret_cast<QRgb *>(targetBits + y * targetBytesPerLine);
+            for (int x = 0; x < width; ++x)
+                dst[x] = morphologyPixel<Dilate>(fromEnd[x], fromStart[x + window - 1]);
+        }
+    });
+}
+
+// The same along the columns, for strips of columns at once so that the
+// operations vectorize over neighboring pixels of a row.
+template <bool Dilate>
+void morphologyColumns(const QImage &source, QImage *target, int radius)
+{
+    constexpr int StripWidth = 64;
+    const int width = source.width();
+    const int height = source.height();
+    const int window = 2 * radius + 1;
+    const int paddedHeight = height + 2 * radius;
+    const int strips = (width + StripWidth - 1) / StripWidth;
+    const QRgb identity = Dilate ? 0 : ~QRgb(0);
+    const uchar *sourceBits = source.constBits();
+    const qsizetype sourceBytesPerLine = source.bytesPerLine();
+    uchar *targetBits = target->bits();
+    const qsizetype targetBytesPerLine = target->bytesPerLine();
+
+    runSegmented(strips, qsizetype(width) * paddedHeight, [&](int s0, int s1) {
+        QVarLengthArray<QRgb, StripWidth> identityLine(StripWidth);
+        std::fill(identityLine.begin(), identityLine.end(), identity);
+        QVarLengthArray<QRgb, 64 * StripWidth> fromStart(qsizetype(paddedHeight) * StripWidth);
+        QVarLengthArray<QRgb, 64 * StripWidth> fromEnd(qsizetype(paddedHeight) * StripWidth);
+
+        for (int strip = s0; strip < s1; ++strip) {
+            const int x0 = strip * StripWidth;
+            const int count = qMin(StripWidth, width - x0);
+            auto padded = [&](int y) {
+                if (y < radius || y >= radius + height)
+                    return identityLine.constData();
+                return reinterpret_cast<const QRgb *>(sourceBits + (y - radius) * sourceBytesPerLine) + x0;
+            };
+            auto line = [count](QVarLengthArray<QRgb, 64 * StripWidth> &lines, int y) {
+                return lines.data() + qsizetype(y) * count;
+            };
+
+            for (int start = 0; start < paddedHeight; start += window) {
+                const int end = qMin(start + window, paddedHeight);
+                std::copy(padded(start), padded(start) + count, line(fromStart, start));
+                for (int y = start + 1; y < end; ++y)
+                    morphologySpan<Dilate>(line(fromStart, y - 1), padded(y), line(fromStart, y), count);
+                std::copy(padded(end - 1), padded(end - 1) + count, line(fromEnd, end - 1));
+                for (int y = end - 2; y >= start; --y)
+                    morphologySpan<Dilate>(line(fromEnd, y + 1), padded(y), line(fromEnd, y), count);
+            }
+
+            for (int y = 0; y < height; ++y) {
+                QRgb *dst = reinterpret_cast<QRgb *>(targetBits + y * targetBytesPerLine) + x0;
+                morphologySpan<Dilate>(line(fromEnd, y), line(fromStart, y + window - 1), dst, count);
+            }
+        }
+    });
+}
+
+} // anonymous namespace
+
+QSvgFeMorphology::QSvgFeMorphology(QSvgNode *parent, const QString &input, const QString &result,
+                                   const QSvgRectF &rect, Operator op, qreal radiusX, qreal radiusY)
+    : QSvgFeFilterPrimitive(parent, input, result, rect)
+    , m_operator(op)
+    , m_radiusX(radiusX)
+    , m_radiusY(radiusY)
+{
+}
+
+QSvgNode::Type QSvgFeMorphology::type() const
+{
+    return QSvgNode::FeMorphology;
+}
+
+QSizeF QSvgFeMorphology::userRadius(const QRectF &itemBounds, QtSvg::UnitTypes primitiveUnits) const
+{
+    if (primitiveUnits == QtSvg::UnitTypes::objectBoundingBox)
+        return QSizeF(m_radiusX * itemBounds.width(), m_radiusY * itemBounds.height());
+    return QSizeF(m_radiusX, m_radiusY);
+}
+
+QImage QSvgFeMorphology::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
+                               const QRectF &itemBounds, const QRectF &filterBounds,
+                               QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
+{
+    if (inputs.value(0).isNull())
+        return QImage();
+
+    // A radius that is not positive disables the primitive
+    const QSizeF radius = userRadius(itemBounds, primitiveUnits);
+    if (radius.width() <= 0 || radius.height() <= 0)
+        return inputs.at(0).toImage();
+
+    const QRectF localRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
+    const KernelSpace space(p->transform());
+    const QRect bufferRect = space.bufferRect(localRect, pool);
+    if (bufferRect.isEmpty())
+        return QImage();
+
+    QImage source = toKernelSpace(inputs.at(0), bufferRect, space, pool);
+    QImage target;
+    if (source.isNull() || !pool->allocate(bufferRect.size(), &target)) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QImage();
+    }
+    target.setOffset(bufferRect.topLeft());
+
+    const bool dilate = m_operator == Operator::Dilate;
+    const int radiusX = qRound(radius.width() * space.scaleX);
+    const int radiusY = qRound(radius.height() * space.scaleY);
+    if (radiusX > 0) {
+        if (dilate)
+            morphologyRows<true>(source, &target, radiusX);
+        else
+            morphologyRows<false>(source, &target, radiusX);
+        source.swap(target);
+    }
+    if (radiusY > 0) {
+        if (dilate)
+            morphologyColumns<true>(source, &target, radiusY);
+        else
+            morphologyColumns<false>(source, &target, radiusY);
+        source.swap(target);
+    }
+    pool->recycle(std::move(target));
+
+    const QRect clipRectGlob = pool->clipToRegion(
+            globalSubRegion(p, itemBounds, filterBounds, primitiveUnits, filterUnits).toRect());
+    if (clipRectGlob.isEmpty())
+        return QImage();
+
+    QImage result = fromKernelSpace(source, clipRectGlob, space, pool);
+    pool->recycle(std::move(source));
+    if (result.isNull()) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QImage();
+    }
+
+    clipToTransformedBounds(&result, p, localRect);
+    return result;
+}
+
+QMargins QSvgFeMorphology::footprint(QPainter *p, const QRectF &itemBounds,
+                                     QtSvg::UnitTypes primitiveUnits) const
+{
+    const QSizeF radius = userRadius(itemBounds, primitiveUnits);
+    if (radius.width() <= 0 || radius.height() <= 0)
+        return QMargins();
+
+    return deviceMargins(p->transform(), QRectF(-radius.width(), -radius.height(),
+                                                2 * radius.width(), 2 * radius.height()), 2);
+}
+
+namespace {
+
+// The noise function of the reference implementation in the Filter Effects
+// specification, with its lattice of 256 points repeating every 4096 units.
+constexpr int PerlinN = 0x1000;
+constexpr int LatticeMask = 0xff;
+
+// Octaves beyond this contribute less than 1/2^15 and do not change any
+// 8-bit channel
+constexpr int MaxTurbulenceOctaves = 16;
+
+struct StitchInfo
+{
+    int width;
+    int height;
+    int wrapX;
+    int wrapY;
+};
+
+inline Channels absolute(Channels c)
+{
+#if defined(__SSE2__)
+    return _mm_andnot_ps(_mm_set1_ps(-0.f), c);
+#elif defined(__ARM_NEON__)
+    return vabsq_f32(c);
+#else
+    return { { qAbs(c.c[0]), qAbs(c.c[1]), qAbs(c.c[2]), qAbs(c.c[3]) } };
+#endif
+}
+
+inline Channels mix(Channels a, Channels b, float t)
+{
+    return add(mul(a, splat(1 - t)), mul(b, splat(t)));
+}
+
+// noise2() for the four channels at once: they share the lattice cell and
+// its interpolation weights, and only differ in the gradients
+Channels turbulenceNoise(const int *selector, const float *gradients,
+                         double vx, double vy, const StitchInfo *stitch)
+{
+    double t = vx + PerlinN;
+    int bx0 = int(t);
+    int bx1 = bx0 + 1;
+    const float rx0 = float(t - int(t));
+    t = vy + PerlinN;
+    int by0 = int(t);
+    int by1 = by0 + 1;
+    const float ry0 = float(t - int(t));
+
+    if (stitch) {
+        if (bx0 >= stitch->wrapX)
+            bx0 -= stitch->width;
+        if (bx1 >= stitch->wrapX)
+            bx1 -= stitch->width;
+        if (by0 >= stitch->wrapY)
+            by0 -= stitch->height;
+        if (by1 >= stitch->wrapY)
+            by1 -= stitch->height;
+    }
+
+    const int i = selector[bx0 & LatticeMask];
+    const int j = selector[bx1 & LatticeMask];
+    const float *q00 = gradients + 8 * selector[i + (by0 & LatticeMask)];
+    const float *q10 = gradients + 8 * selector[j + (by0 & LatticeMask)];
+    const float *q01 = gradients + 8 * selector[i + (by1 & LatticeMask)];
+    const float *q11 = gradients + 8 * selector[j + (by1 & LatticeMask)];
+
+    const Channels rx0s = splat(rx0);
+    const Channels rx1s = splat(rx0 - 1);
+    const Channels ry0s = splat(ry0);
+    const Channels ry1s = splat(ry0 - 1);
+    auto dot = [](Channels rx, Channels ry, const float *q) {
+        return add(mul(rx, loadChannels(q)), mul(ry, loadChannels(q + 4)));
+    };
+
+    const float sx = rx0 * rx0 * (3 - 2 * rx0);
+    const float sy = ry0 * ry0 * (3 - 2 * ry0);
+    const Channels a = mix(dot(rx0s, ry0s, q00), dot(rx1s, ry0s, q10), sx);
+    const Channels b = mix(dot(rx0s, ry1s, q01), dot(rx1s, ry1s, q11), sx);
+    return mix(a, b, sy);
+}
+
+// The spec's random number generator, a Park-Miller minimal standard
+constexpr int RandomM = 2147483647;
+constexpr int RandomA = 16807;
+constexpr int RandomQ = 127773;
+constexpr int RandomR = 2836;
+
+int turbulenceRandom(int seed)
+{
+    int result = RandomA * (seed % RandomQ) - RandomR * (seed / RandomQ);
+    if (result <= 0)
+        result += RandomM;
+    return result;
+}
+
+} // anonymous namespace
+
+QSvgFeTurbulence::QSvgFeTurbulence(QSvgNode *parent, const QString &input, const QString &result,
+                                   const QSvgRectF &rect, NoiseType noiseType,
+                                   qreal baseFrequencyX, qreal baseFrequencyY,
+                                   int numOctaves, qreal seed, bool stitchTiles)
+    : QSvgFeFilterPrimitive(parent, input, result, rect)
+    , m_noiseType(noiseType)
+    , m_baseFrequencyX(baseFrequencyX)
+    , m_baseFrequencyY(baseFrequencyY)
+    , m_numOctaves(numOctaves)
+    , m_stitchTiles(stitchTiles)
+{
+    prepareLattice(seed);
+}
+
+QSvgNode::Type QSvgFeTurbulence::type() const
+{
+    return QSvgNode::FeTurbulence;
+}
+
+QStringList QSvgFeTurbulence::inputs() const
+{
+    return {};
+}
+
+/*!
+    \internal
+
+    Builds the permutation and the gradients of the noise lattice from
+    \a seed, the way init() of the reference implementation does.
+*/
+void QSvgFeTurbulence::prepareLattice(qreal seed)
+{
+    // The seed is truncated towards zero
+    int random = int(qBound<qreal>(std::numeric_limits<int>::min() + 1, seed,
+                                   std::numeric_limits<int>::max()));
+    if (random <= 0)
+        random = -(random % (RandomM - 1)) + 1;
+    if (random > RandomM - 1)
+        random = RandomM - 1;
+
+    // Channels are stored in the order of their bits in a QRgb
+    constexpr int laneOfChannel[4] = { 2, 1, 0, 3 };
+    for (int channel = 0; channel < 4; ++channel) {
+        const int lane = laneOfChannel[channel];
+        for (int i = 0; i < LatticeSize; ++i) {
+            double gradient[2];
+            for (double &component : gradient) {
+                random = turbulenceRandom(random);
+                component = double(random % (2 * LatticeSize) - LatticeSize) / LatticeSize;
             }
-            a = qBound(0., a, 255.);
-            resultLine[i] = qRgba(qBound(0., r, a),
-                                  qBound(0., g, a),
-                                  qBound(0., b, a),
-                                  a);
+            const double length = qSqrt(gradient[0] * gradient[0] + gradient[1] * gradient[1]);
+            m_gradients[8 * i + lane] = float(gradient[0] / length);
+            m_gradients[8 * i + 4 + lane] = float(gradient[1] / length);
         }
     }
+
+    for (int i = 0; i < LatticeSize; ++i)
+        m_latticeSelector[i] = i;
+    for (int i = LatticeSize - 1; i > 0; --i) {
+        random = turbulenceRandom(random);
+        std::swap(m_latticeSelector[i], m_latticeSelector[random % LatticeSize]);
+    }
+
+    for (int i = 0; i < LatticeSize + 2; ++i) {
+        m_latticeSelector[LatticeSize + i] = m_latticeSelector[i];
+        std::copy_n(m_gradients.cbegin() + 8 * i, 8, m_gradients.begin() + 8 * (LatticeSize + i));
+    }
+}
+
+QImage QSvgFeTurbulence::apply(const QSvgFilterInputs &, QSvgFilterBufferPool *pool,
+                               QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
+                               QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
+{
+    const QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
+    const QRect clipRectGlob = pool->clipToRegion(p->transform().mapRect(clipRect).toRect());
+    if (clipRectGlob.isEmpty() || !p->transform().isInvertible())
+        return QImage();
+
+    // The cache follows the limit of the document's filter cache
+    const bool cacheable = document() && document()->filterCache()->isEnabled();
+    QMutexLocker locker(&m_cacheMutex);
+    if (cacheable && !m_cachedResult.isNull() && m_cachedTransform == p->transform()
+        && m_cachedSubRegion == clipRect
+        && QRect(m_cachedResult.offset(), m_cachedResult.size()) == clipRectGlob) {
+        return m_cachedResult;
+    }
+    locker.unlock();
+
+    QImage result;
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QImage();
+    }
+    result.setOffset(clipRectGlob.topLeft());
+
+    // With stitching, the frequencies are adjusted so that a whole number of
+    // lattice cells fits into the subregion, whose opposite edges then match
+    qreal baseFrequencyX = m_baseFrequencyX;
+    qreal baseFrequencyY = m_baseFrequencyY;
+    StitchInfo stitch = {};
+    if (m_stitchTiles) {
+        auto adjust = [](qreal frequency, qreal size) {
+            if (frequency == 0 || size <= 0)
+                return frequency;
+            const qreal low = qFloor(size * frequency) / size;
+            const qreal high = qCeil(size * frequency) / size;
+            return frequency / low < high / frequency ? low : high;
+        };
+        baseFrequencyX = adjust(baseFrequencyX, clipRect.width());
+        baseFrequencyY = adjust(baseFrequencyY, clipRect.height());
+        stitch.width = int(clipRect.width() * baseFrequencyX + 0.5);
+        stitch.wrapX = int(clipRect.x() * baseFrequencyX + PerlinN + stitch.width);
+        stitch.height = int(clipRect.height() * baseFrequencyY + 0.5);
+        stitch.wrapY = int(clipRect.y() * baseFrequencyY + PerlinN + stitch.height);
+    }
+
+    const bool fractalNoise = m_noiseType == NoiseType::FractalNoise;
+    const int octaves = qMin(m_numOctaves, MaxTurbulenceOctaves);
+    const int *selector = m_latticeSelector.data();
+    const float *gradients = m_gradients.data();
+
+    // The noise is defined in the user space: device pixels are mapped there
+    // and stepped through with the inverse transform
+    const QTransform inverse = p->transform().inverted();
+    const QPointF stepX = inverse.map(QPointF(1, 0)) - inverse.map(QPointF(0, 0));
+    const int width = clipRectGlob.width();
+    uchar *bits = result.bits();
+    const qsizetype bytesPerLine = result.bytesPerLine();
+
+    runSegmented(clipRectGlob.height(), qsizetype(width) * clipRectGlob.height() * octaves,
+                 [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(bits + y * bytesPerLine);
+            const QPointF start = inverse.map(QPointF(clipRectGlob.left(), clipRectGlob.top() + y));
+            for (int x = 0; x < width; ++x) {
+                const QPointF point = start + x * stepX;
+                double vx = point.x() * baseFrequencyX;
+                double vy = point.y() * baseFrequencyY;
+                StitchInfo octaveStitch = stitch;
+                Channels sum = splat(0.f);
+                float ratio = 1;
+                for (int octave = 0; octave < octaves; ++octave) {
+                    const Channels noise = turbulenceNoise(selector, gradients, vx, vy,
+                                                           m_stitchTiles ? &octaveStitch : nullptr);
+                    sum = add(sum, mul(fractalNoise ? noise : absolute(noise), splat(1 / ratio)));
+                    vx *= 2;
+                    vy *= 2;
+                    ratio *= 2;
+                    octaveStitch.width *= 2;
+                    octaveStitch.wrapX = 2 * octaveStitch.wrapX - PerlinN;
+                    octaveStitch.height *= 2;
+                    octaveStitch.wrapY = 2 * octaveStitch.wrapY - PerlinN;
+                }
+
+                // Fractal noise maps -1 to 1 onto the channel range, turbulence 0 to 1
+                if (fractalNoise)
+                    sum = mul(add(sum, splat(1.f)), splat(127.5f));
+                else
+                    sum = mul(sum, splat(255.f));
+                line[x] = qPremultiply(packPixel(bound(splat(0.f), sum, splat(255.f))));
+            }
+        }
+    });
+
     clipToTransformedBounds(&result, p, clipRect);
+
+    if (cacheable) {
+        locker.relock();
+        m_cachedTransform = p->transform();
+        m_cachedSubRegion = clipRect;
+        m_cachedResult = result;
+    }
+    return result;
+}
+
+namespace {
+
+using ChannelTables = std::array<const uchar *, 4>;
+
+// Maps the unpremultiplied channels of a color through the tables, which
+// are indexed by QSvgFeComponentTransfer::Channel.
+inline QRgb transferColor(const ChannelTables &tables, QRgb color)
+{
+    return qRgba(tables[0][qRed(color)], tables[1][qGreen(color)],
+                 tables[2][qBlue(color)], tables[3][qAlpha(color)]);
+}
+
+// The same for premultiplied pixels. Opaque pixels, the common case, need
+// neither unpremultiplying nor premultiplying.
+void transferSpan(const ChannelTables &tables, const QRgb *src, QRgb *dst, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        const QRgb pixel = src[x];
+        const QRgb mapped = transferColor(tables, qAlpha(pixel) == 255 ? pixel : qUnpremultiply(pixel));
+        dst[x] = qAlpha(mapped) == 255 ? mapped : qPremultiply(mapped);
+    }
+}
+
+struct ColorSpaceTables
+{
+    ColorSpaceTables()
+    {
+        for (int i = 0; i < 256; ++i) {
+            const qreal c = i / 255.;
+            const qreal linear = c <= 0.04045 ? c / 12.92 : qPow((c + 0.055) / 1.055, 2.4);
+            const qreal srgb = c <= 0.0031308 ? c * 12.92 : 1.055 * qPow(c, 1 / 2.4) - 0.055;
+            toLinear[i] = uchar(qRound(linear * 255));
+            toSRgb[i] = uchar(qRound(srgb * 255));
+            identity[i] = uchar(i);
+        }
+    }
+
+    ChannelTables tables(QtSvg::ColorSpace colorSpace) const
+    {
+        const uchar *color = colorSpace == QtSvg::ColorSpace::linearRGB ? toLinear.data()
+                                                                         : toSRgb.data();
+        return { color, color, color, identity.data() };
+    }
+
+    std::array<uchar, 256> toLinear;
+    std::array<uchar, 256> toSRgb;
+    std::array<uchar, 256> identity;
+};
+
+const ColorSpaceTables &colorSpaceTables()
+{
+    static const ColorSpaceTables tables;
+    return tables;
+}
+
+} // anonymous namespace
+
+/*!
+    \internal
+
+    Returns this result converted into \a colorSpace from the other color
+    space. Filters convert their source and their result at the boundaries
+    of the filter graph, so that the primitives themselves never do.
+*/
+QSvgFilterBuffer QSvgFilterBuffer::toColorSpace(QtSvg::ColorSpace colorSpace,
+                                                QSvgFilterBufferPool *pool) const
+{
+    const ChannelTables tables = colorSpaceTables().tables(colorSpace);
+    if (m_flood)
+        return flood(m_rect, QColor::fromRgba(transferColor(tables, m_color.rgba())));
+    if (m_image.isNull())
+        return *this;
+
+    QImage result;
+    if (!pool->allocate(m_image.size(), &result)) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QSvgFilterBuffer();
+    }
+    result.setOffset(offset());
+
+    const int width = m_image.width();
+    runSegmented(m_image.height(), qsizetype(width) * m_image.height(), [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            transferSpan(tables, reinterpret_cast<const QRgb *>(m_image.constScanLine(y)),
+                         reinterpret_cast<QRgb *>(result.scanLine(y)), width);
+        }
+    });
+    return QSvgFilterBuffer(result);
+}
+
+/*!
+    \internal
+
+    Returns \a color, which is given in sRGB, in the color space this
+    primitive operates in.
+*/
+QColor QSvgFeFilterPrimitive::colorInColorSpace(const QColor &color) const
+{
+    if (m_colorSpace == QtSvg::ColorSpace::sRGB)
+        return color;
+    const ChannelTables tables = colorSpaceTables().tables(m_colorSpace);
+    return QColor::fromRgba(transferColor(tables, color.rgba()));
+}
+
+QSvgFeComponentTransfer::QSvgFeComponentTransfer(QSvgNode *parent, const QString &input,
+                                                 const QString &result, const QSvgRectF &rect)
+    : QSvgFeFilterPrimitive(parent, input, result, rect)
+{
+    for (auto &table : m_tables)
+        std::iota(table.begin(), table.end(), 0);
+    m_identity.fill(true);
+}
+
+QSvgNode::Type QSvgFeComponentTransfer::type() const
+{
+    return QSvgNode::FeComponenttransfer;
+}
+
+/*!
+    \internal
+
+    Sets the transfer function of \a channel to \a function, which is
+    evaluated once for each of the 256 channel values.
+*/
+void QSvgFeComponentTransfer::setTransferFunction(Channel channel, const TransferFunction &function)
+{
+    const QList<qreal> &values = function.tableValues;
+    const qsizetype n = values.size();
+
+    std::array<uchar, 256> &table = m_tables[int(channel)];
+    for (int i = 0; i < 256; ++i) {
+        const qreal c = i / 255.;
+        qreal mapped = c;
+        switch (function.type) {
+        case FunctionType::Identity:
+            break;
+        case FunctionType::Table:
+            if (n == 1) {
+                mapped = values.at(0);
+            } else if (n > 1) {
+                const qsizetype k = qMin(qsizetype(c * (n - 1)), n - 2);
+                mapped = values.at(k) + (c * (n - 1) - k) * (values.at(k + 1) - values.at(k));
+            }
+            break;
+        case FunctionType::Discrete:
+            if (n > 0)
+                mapped = values.at(qMin(qsizetype(c * n), n - 1));
+            break;
+        case FunctionType::Linear:
+            mapped = function.slope * c + function.intercept;
+            break;
+        case FunctionType::Gamma:
+            mapped = function.amplitude * qPow(c, function.exponent) + function.offset;
+            break;
+        }
+        table[i] = uchar(qRound(qBound(0., mapped, 1.) * 255));
+    }
+
+    m_identity[int(channel)] = true;
+    for (int i = 0; i < 256; ++i)
+        m_identity[int(channel)] = m_identity[int(channel)] && table[i] == i;
+}
+
+bool QSvgFeComponentTransfer::isIdentity() const
+{
+    return std::all_of(m_identity.begin(), m_identity.end(), [](bool identity) { return identity; });
+}
+
+QImage QSvgFeComponentTransfer::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
+                                      QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
+                                      QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
+{
+    const QSvgFilterBuffer input = inputs.value(0);
+    const QImage source = input.isNull() ? QImage() : input.image();
+    const QPoint sourceOffset = input.offset();
+
+    QRect clipRectGlob = globalSubRegion(p, itemBounds, filterBounds, primitiveUnits, filterUnits).toRect();
+    clipRectGlob = pool->clipToRegion(clipRectGlob);
+    if (clipRectGlob.isEmpty())
+        return QImage();
+
+    QImage result;
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QImage();
+    }
+    result.setOffset(clipRectGlob.topLeft());
+
+    // Outside of the input, the functions apply to transparent black
+    const ChannelTables tables = { m_tables[0].data(), m_tables[1].data(),
+                                   m_tables[2].data(), m_tables[3].data() };
+    result.fill(qPremultiply(transferColor(tables, 0)));
+
+    const QRect span = QRect(sourceOffset, source.size()).intersected(clipRectGlob);
+    if (!span.isEmpty()) {
+        Q_ASSERT(source.depth() == 32);
+        const qsizetype sourceBytesPerLine = source.bytesPerLine();
+        const qsizetype resultBytesPerLine = result.bytesPerLine();
+        const uchar *sourceBits = source.constBits() + (span.top() - sourceOffset.y()) * sourceBytesPerLine
+                + (span.left() - sourceOffset.x()) * sizeof(QRgb);
+        uchar *resultBits = result.bits() + (span.top() - clipRectGlob.top()) * resultBytesPerLine
+                + (span.left() - clipRectGlob.left()) * sizeof(QRgb);
+        const int width = span.width();
+
+        runSegmented(span.height(), qsizetype(width) * span.height(), [&](int y0, int y1) {
+            for (int y = y0; y < y1; ++y) {
+                transferSpan(tables, reinterpret_cast<const QRgb *>(sourceBits + y * sourceBytesPerLine),
+                             reinterpret_cast<QRgb *>(resultBits + y * resultBytesPerLine), width);
+            }
+        });
+    }
+
+    clipToTransformedBounds(&result, p, localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits));
     return result;
 }
 
-bool QSvgFeBlend::requiresSourceAlpha() const
+/*!
+    \internal
+
+    Passes the input on unchanged if every function is the identity, and
+    maps the color of a flood input without turning it into pixels.
+*/
+bool QSvgFeComponentTransfer::applyWithoutBuffer(const QSvgFilterInputs &inputs, QPainter *p,
+                                                 const QRectF &, const QRectF &,
+                                                 QtSvg::UnitTypes, QtSvg::UnitTypes,
+                                                 QSvgFilterBuffer *output) const
+{
+    if (!hasDefaultSubRegion() || p->transform().type() > QTransform::TxScale)
+        return false;
+
+    const QSvgFilterBuffer input = inputs.value(0);
+    if (isIdentity()) {
+        *output = input;
+        return true;
+    }
+    if (!input.isFlood())
+        return false;
+
+    const ChannelTables tables = { m_tables[0].data(), m_tables[1].data(),
+                                   m_tables[2].data(), m_tables[3].data() };
+    *output = QSvgFilterBuffer::flood(input.rect(),
+                                      QColor::fromRgba(transferColor(tables, input.floodColor().rgba())));
+    return true;
+}
+
+namespace {
+
+// The premultiplied pixel scaled by alpha / 255
+inline QRgb multiplyPixel(QRgb pixel, uint alpha)
+{
+    uint rb = (pixel & 0xff00ff) * alpha;
+    rb = ((rb + ((rb >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+    uint ag = ((pixel >> 8) & 0xff00ff) * alpha;
+    ag = (ag + ((ag >> 8) & 0xff00ff) + 0x800080) & 0xff00ff00;
+    return ag | rb;
+}
+
+// The alpha channel within rect of source, whose top left corner is at offset
+QImage alphaChannel(const QImage &source, const QPoint &offset, const QRect &rect)
 {
-    if (QSvgFeFilterPrimitive::requiresSourceAlpha())
+    QImage alpha;
+    if (!QImageIOHandler::allocateImage(rect.size(), QImage::Format_Alpha8, &alpha))
+        return alpha;
+    alpha.fill(0);
+
+    const QRect span = QRect(offset, source.size()).intersected(rect);
+    if (span.isEmpty())
+        return alpha;
+
+    Q_ASSERT(source.depth() == 32);
+    const qsizetype sourceBytesPerLine = source.bytesPerLine();
+    const qsizetype alphaBytesPerLine = alpha.bytesPerLine();
+    const uchar *sourceBits = source.constBits() + (span.top() - offset.y()) * sourceBytesPerLine
+            + (span.left() - offset.x()) * sizeof(QRgb);
+    uchar *alphaBits = alpha.bits() + (span.top() - rect.top()) * alphaBytesPerLine
+            + span.left() - rect.left();
+    const int width = span.width();
+
+    runSegmented(span.height(), qsizetype(width) * span.height(), [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const QRgb *src = reinterpret_cast<const QRgb *>(sourceBits + y * sourceBytesPerLine);
+            uchar *dst = alphaBits + y * alphaBytesPerLine;
+            for (int x = 0; x < width; ++x)
+                dst[x] = qAlpha(src[x]);
+        }
+    });
+    return alpha;
+}
+
+// Blurs an alpha image in place, see gaussianBoxBlur()
+bool blurAlpha(QImage *alpha, qreal sigmaX, qreal sigmaY)
+{
+    if (sigmaX == 0 && sigmaY == 0)
         return true;
-    return m_input2 == QLatin1StringView("SourceAlpha");
+
+    QImage scratch;
+    if (!QImageIOHandler::allocateImage(alpha->size(), QImage::Format_Alpha8, &scratch))
+        return false;
+    gaussianBoxBlur(alpha, &scratch, sigmaX, sigmaY);
+    return true;
+}
+
+// Fills result with source drawn over the shadow alpha tinted with the
+// premultiplied color. The top left corners of the images are at their
+// offsets, and pixels outside of source and shadow are transparent.
+void composeDropShadow(QImage *result, const QImage &source, const QPoint &sourceOffset,
+                       const QImage &shadow, const QPoint &shadowOffset, QRgb color)
+{
+    const QRect target(result->offset(), result->size());
+    const QRect sourceRect = source.isNull() ? QRect() : QRect(sourceOffset, source.size());
+    const QRect shadowRect(shadowOffset, shadow.size());
+    const qsizetype resultBytesPerLine = result->bytesPerLine();
+    uchar *resultBits = result->bits();
+    const int width = target.width();
+
+    // The columns of a row covered by rect, in result coordinates
+    auto columns = [&](const QRect &rect) {
+        return std::pair(qBound(0, rect.left() - target.left(), width),
+                         qBound(0, rect.right() + 1 - target.left(), width));
+    };
+    const auto [shadowBegin, shadowEnd] = columns(shadowRect);
+    const auto [sourceBegin, sourceEnd] = columns(sourceRect);
+
+    runSegmented(target.height(), qsizetype(width) * target.height(), [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const int deviceY = y + target.top();
+            QRgb *dst = reinterpret_cast<QRgb *>(resultBits + y * resultBytesPerLine);
+            std::fill_n(dst, width, 0);
+
+            if (deviceY >= shadowRect.top() && deviceY <= shadowRect.bottom()) {
+                const uchar *line = shadow.constScanLine(deviceY - shadowRect.top());
+                const int delta = target.left() - shadowRect.left();
+                for (int x = shadowBegin; x < shadowEnd; ++x)
+                    dst[x] = multiplyPixel(color, line[x + delta]);
+            }
+
+            if (deviceY >= sourceRect.top() && deviceY <= sourceRect.bottom()) {
+                const QRgb *line = reinterpret_cast<const QRgb *>(
+                        source.constScanLine(deviceY - sourceRect.top()));
+                const int delta = target.left() - sourceRect.left();
+                for (int x = sourceBegin; x < sourceEnd; ++x) {
+                    const QRgb pixel = line[x + delta];
+                    const uint alpha = qAlpha(pixel);
+                    if (alpha == 255)
+                        dst[x] = pixel;
+                    else if (alpha != 0 || pixel != 0)
+                        dst[x] = pixel + multiplyPixel(dst[x], 255 - alpha);
+                }
+            }
+        }
+    });
+}
+
+} // anonymous namespace
+
+QSvgFeDropShadow::QSvgFeDropShadow(QSvgNode *parent, const QString &input, const QString &result,
+                                   const QSvgRectF &rect, qreal dx, qreal dy,
+                                   qreal stdDeviationX, qreal stdDeviationY, const QColor &color)
+    : QSvgFeFilterPrimitive(parent, input, result, rect)
+    , m_dx(dx)
+    , m_dy(dy)
+    , m_stdDeviationX(stdDeviationX)
+    , m_stdDeviationY(stdDeviationY)
+    , m_color(color)
+{
+
+}
+
+QSvgNode::Type QSvgFeDropShadow::type() const
+{
+    return QSvgNode::FeDropshadow;
+}
+
+/*!
+    \internal
+
+    Blurs only the alpha of the input, reads it at the offset instead of
+    moving it, and tints and composites it under the input while writing
+    the single result buffer. Large blurs are never approximated.
+*/
+QImage QSvgFeDropShadow::apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool, QPainter *p,
+                               const QRectF &itemBounds, const QRectF &filterBounds,
+                               QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const
+{
+    if (inputs.value(0).isNull())
+        return QImage();
+    const QSvgFilterBuffer &input = inputs.at(0);
+
+    qreal dx = m_dx;
+    qreal dy = m_dy;
+    qreal deviationX = m_stdDeviationX;
+    qreal deviationY = m_stdDeviationY;
+    if (primitiveUnits == QtSvg::UnitTypes::objectBoundingBox) {
+        dx *= itemBounds.width();
+        dy *= itemBounds.height();
+        deviationX *= itemBounds.width();
+        deviationY *= itemBounds.height();
+    }
+
+    const QRectF clipRect = localSubRegion(itemBounds, filterBounds, primitiveUnits, filterUnits);
+    const QRect clipRectGlob = pool->clipToRegion(p->transform().mapRect(clipRect).toRect());
+    if (clipRectGlob.isEmpty())
+        return QImage();
+
+    QImage result;
+    if (!pool->allocate(clipRectGlob.size(), &result)) {
+        qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+        return QImage();
+    }
+    result.setOffset(clipRectGlob.topLeft());
+
+    const QRgb color = qPremultiply(colorInColorSpace(m_color).rgba());
+    const QTransform &xf = p->transform();
+
+    if (xf.type() <= QTransform::TxScale && xf.m11() > 0 && xf.m22() > 0) {
+        // The blur can run on device pixels, and the shadow is only shifted
+        const QImage source = input.image();
+        QImage shadow = alphaChannel(source, input.offset(), clipRectGlob);
+        if (shadow.isNull() || !blurAlpha(&shadow, xf.m11() * deviationX, xf.m22() * deviationY)) {
+            qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+            pool->recycle(std::move(result));
+            return QImage();
+        }
+        const QPoint offset = (xf.map(QPointF(dx, dy)) - xf.map(QPointF(0, 0))).toPoint();
+        composeDropShadow(&result, source, input.offset(), shadow, clipRectGlob.topLeft() + offset, color);
+    } else {
+        // As for feGaussianBlur, blur in a space that is only scaled
+        // against user space, and map the tinted shadow into the result
+        const qreal scaleX = qHypot(xf.m11(), xf.m21());
+        const qreal scaleY = qHypot(xf.m12(), xf.m22());
+        const QTransform scaleXr = QTransform::fromScale(scaleX, scaleY);
+        const QTransform restXr = scaleXr.inverted() * xf;
+
+        QRect blurRect = scaleXr.mapRect(clipRect).toRect();
+        if (!pool->region().isNull())
+            blurRect &= restXr.inverted().mapRect(QRectF(pool->region())).toAlignedRect();
+
+        result.fill(Qt::transparent);
+        QPainter painter(&result);
+        painter.translate(-result.offset());
+        if (!blurRect.isEmpty()) {
+            QImage scaledSource;
+            if (!pool->allocate(blurRect.size(), &scaledSource)) {
+                qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+                return QImage();
+            }
+            scaledSource.fill(Qt::transparent);
+            QPainter copyPainter(&scaledSource);
+            copyPainter.translate(-blurRect.topLeft());
+            copyPainter.setTransform(restXr.inverted(), true);
+            input.draw(&copyPainter, QPoint());
+            copyPainter.end();
+
+            QImage shadow = alphaChannel(scaledSource, blurRect.topLeft(), blurRect);
+            if (shadow.isNull() || !blurAlpha(&shadow, scaleX * deviationX, scaleY * deviationY)) {
+                qCWarning(lcSvgDraw) << "The requested filter buffer is too big, ignoring";
+                return QImage();
+            }
+            scaledSource.setOffset(blurRect.topLeft());
+            const QPoint offset = QPointF(scaleX * dx, scaleY * dy).toPoint();
+            composeDropShadow(&scaledSource, QImage(), QPoint(), shadow, blurRect.topLeft() + offset, color);
+
+            painter.save();
+            painter.setRenderHint(QPainter::Antialiasing, true);
+            painter.setTransform(restXr, true);
+            painter.drawImage(blurRect.topLeft(), scaledSource);
+            painter.restore();
+            pool->recycle(std::move(scaledSource));
+        }
+        input.draw(&painter, QPoint());
+        painter.end();
+    }
+
+    clipToTransformedBounds(&result, p, clipRect);
+    return result;
+}
+
+/*!
+    \internal
+
+    A pixel depends on the input at the same position, and on the alpha
+    around the position the offset points back to.
+*/
+QMargins QSvgFeDropShadow::footprint(QPainter *p, const QRectF &itemBounds,
+                                     QtSvg::UnitTypes primitiveUnits) const
+{
+    qreal dx = m_dx;
+    qreal dy = m_dy;
+    qreal deviationX = m_stdDeviationX;
+    qreal deviationY = m_stdDeviationY;
+    if (primitiveUnits == QtSvg::UnitTypes::objectBoundingBox) {
+        dx *= itemBounds.width();
+        dy *= itemBounds.height();
+        deviationX *= itemBounds.width();
+        deviationY *= itemBounds.height();
+    }
+
+    return deviceMargins(p->transform(), QRectF(-dx - 3 * deviationX, -dy - 3 * deviationY,
+                                                6 * deviationX, 6 * deviationY), 3);
+}
+
+/*!
+    \internal
+
+    Recognizes the drop shadow idiom of SVG 1.1 in \a primitives, starting
+    at \a first: a blur and an offset of SourceAlpha, in either order, that
+    is optionally tinted by an feComposite "in" an feFlood, and then merged
+    under, or composited "over" by, SourceGraphic. Returns an equivalent
+    drop shadow of SourceGraphic and sets \a count to the number of
+    primitives it replaces, or returns \c nullptr if there is no match.
+
+    All primitives of the idiom need the default subregion and the same
+    color space, and no other primitive may read their intermediate results.
+*/
+QSvgFeDropShadow *QSvgFeDropShadow::fuse(QSvgNode *parent,
+                                         const QList<const QSvgFeFilterPrimitive *> &primitives,
+                                         qsizetype first, qsizetype *count)
+{
+    const QtSvg::ColorSpace colorSpace = primitives.at(first)->colorSpace();
+    qsizetype next = first;
+    auto take = [&](QSvgNode::Type type) -> const QSvgFeFilterPrimitive * {
+        if (next >= primitives.size())
+            return nullptr;
+        const QSvgFeFilterPrimitive *primitive = primitives.at(next);
+        if (primitive->type() != type || !primitive->hasDefaultSubRegion()
+            || primitive->colorSpace() != colorSpace) {
+            return nullptr;
+        }
+        ++next;
+        return primitive;
+    };
+    // Whether the input of the primitive at consumer is the result of the one at producer
+    auto reads = [&](const QString &input, qsizetype producer, qsizetype consumer) {
+        return input.isEmpty() ? consumer == producer + 1 : input == primitives.at(producer)->result();
+    };
+
+    const QSvgFeGaussianBlur *blur = nullptr;
+    const QSvgFeOffset *offset = nullptr;
+    if (const auto *primitive = take(QSvgNode::FeGaussianblur)) {
+        blur = static_cast<const QSvgFeGaussianBlur *>(primitive);
+        offset = static_cast<const QSvgFeOffset *>(take(QSvgNode::FeOffset));
+        if (!offset || blur->input() != QLatin1String("SourceAlpha") || !reads(offset->input(), first, first + 1))
+            return nullptr;
+    } else if (const auto *primitive = take(QSvgNode::FeOffset)) {
+        offset = static_cast<const QSvgFeOffset *>(primitive);
+        blur = static_cast<const QSvgFeGaussianBlur *>(take(QSvgNode::FeGaussianblur));
+        if (!blur || offset->input() != QLatin1String("SourceAlpha") || !reads(blur->input(), first, first + 1))
+            return nullptr;
+    } else {
+        return nullptr;
+    }
+
+    qsizetype shadow = first + 1;
+    QColor color(Qt::black);
+    if (const auto *flood = static_cast<const QSvgFeFlood *>(take(QSvgNode::FeFlood))) {
+        const auto *tint = static_cast<const QSvgFeComposite *>(take(QSvgNode::FeComposite));
+        if (!tint || tint->compositeOperator() != QSvgFeComposite::Operator::In
+            || !reads(tint->input(), shadow + 1, shadow + 2)
+            || tint->input2().isEmpty() || !reads(tint->input2(), shadow, shadow + 2)) {
+            return nullptr;
+        }
+        color = flood->color();
+        shadow += 2;
+    }
+
+    const QSvgFeFilterPrimitive *last = nullptr;
+    if (const auto *merge = take(QSvgNode::FeMerge)) {
+        const QStringList inputs = merge->inputs();
+        if (inputs.size() != 2 || !reads(inputs.at(0), shadow, shadow + 1)
+            || inputs.at(1) != QLatin1String("SourceGraphic")) {
+            return nullptr;
+        }
+        last = merge;
+    } else if (const auto *composite = static_cast<const QSvgFeComposite *>(take(QSvgNode::FeComposite))) {
+        if (composite->compositeOperator() != QSvgFeComposite::Operator::Over
+            || composite->input() != QLatin1String("SourceGraphic")
+            || !reads(composite->input2(), shadow, shadow + 1)) {
+            return nullptr;
+        }
+        last = composite;
+    } else {
+        return nullptr;
+    }
+
+    for (qsizetype i = next; i < primitives.size(); ++i) {
+        for (const QString &input : primitives.at(i)->inputs()) {
+            for (qsizetype j = first; j < next - 1; ++j) {
+                if (!input.isEmpty() && input == primitives.at(j)->result())
+                    return nullptr;
+            }
+        }
+    }
+
+    const QSvgRectF defaultSubRegion(QRectF(0, 0, 1.0, 1.0),
+                                     QtSvg::UnitTypes::unknown, QtSvg::UnitTypes::unknown,
+                                     QtSvg::UnitTypes::unknown, QtSvg::UnitTypes::unknown);
+    auto *dropShadow = new QSvgFeDropShadow(parent, QStringLiteral("SourceGraphic"), last->result(),
+                                            defaultSubRegion, offset->dx(), offset->dy(),
+                                            blur->stdDeviationX(), blur->stdDeviationY(), color);
+    dropShadow->setColorSpace(colorSpace);
+    *count = next - first;
+    return dropShadow;
 }
 
 QSvgFeUnsupported::QSvgFeUnsupported(QSvgNode *parent, const QString &input, const QString &result,
@@ -857,9 +3402,9 @@ QSvgNode::Type QSvgFeUnsupported::type() const
     return QSvgNode::FeUnsupported;
 }
 
-QImage QSvgFeUnsupported::apply(const QMap<QString, QImage> &,
-                          QPainter *, const QRectF &, const QRectF &,
-                          QtSvg::UnitTypes, QtSvg::UnitTypes) const
+QImage QSvgFeUnsupported::apply(const QSvgFilterInputs &, QSvgFilterBufferPool *,
+                                QPainter *, const QRectF &, const QRectF &,
+                                QtSvg::UnitTypes, QtSvg::UnitTypes) const
 {
     qCDebug(lcSvgDraw) << "Unsupported filter primitive should not be applied.";
     return QImage();
@@ -22,10 +22,63 @@
 
 #include "QtCore/qlist.h"
 #include "QtCore/qhash.h"
+#include "QtCore/qmargins.h"
+#include "QtCore/qmutex.h"
+#include "QtCore/qvarlengtharray.h"
+#include "QtGui/qimage.h"
+#include "QtGui/qtransform.h"
 #include "QtGui/qvector4d.h"
 
+#include <array>
+
 QT_BEGIN_NAMESPACE
 
+class QSvgFilterBufferPool;
+
+class Q_SVG_EXPORT QSvgFilterBuffer
+{
+public:
+    QSvgFilterBuffer() = default;
+    QSvgFilterBuffer(const QImage &image);
+    static QSvgFilterBuffer flood(const QRect &rect, const QColor &color);
+
+    bool isNull() const;
+    bool isFlood() const { return m_flood; }
+    QPoint offset() const { return m_rect.topLeft(); }
+    QRect rect() const { return m_rect; }
+    QColor floodColor() const { return m_color; }
+
+    QImage image() const;
+    QImage toImage() const;
+    void draw(QPainter *p, const QPoint &origin) const;
+    void translate(const QPoint &delta);
+    QSvgFilterBuffer toColorSpace(QtSvg::ColorSpace colorSpace, QSvgFilterBufferPool *pool) const;
+
+private:
+    QImage m_image;
+    QRect m_rect;
+    QColor m_color;
+    bool m_flood = false;
+};
+
+using QSvgFilterInputs = QVarLengthArray<QSvgFilterBuffer, 2>;
+
+class Q_SVG_EXPORT QSvgFilterBufferPool
+{
+public:
+    bool allocate(const QSize &size, QImage *image);
+    void recycle(QImage &&image);
+
+    void setRegion(const QRect &region) { m_region = region; }
+    QRect region() const { return m_region; }
+    QRect clipToRegion(const QRect &rect) const;
+
+private:
+    QMutex m_mutex;
+    QList<QImage> m_free;
+    QRect m_region;
+};
+
 class Q_SVG_EXPORT QSvgFeFilterPrimitive : public QSvgStructureNode
 {
 public:
@@ -41,10 +94,16 @@ public:
                            const QRectF &itemBounds, const QRectF &filterBounds,
                            QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const;
     void clipToTransformedBounds(QImage *buffer, QPainter *p, const QRectF &localRect) const;
-    virtual QImage apply(const QMap<QString, QImage> &sources,
+    virtual QStringList inputs() const;
+    virtual QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                          QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                          QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const = 0;
-    virtual bool requiresSourceAlpha() const;
+    virtual bool applyWithoutBuffer(const QSvgFilterInputs &inputs, QPainter *p,
+                                    const QRectF &itemBounds, const QRectF &filterBounds,
+                                    QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits,
+                                    QSvgFilterBuffer *output) const;
+    virtual QMargins footprint(QPainter *p, const QRectF &itemBounds,
+                               QtSvg::UnitTypes primitiveUnits) const;
     QString input() const {
         return m_input;
     }
@@ -52,12 +111,20 @@ public:
         return m_result;
     }
 
+    void setColorSpace(QtSvg::ColorSpace colorSpace) { m_colorSpace = colorSpace; }
+    QtSvg::ColorSpace colorSpace() const { return m_colorSpace; }
+
+    bool hasDefaultSubRegion() const;
+
     static const QSvgFeFilterPrimitive *castToFilterPrimitive(const QSvgNode *node);
 
 protected:
+    QColor colorInColorSpace(const QColor &color) const;
+
     QString m_input;
     QString m_result;
     QSvgRectF m_rect;
+    QtSvg::ColorSpace m_colorSpace = QtSvg::ColorSpace::linearRGB;
 
 
 };
@@ -78,11 +145,26 @@ public:
     QSvgFeColorMatrix(QSvgNode *parent, const QString &input, const QString &result,
                       const QSvgRectF &rect, ColorShiftType type, const Matrix &matrix);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+    bool applyWithoutBuffer(const QSvgFilterInputs &inputs, QPainter *p,
+                            const QRectF &itemBounds, const QRectF &filterBounds,
+                            QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits,
+                            QSvgFilterBuffer *output) const override;
 private:
+    enum class Kernel : quint8 {
+        Identity,
+        Rgb,
+        LuminanceToAlpha,
+        General
+    };
+
+    void prepareKernel();
+
     Matrix m_matrix;
+    std::array<float, 20> m_coefficients;
+    Kernel m_kernel = Kernel::General;
 };
 
 class Q_SVG_EXPORT QSvgFeGaussianBlur : public QSvgFeFilterPrimitive
@@ -98,9 +180,13 @@ public:
                        const QSvgRectF &rect, qreal stdDeviationX, qreal stdDeviationY,
                        EdgeMode edgemode);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+    QMargins footprint(QPainter *p, const QRectF &itemBounds,
+                       QtSvg::UnitTypes primitiveUnits) const override;
+    qreal stdDeviationX() const { return m_stdDeviationX; }
+    qreal stdDeviationY() const { return m_stdDeviationY; }
 private:
     qreal m_stdDeviationX;
     qreal m_stdDeviationY;
@@ -113,10 +199,20 @@ public:
     QSvgFeOffset(QSvgNode *parent, const QString &input, const QString &result,
                  const QSvgRectF &rect, qreal dx, qreal dy);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+    bool applyWithoutBuffer(const QSvgFilterInputs &inputs, QPainter *p,
+                            const QRectF &itemBounds, const QRectF &filterBounds,
+                            QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits,
+                            QSvgFilterBuffer *output) const override;
+    QMargins footprint(QPainter *p, const QRectF &itemBounds,
+                       QtSvg::UnitTypes primitiveUnits) const override;
+    qreal dx() const { return m_dx; }
+    qreal dy() const { return m_dy; }
 private:
+    QPoint deviceOffset(QPainter *p, const QRectF &itemBounds, QtSvg::UnitTypes primitiveUnits) const;
+
     qreal m_dx;
     qreal m_dy;
 };
@@ -127,10 +223,10 @@ public:
     QSvgFeMerge(QSvgNode *parent, const QString &input,
                 const QString &result, const QSvgRectF &rect);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
-    bool requiresSourceAlpha() const override;
+    QStringList inputs() const override;
 };
 
 class Q_SVG_EXPORT QSvgFeMergeNode : public QSvgFeFilterPrimitive
@@ -139,7 +235,7 @@ public:
     QSvgFeMergeNode(QSvgNode *parent, const QString &input,
                     const QString &result, const QSvgRectF &rect);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
 };
@@ -159,10 +255,12 @@ public:
     QSvgFeComposite(QSvgNode *parent, const QString &input, const QString &result,
                     const QSvgRectF &rect, const QString &input2, Operator op, const QVector4D &k);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
-    bool requiresSourceAlpha() const override;
+    QStringList inputs() const override;
+    QString input2() const { return m_input2; }
+    Operator compositeOperator() const { return m_operator; }
 private:
     QString m_input2;
     Operator m_operator;
@@ -175,9 +273,15 @@ public:
     QSvgFeFlood(QSvgNode *parent, const QString &input, const QString &result,
                 const QSvgRectF &rect, const QColor &color);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QStringList inputs() const override;
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+    bool applyWithoutBuffer(const QSvgFilterInputs &inputs, QPainter *p,
+                            const QRectF &itemBounds, const QRectF &filterBounds,
+                            QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits,
+                            QSvgFilterBuffer *output) const override;
+    QColor color() const { return m_color; }
 private:
     QColor m_color;
 };
@@ -195,23 +299,195 @@ public:
     QSvgFeBlend(QSvgNode *parent, const QString &input, const QString &result,
                 const QSvgRectF &rect, const QString &input2, Mode mode);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
-    bool requiresSourceAlpha() const override;
+    QStringList inputs() const override;
 private:
     QString m_input2;
     Mode m_mode;
 
 };
 
+class Q_SVG_EXPORT QSvgFeConvolveMatrix : public QSvgFeFilterPrimitive
+{
+public:
+    enum class EdgeMode : quint8 {
+        Duplicate,
+        Wrap,
+        None
+    };
+
+    QSvgFeConvolveMatrix(QSvgNode *parent, const QString &input, const QString &result,
+                         const QSvgRectF &rect, const QSize &order, const QList<qreal> &kernel,
+                         qreal divisor, qreal bias, const QPoint &target, EdgeMode edgeMode,
+                         bool preserveAlpha);
+    Type type() const override;
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
+                 QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
+                 QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+    QMargins footprint(QPainter *p, const QRectF &itemBounds,
+                       QtSvg::UnitTypes primitiveUnits) const override;
+private:
+    void prepareKernel();
+
+    QSize m_order;
+    QList<qreal> m_kernel;
+    qreal m_divisor;
+    qreal m_bias;
+    QPoint m_target;
+    EdgeMode m_edgeMode;
+    bool m_preserveAlpha;
+
+    // The kernel turned by 180 degrees and divided by the divisor, and the
+    // factors of its rows and columns if it is separable
+    QList<float> m_weights;
+    QList<float> m_rowWeights;
+    QList<float> m_columnWeights;
+};
+
+class Q_SVG_EXPORT QSvgFeMorphology : public QSvgFeFilterPrimitive
+{
+public:
+    enum class Operator : quint8 {
+        Erode,
+        Dilate
+    };
+
+    QSvgFeMorphology(QSvgNode *parent, const QString &input, const QString &result,
+                     const QSvgRectF &rect, Operator op, qreal radiusX, qreal radiusY);
+    Type type() const override;
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
+                 QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
+                 QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+    QMargins footprint(QPainter *p, const QRectF &itemBounds,
+                       QtSvg::UnitTypes primitiveUnits) const override;
+private:
+    QSizeF userRadius(const QRectF &itemBounds, QtSvg::UnitTypes primitiveUnits) const;
+
+    Operator m_operator;
+    qreal m_radiusX;
+    qreal m_radiusY;
+};
+
+class Q_SVG_EXPORT QSvgFeTurbulence : public QSvgFeFilterPrimitive
+{
+public:
+    enum class NoiseType : quint8 {
+        FractalNoise,
+        Turbulence
+    };
+
+    QSvgFeTurbulence(QSvgNode *parent, const QString &input, const QString &result,
+                     const QSvgRectF &rect, NoiseType noiseType, qreal baseFrequencyX,
+                     qreal baseFrequencyY, int numOctaves, qreal seed, bool stitchTiles);
+    Type type() const override;
+    QStringList inputs() const override;
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
+                 QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
+                 QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+private:
+    static constexpr int LatticeSize = 256;
+
+    void prepareLattice(qreal seed);
+
+    NoiseType m_noiseType;
+    qreal m_baseFrequencyX;
+    qreal m_baseFrequencyY;
+    int m_numOctaves;
+    bool m_stitchTiles;
+
+    // The permutation of the lattice, and the gradients at its points: the
+    // x components for the four channels, followed by the y components
+    std::array<int, 2 * LatticeSize + 2> m_latticeSelector;
+    std::array<float, 8 * (2 * LatticeSize + 2)> m_gradients;
+
+    // The noise only depends on where it is evaluated, so the last result is
+    // kept for the next render with the same transform and subregion
+    mutable QMutex m_cacheMutex;
+    mutable QTransform m_cachedTransform;
+    mutable QRectF m_cachedSubRegion;
+    mutable QImage m_cachedResult;
+};
+
+class Q_SVG_EXPORT QSvgFeComponentTransfer : public QSvgFeFilterPrimitive
+{
+public:
+    enum class Channel : quint8 {
+        Red,
+        Green,
+        Blue,
+        Alpha
+    };
+
+    enum class FunctionType : quint8 {
+        Identity,
+        Table,
+        Discrete,
+        Linear,
+        Gamma
+    };
+
+    struct TransferFunction {
+        FunctionType type = FunctionType::Identity;
+        QList<qreal> tableValues;
+        qreal slope = 1;
+        qreal intercept = 0;
+        qreal amplitude = 1;
+        qreal exponent = 1;
+        qreal offset = 0;
+    };
+
+    QSvgFeComponentTransfer(QSvgNode *parent, const QString &input, const QString &result,
+                            const QSvgRectF &rect);
+    Type type() const override;
+    void setTransferFunction(Channel channel, const TransferFunction &function);
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
+                 QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
+                 QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+    bool applyWithoutBuffer(const QSvgFilterInputs &inputs, QPainter *p,
+                            const QRectF &itemBounds, const QRectF &filterBounds,
+                            QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits,
+                            QSvgFilterBuffer *output) const override;
+private:
+    bool isIdentity() const;
+
+    // The function of every channel, evaluated for each unpremultiplied value
+    std::array<std::array<uchar, 256>, 4> m_tables;
+    std::array<bool, 4> m_identity;
+};
+
+class Q_SVG_EXPORT QSvgFeDropShadow : public QSvgFeFilterPrimitive
+{
+public:
+    QSvgFeDropShadow(QSvgNode *parent, const QString &input, const QString &result,
+                     const QSvgRectF &rect, qreal dx, qreal dy,
+                     qreal stdDeviationX, qreal stdDeviationY, const QColor &color);
+    Type type() const override;
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
+                 QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
+                 QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
+    QMargins footprint(QPainter *p, const QRectF &itemBounds,
+                       QtSvg::UnitTypes primitiveUnits) const override;
+
+    static QSvgFeDropShadow *fuse(QSvgNode *parent,
+                                  const QList<const QSvgFeFilterPrimitive *> &primitives,
+                                  qsizetype first, qsizetype *count);
+private:
+    qreal m_dx;
+    qreal m_dy;
+    qreal m_stdDeviationX;
+    qreal m_stdDeviationY;
+    QColor m_color;
+};
+
 class Q_SVG_EXPORT QSvgFeUnsupported : public QSvgFeFilterPrimitive
 {
 public:
     QSvgFeUnsupported(QSvgNode *parent, const QString &input,
                       const QString &result, const QSvgRectF &rect);
     Type type() const override;
-    QImage apply(const QMap<QString, QImage> &sources,
+    QImage apply(const QSvgFilterInputs &inputs, QSvgFilterBufferPool *pool,
                  QPainter *p, const QRectF &itemBounds, const QRectF &filterBounds,
                  QtSvg::UnitTypes primitiveUnits, QtSvg::UnitTypes filterUnits) const override;
 };
@@ -0,0 +1,255 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qsvgframesequence_p.h"
+#include "qsvgtinydocument_p.h"
+#include "qsvggraphics_p.h"
+#include "animation/qsvganimator_p.h"
+
+#include <QtCore/qmap.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthreadpool.h>
+#include <QtGui/qimageiohandler.h>
+#include <QtGui/qpainter.h>
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \internal
+    \class QSvgFrameSequenceExporter
+
+    Renders every frame of an animated SVG document into a QImage.
+
+    Frames are distributed over a thread pool. Each worker loads its own
+    copy of the document with QtSvg::AnimatorType::Controlled timing, so
+    that the animation state is never shared between threads. The frames
+    are handed to the sink one at a time and in frame order, from whichever
+    worker thread completes the next frame in sequence. The sink is called
+    without holding the lock, so that the other workers keep rendering
+    while it encodes or writes a frame.
+
+    The calling thread renders frames as one of the workers, so exporting
+    from a thread of the pool itself cannot wait for workers that never
+    start.
+*/
+
+namespace {
+
+struct ExportState
+{
+    QMutex mutex;
+    QMap<int, QImage> pending;
+    int nextToDeliver = 0;
+    bool delivering = false;
+    QAtomicInt nextFrame;
+    QAtomicInt failed;
+    QSemaphore inFlight;
+    QSemaphore done;
+};
+
+QImage renderFrame(QSvgTinyDocument *doc, qint64 time, const QSize &size)
+{
+    QImage image;
+    if (!QImageIOHandler::allocateImage(size, QImage::Format_ARGB32_Premultiplied, &image)) {
+        qCWarning(lcSvgDraw) << "The requested frame size is too big, ignoring";
+        return image;
+    }
+    image.fill(Qt::transparent);
+
+    if (QSharedPointer<QSvgAbstractAnimator> animator = doc->animator()) {
+        animator->setAnimatorTime(time);
+        animator->advanceAnimations();
+    }
+
+    QPainter p(&image);
+    doc->draw(&p, QRectF(QPointF(0, 0), size));
+    return image;
+}
+
+} // anonymous namespace
+
+QSvgFrameSequenceExporter::QSvgFrameSequenceExporter(const QByteArray &contents, QtSvg::Options options)
+    : m_contents(contents)
+    , m_options(options)
+{
+    std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(m_contents, m_options,
+                                                                 QtSvg::AnimatorType::Controlled));
+    if (!doc)
+        return;
+
+    m_valid = true;
+    m_documentSize = doc->size();
+    if (doc->animator())
+        m_documentDuration = doc->animationDuration();
+}
+
+bool QSvgFrameSequenceExporter::isValid() const
+{
+    return m_valid;
+}
+
+void QSvgFrameSequenceExporter::setFramesPerSecond(int fps)
+{
+    m_fps = qMax(1, fps);
+}
+
+int QSvgFrameSequenceExporter::framesPerSecond() const
+{
+    return m_fps;
+}
+
+/*!
+    \internal
+
+    Sets the exported time span to \a msecs. A negative value, the default,
+    exports the duration of the document's animations.
+*/
+void QSvgFrameSequenceExporter::setDuration(int msecs)
+{
+    m_duration = msecs;
+}
+
+int QSvgFrameSequenceExporter::duration() const
+{
+    return m_duration < 0 ? m_documentDuration : m_duration;
+}
+
+/*!
+    \internal
+
+    Sets the size of the rendered frames to \a size. An empty size, the
+    default, uses the document's own size.
+*/
+void QSvgFrameSequenceExporter::setSize(const QSize &size)
+{
+    m_size = size;
+}
+
+QSize QSvgFrameSequenceExporter::size() const
+{
+    return m_size.isEmpty() ? m_documentSize : m_size;
+}
+
+/*!
+    \internal
+
+    Sets the thread pool the frames are rendered on. If \a pool is null,
+    the default, QThreadPool::globalInstance() is used.
+*/
+void QSvgFrameSequenceExporter::setThreadPool(QThreadPool *pool)
+{
+    m_pool = pool;
+}
+
+QThreadPool *QSvgFrameSequenceExporter::threadPool() const
+{
+    return m_pool ? m_pool : QThreadPool::globalInstance();
+}
+
+int QSvgFrameSequenceExporter::frameCount() const
+{
+    const qint64 frames = (qint64(duration()) * m_fps + 999) / 1000;
+    return int(qBound<qint64>(1, frames, std::numeric_limits<int>::max()));
+}
+
+/*!
+    \internal
+
+    Renders all frames and passes them to \a sink. Blocks until the last
+    frame was delivered. Returns \c false if the document could not be
+    loaded or if any frame failed to render.
+
+    At most two frames per worker are kept in memory while waiting for
+    earlier frames to be delivered.
+*/
+bool QSvgFrameSequenceExporter::exportFrames(const FrameSink &sink) const
+{
+    if (!m_valid || !sink)
+        return false;
+
+    const int frames = frameCount();
+    const QSize frameSize = size();
+    QThreadPool *pool = threadPool();
+    const int workers = qBound(1, pool->maxThreadCount(), frames);
+
+    ExportState state;
+    state.inFlight.release(2 * workers);
+
+    auto deliver = [&](int frame, const QImage &image) {
+        QMutexLocker locker(&state.mutex);
+        state.pending.insert(frame, image);
+
+        // Only one worker delivers at a time, which keeps the frames in order.
+        // Frames that become ready meanwhile are picked up by its loop.
+        if (state.delivering)
+            return;
+        state.delivering = true;
+        while (!state.pending.isEmpty() && state.pending.firstKey() == state.nextToDeliver) {
+            const int next = state.nextToDeliver;
+            const QImage ready = state.pending.take(next);
+            locker.unlock();
+            sink(next, ready);
+            locker.relock();
+            ++state.nextToDeliver;
+            state.inFlight.release();
+        }
+        state.delivering = false;
+    };
+
+    auto work = [&]() {
+        std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(m_contents, m_options,
+                                                                     QtSvg::AnimatorType::Controlled));
+        if (!doc) {
+            state.failed.storeRelaxed(1);
+            state.done.release();
+            return;
+        }
+        if (m_options.testFlag(QtSvg::BakeAnimations) && doc->animator())
+            doc->animator()->bakeAnimations(m_fps);
+
+        // Frames are claimed in increasing order, so every frame before a
+        // claimed one is already being rendered and delivery cannot stall.
+        forever {
+            state.inFlight.acquire();
+            const int frame = state.nextFrame.fetchAndAddRelaxed(1);
+            if (frame >= frames) {
+                state.inFlight.release();
+                break;
+            }
+
+            const qint64 time = qint64(frame) * 1000 / m_fps;
+            const QImage image = renderFrame(doc.get(), time, frameSize);
+            if (image.isNull())
+                state.failed.storeRelaxed(1);
+            deliver(frame, image);
+        }
+        state.done.release();
+    };
+
+    std::vector<std::unique_ptr<QRunnable>> runnables;
+    for (int i = 1; i < workers; ++i) {
+        runnables.emplace_back(QRunnable::create(work));
+        runnables.back()->setAutoDelete(false);
+        pool->start(runnables.back().get());
+    }
+    work();
+
+    // All frames are rendered by now. Workers the pool has not started are
+    // not needed, and may never start if this thread belongs to the pool.
+    int started = workers;
+    for (const auto &runnable : runnables) {
+        if (pool->tryTake(runnable.get()))
+            --started;
+    }
+    state.done.acquire(started);
+
+    return !state.failed.loadRelaxed() && state.nextToDeliver == frames;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,67 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSVGFRAMESEQUENCE_P_H
+#define QSVGFRAMESEQUENCE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtSvg/private/qtsvgglobal_p.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qsize.h>
+#include <QtGui/qimage.h>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+class QThreadPool;
+
+class Q_SVG_EXPORT QSvgFrameSequenceExporter
+{
+public:
+    using FrameSink = std::function<void(int frame, const QImage &image)>;
+
+    explicit QSvgFrameSequenceExporter(const QByteArray &contents, QtSvg::Options options = {});
+
+    bool isValid() const;
+
+    void setFramesPerSecond(int fps);
+    int framesPerSecond() const;
+
+    void setDuration(int msecs);
+    int duration() const;
+
+    void setSize(const QSize &size);
+    QSize size() const;
+
+    void setThreadPool(QThreadPool *pool);
+    QThreadPool *threadPool() const;
+
+    int frameCount() const;
+    bool exportFrames(const FrameSink &sink) const;
+
+private:
+    QByteArray m_contents;
+    QtSvg::Options m_options;
+    int m_fps = 30;
+    int m_duration = -1;
+    int m_documentDuration = 0;
+    QSize m_size;
+    QSize m_documentSize;
+    QThreadPool *m_pool = nullptr;
+    bool m_valid = false;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSVGFRAMESEQUENCE_P_H
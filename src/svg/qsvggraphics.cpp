@@ -4,10 +4,13 @@
 #include "qsvggraphics_p.h"
 #include "qsvgstructure_p.h"
 #include "qsvgfont_p.h"
+#include "qsvgtinydocument_p.h"
 
 #include <qabstracttextdocumentlayout.h>
 #include <qdebug.h>
+#include <qimageiohandler.h>
 #include <qloggingcategory.h>
+#include <qpaintengine.h>
 #include <qpainter.h>
 #include <qscopedvaluerollback.h>
 #include <qtextcursor.h>
@@ -28,6 +31,52 @@ Q_LOGGING_CATEGORY(lcSvgDraw, "qt.svg.draw")
 #define QT_SVG_MAX_LAYOUT_SIZE (qint64(QFIXED_MAX / 2))
 #endif
 
+namespace {
+
+// The direction that bisects the corner at p1, for mid markers
+qreal meanAngle(QPointF p0, QPointF p1, QPointF p2)
+{
+    QPointF t1 = p1 - p0;
+    QPointF t2 = p2 - p1;
+    qreal hyp1 = hypot(t1.x(), t1.y());
+    if (hyp1 > 0)
+        t1 /= hyp1;
+    else
+        return 0.;
+    qreal hyp2 = hypot(t2.x(), t2.y());
+    if (hyp2 > 0)
+        t2 /= hyp2;
+    else
+        return 0.;
+    QPointF tangent = t1 + t2;
+    return -atan2(tangent.y(), tangent.x()) / M_PI * 180.;
+}
+
+QList<QSvgNode::MarkerVertex> polygonMarkerVertices(const QSvgNode *node, const QPolygonF &poly)
+{
+    using MarkerKind = QSvgNode::MarkerKind;
+    QList<QSvgNode::MarkerVertex> vertices;
+    if (poly.size() < 2)
+        return vertices;
+
+    if (node->hasMarkerStart())
+        vertices.append({ poly.first(), QLineF(poly.at(0), poly.at(1)).angle(), MarkerKind::Start });
+    if (node->hasMarkerMid()) {
+        vertices.reserve(vertices.size() + poly.size());
+        for (int i = 1; i < poly.size() - 1; i++) {
+            vertices.append({ poly.at(i), meanAngle(poly.at(i - 1), poly.at(i), poly.at(i + 1)),
+                              MarkerKind::Mid });
+        }
+    }
+    if (node->hasMarkerEnd()) {
+        vertices.append({ poly.last(), QLineF(poly.at(poly.size() - 2), poly.last()).angle(),
+                          MarkerKind::End });
+    }
+    return vertices;
+}
+
+} // anonymous namespace
+
 void QSvgDummyNode::drawCommand(QPainter *, QSvgExtraStates &)
 {
     qWarning("Dummy node not meant to be drawn");
@@ -58,13 +107,14 @@ QRectF QSvgEllipse::decoratedInternalBounds(QPainter *p, QSvgExtraStates &) cons
     path.addEllipse(m_bounds);
     qreal sw = strokeWidth(p);
     QRectF rect = qFuzzyIsNull(sw) ? p->transform().map(path).boundingRect()
-                                   : boundsOnStroke(p, path, sw, BoundsMode::IncludeMiterLimit);
+                                   : strokeBounds(p, path, sw, BoundsMode::IncludeMiterLimit);
     return filterRegion(rect);
 }
 
 void QSvgEllipse::drawCommand(QPainter *p, QSvgExtraStates &)
 {
-    p->drawEllipse(m_bounds);
+    if (p->brush().style() != Qt::NoBrush || !drawCachedStroke(p))
+        p->drawEllipse(m_bounds);
 }
 
 bool QSvgEllipse::separateFillStroke() const
@@ -72,6 +122,12 @@ bool QSvgEllipse::separateFillStroke() const
     return true;
 }
 
+bool QSvgEllipse::geometry(QPainterPath *path) const
+{
+    path->addEllipse(m_bounds);
+    return true;
+}
+
 QSvgImage::QSvgImage(QSvgNode *parent,
                      const QImage &image,
                      const QString &filename,
@@ -92,6 +148,11 @@ void QSvgImage::drawCommand(QPainter *p, QSvgExtraStates &)
     p->drawImage(m_bounds, m_image);
 }
 
+bool QSvgImage::canFoldOpacity(QPainter *, QSvgExtraStates &) const
+{
+    return true;
+}
+
 QSvgLine::QSvgLine(QSvgNode *parent, const QLineF &line)
     : QSvgNode(parent), m_line(line)
 {
@@ -108,6 +169,22 @@ void QSvgLine::drawCommand(QPainter *p, QSvgExtraStates &states)
     QSvgMarker::drawMarkersForNode(this, p, states);
 }
 
+QList<QSvgNode::MarkerVertex> QSvgLine::computeMarkerVertices() const
+{
+    QList<MarkerVertex> vertices;
+    if (hasMarkerStart())
+        vertices.append({ m_line.p1(), m_line.angle(), MarkerKind::Start });
+    if (hasMarkerEnd())
+        vertices.append({ m_line.p2(), m_line.angle(), MarkerKind::End });
+    return vertices;
+}
+
+bool QSvgLine::geometry(QPainterPath *) const
+{
+    // A line encloses no area
+    return true;
+}
+
 QSvgPath::QSvgPath(QSvgNode *parent, const QPainterPath &qpath)
     : QSvgNode(parent), m_path(qpath)
 {
@@ -116,7 +193,8 @@ QSvgPath::QSvgPath(QSvgNode *parent, const QPainterPath &qpath)
 void QSvgPath::drawCommand(QPainter *p, QSvgExtraStates &states)
 {
     m_path.setFillRule(states.fillRule);
-    p->drawPath(m_path);
+    if (p->brush().style() != Qt::NoBrush || !drawCachedStroke(p))
+        p->drawPath(m_path);
     QSvgMarker::drawMarkersForNode(this, p, states);
 }
 
@@ -125,6 +203,37 @@ bool QSvgPath::separateFillStroke() const
     return true;
 }
 
+bool QSvgPath::geometry(QPainterPath *path) const
+{
+    *path = m_path;
+    return true;
+}
+
+QList<QSvgNode::MarkerVertex> QSvgPath::computeMarkerVertices() const
+{
+    QList<MarkerVertex> vertices;
+    if (hasMarkerStart())
+        vertices.append({ m_path.pointAtPercent(0.), m_path.angleAtPercent(0.), MarkerKind::Start });
+    if (hasMarkerMid()) {
+        for (int i = 1; i < m_path.elementCount() - 1; i++) {
+            const QPainterPath::Element &e = m_path.elementAt(i);
+            if (e.type == QPainterPath::MoveToElement || e.type == QPainterPath::CurveToElement)
+                continue;
+            if ((e.type == QPainterPath::CurveToDataElement
+                 && m_path.elementAt(i + 1).type != QPainterPath::CurveToDataElement)
+                || e.type == QPainterPath::LineToElement) {
+                const QPointF p0 = m_path.elementAt(i - 1);
+                const QPointF p1 = e;
+                const QPointF p2 = m_path.elementAt(i + 1);
+                vertices.append({ p1, meanAngle(p0, p1, p2), MarkerKind::Mid });
+            }
+        }
+    }
+    if (hasMarkerEnd())
+        vertices.append({ m_path.pointAtPercent(1.), m_path.angleAtPercent(1.), MarkerKind::End });
+    return vertices;
+}
+
 QRectF QSvgPath::internalFastBounds(QPainter *p, QSvgExtraStates &) const
 {
     return p->transform().mapRect(m_path.controlPointRect());
@@ -141,7 +250,7 @@ QRectF QSvgPath::decoratedInternalBounds(QPainter *p, QSvgExtraStates &s) const
 {
     qreal sw = strokeWidth(p);
     QRectF rect = qFuzzyIsNull(sw) ? p->transform().map(m_path).boundingRect()
-                                   : boundsOnStroke(p, m_path, sw, BoundsMode::IncludeMiterLimit);
+                                   : strokeBounds(p, m_path, sw, BoundsMode::IncludeMiterLimit);
     rect |= QSvgMarker::markersBoundsForNode(this, p, s);
     return filterRegion(rect);
 }
@@ -186,13 +295,14 @@ QRectF QSvgPolygon::internalBounds(QPainter *p, QSvgExtraStates &, BoundsMode mo
     } else {
         QPainterPath path;
         path.addPolygon(m_poly);
-        return boundsOnStroke(p, path, sw, mode);
+        return strokeBounds(p, path, sw, mode);
     }
 }
 
 void QSvgPolygon::drawCommand(QPainter *p, QSvgExtraStates &states)
 {
-    p->drawPolygon(m_poly, states.fillRule);
+    if (p->brush().style() != Qt::NoBrush || !drawCachedStroke(p))
+        p->drawPolygon(m_poly, states.fillRule);
     QSvgMarker::drawMarkersForNode(this, p, states);
 }
 
@@ -201,6 +311,18 @@ bool QSvgPolygon::separateFillStroke() const
     return true;
 }
 
+QList<QSvgNode::MarkerVertex> QSvgPolygon::computeMarkerVertices() const
+{
+    return polygonMarkerVertices(this, m_poly);
+}
+
+bool QSvgPolygon::geometry(QPainterPath *path) const
+{
+    path->addPolygon(m_poly);
+    path->closeSubpath();
+    return true;
+}
+
 QSvgPolyline::QSvgPolyline(QSvgNode *parent, const QPolygonF &poly)
     : QSvgNode(parent), m_poly(poly)
 {
@@ -212,7 +334,8 @@ void QSvgPolyline::drawCommand(QPainter *p, QSvgExtraStates &states)
     if (p->brush().style() != Qt::NoBrush) {
         p->drawPolygon(m_poly, states.fillRule);
     } else {
-        p->drawPolyline(m_poly);
+        if (!drawCachedStroke(p))
+            p->drawPolyline(m_poly);
         QSvgMarker::drawMarkersForNode(this, p, states);
     }
 }
@@ -222,6 +345,24 @@ bool QSvgPolyline::separateFillStroke() const
     return true;
 }
 
+bool QSvgPolyline::geometry(QPainterPath *path) const
+{
+    path->addPolygon(m_poly);
+    path->closeSubpath();
+    return true;
+}
+
+QList<QSvgNode::MarkerVertex> QSvgPolyline::computeMarkerVertices() const
+{
+    return polygonMarkerVertices(this, m_poly);
+}
+
+bool QSvgPolyline::strokeGeometry(QPainterPath *path) const
+{
+    path->addPolygon(m_poly);
+    return true;
+}
+
 QSvgRect::QSvgRect(QSvgNode *node, const QRectF &rect, qreal rx, qreal ry)
     : QSvgNode(node),
       m_rect(rect), m_rx(rx), m_ry(ry)
@@ -251,12 +392,14 @@ QRectF QSvgRect::internalBounds(QPainter *p, QSvgExtraStates &, BoundsMode mode)
     } else {
         QPainterPath path;
         path.addRect(m_rect);
-        return boundsOnStroke(p, path, sw, mode);
+        return strokeBounds(p, path, sw, mode);
     }
 }
 
 void QSvgRect::drawCommand(QPainter *p, QSvgExtraStates &)
 {
+    if (p->brush().style() == Qt::NoBrush && drawCachedStroke(p))
+        return;
     if (m_rx || m_ry)
         p->drawRoundedRect(m_rect, m_rx, m_ry, Qt::RelativeSize);
     else
@@ -268,6 +411,15 @@ bool QSvgRect::separateFillStroke() const
     return true;
 }
 
+bool QSvgRect::geometry(QPainterPath *path) const
+{
+    if (m_rx || m_ry)
+        path->addRoundedRect(m_rect, m_rx, m_ry, Qt::RelativeSize);
+    else
+        path->addRect(m_rect);
+    return true;
+}
+
 QSvgTspan * const QSvgText::LINEBREAK = 0;
 
 QSvgText::QSvgText(QSvgNode *parent, const QPointF &coord)
@@ -568,7 +720,8 @@ void QSvgUse::drawCommand(QPainter *p, QSvgExtraStates &states)
     {
         QScopedValueRollback<int> useLevelGuard(states.nestedUseLevel, states.nestedUseLevel + 1);
         QScopedValueRollback<bool> recursingGuard(m_recursing, true);
-        m_link->draw(p, states);
+        if (!drawCached(p, states))
+            m_link->draw(p, states);
     }
     if (states.nestedUseLevel == 0)
         states.nestedUseCount = 0;
@@ -578,6 +731,97 @@ void QSvgUse::drawCommand(QPainter *p, QSvgExtraStates &states)
     }
 }
 
+// Rasters are positioned in quarter pixels, in int
+static constexpr qreal MaxCachedUseCoordinate = 1 << 28;
+// Larger targets are drawn directly
+static constexpr int MaxCachedUseSize = 1024;
+
+/*!
+    \internal
+
+    Draws the target by blitting a raster of it from the document's
+    \c{<use>} cache, rendering and keeping it first on a miss. The device
+    translation is rounded to a quarter pixel, so that a raster is reused by
+    every reference with the same scale and sub-pixel phase.
+
+    Returns \c false, without drawing, if the target has to be drawn as is:
+    the cache is disabled, \a p does not rasterize or composites with a
+    mode other than source over, the target is animated or too large, or
+    the transform is a perspective one.
+*/
+bool QSvgUse::drawCached(QPainter *p, QSvgExtraStates &states)
+{
+    QSvgUseCache *cache = document()->useCache();
+    if (!cache->isEnabled() || !p->paintEngine()
+        || p->paintEngine()->type() != QPaintEngine::Raster
+        || p->compositionMode() != QPainter::CompositionMode_SourceOver) {
+        return false;
+    }
+
+    const QTransform xf = p->transform();
+    if (xf.type() == QTransform::TxProject || !qIsFinite(xf.dx()) || !qIsFinite(xf.dy())
+        || qAbs(xf.dx()) > MaxCachedUseCoordinate || qAbs(xf.dy()) > MaxCachedUseCoordinate) {
+        return false;
+    }
+    if (!cache->isCacheable(m_link))
+        return false;
+
+    const int originX = qRound(xf.dx() * 4);
+    const int originY = qRound(xf.dy() * 4);
+    const QTransform transform(xf.m11(), xf.m12(), xf.m21(), xf.m22(),
+                               (originX & 3) / 4.0, (originY & 3) / 4.0);
+
+    QImage raster;
+    if (!cache->find(m_link, transform, p, states, &raster)) {
+        raster = renderCached(p, states, transform);
+        if (raster.isNull())
+            return false;
+        cache->insert(m_link, transform, p, states, raster);
+    }
+
+    // The painter opacity is part of the raster
+    p->save();
+    p->resetTransform();
+    p->setOpacity(1);
+    p->drawImage(QPoint(originX >> 2, originY >> 2) + raster.offset(), raster);
+    p->restore();
+    return true;
+}
+
+/*!
+    \internal
+
+    Renders the target with \a transform into an image with the offset of
+    its top left corner from the origin, in the state of \a p and
+    \a states. Returns a null image if the target is empty or too large.
+*/
+QImage QSvgUse::renderCached(QPainter *p, QSvgExtraStates &states, const QTransform &transform)
+{
+    const QTransform xf = p->transform();
+    p->setTransform(transform);
+    const QRectF bounds = m_link->decoratedBounds(p, states);
+    p->setTransform(xf);
+
+    QImage raster;
+    const QRect rect = bounds.toAlignedRect().adjusted(-1, -1, 1, 1);
+    if (bounds.isEmpty() || rect.width() > MaxCachedUseSize || rect.height() > MaxCachedUseSize)
+        return raster;
+    if (!QImageIOHandler::allocateImage(rect.size(), QImage::Format_ARGB32_Premultiplied, &raster))
+        return raster;
+    raster.setOffset(rect.topLeft());
+    raster.fill(Qt::transparent);
+
+    QPainter rasterPainter(&raster);
+    rasterPainter.setPen(p->pen());
+    rasterPainter.setBrush(p->brush());
+    rasterPainter.setFont(p->font());
+    rasterPainter.setRenderHints(p->renderHints());
+    rasterPainter.setOpacity(p->opacity());
+    rasterPainter.setTransform(transform * QTransform::fromTranslate(-rect.left(), -rect.top()));
+    m_link->draw(&rasterPainter, states);
+    return raster;
+}
+
 QSvgNode::Type QSvgDummyNode::type() const
 {
     return FeUnsupported;
@@ -692,7 +936,7 @@ QRectF QSvgPolyline::internalBounds(QPainter *p, QSvgExtraStates &, BoundsMode m
     } else {
         QPainterPath path;
         path.addPolygon(m_poly);
-        return boundsOnStroke(p, path, sw, mode);
+        return strokeBounds(p, path, sw, mode);
     }
 }
 
@@ -729,6 +973,11 @@ bool QSvgLine::requiresGroupRendering() const
     return hasAnyMarker();
 }
 
+bool QSvgLine::canFoldOpacity(QPainter *, QSvgExtraStates &) const
+{
+    return !hasAnyMarker();
+}
+
 QRectF QSvgLine::internalBounds(QPainter *p, QSvgExtraStates &s, BoundsMode mode) const
 {
     qreal sw = strokeWidth(p);
@@ -45,6 +45,7 @@ public:
     bool separateFillStroke() const override;
     void drawCommand(QPainter *p, QSvgExtraStates &states) override;
     Type type() const override;
+    bool geometry(QPainterPath *path) const override;
     QRectF internalFastBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF decoratedInternalBounds(QPainter *p, QSvgExtraStates &states) const override;
@@ -70,6 +71,7 @@ public:
     void drawCommand(QPainter *p, QSvgExtraStates &states) override;
     Type type() const override;
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states) const override;
+    bool canFoldOpacity(QPainter *p, QSvgExtraStates &states) const override;
 
     QRectF rect() const { return m_bounds; }
     const QImage &image() const { return m_image; }
@@ -86,10 +88,13 @@ public:
     QSvgLine(QSvgNode *parent, const QLineF &line);
     void drawCommand(QPainter *p, QSvgExtraStates &states) override;
     Type type() const override;
+    bool geometry(QPainterPath *path) const override;
     QRectF internalFastBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF decoratedInternalBounds(QPainter *p, QSvgExtraStates &states) const override;
     bool requiresGroupRendering() const override;
+    bool canFoldOpacity(QPainter *p, QSvgExtraStates &states) const override;
+    QList<MarkerVertex> computeMarkerVertices() const override;
     QLineF line() const { return m_line; }
 private:
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states, BoundsMode mode) const;
@@ -103,10 +108,12 @@ public:
     bool separateFillStroke() const override;
     void drawCommand(QPainter *p, QSvgExtraStates &states) override;
     Type type() const override;
+    bool geometry(QPainterPath *path) const override;
     QRectF internalFastBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF decoratedInternalBounds(QPainter *p, QSvgExtraStates &states) const override;
     bool requiresGroupRendering() const override;
+    QList<MarkerVertex> computeMarkerVertices() const override;
     const QPainterPath &path() const { return m_path; }
 private:
     QPainterPath m_path;
@@ -119,10 +126,12 @@ public:
     bool separateFillStroke() const override;
     void drawCommand(QPainter *p, QSvgExtraStates &states) override;
     Type type() const override;
+    bool geometry(QPainterPath *path) const override;
     QRectF internalFastBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF decoratedInternalBounds(QPainter *p, QSvgExtraStates &states) const override;
     bool requiresGroupRendering() const override;
+    QList<MarkerVertex> computeMarkerVertices() const override;
     const QPolygonF &polygon() const { return m_poly; }
 private:
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states, BoundsMode mode) const;
@@ -136,10 +145,13 @@ public:
     bool separateFillStroke() const override;
     void drawCommand(QPainter *p, QSvgExtraStates &states) override;
     Type type() const override;
+    bool geometry(QPainterPath *path) const override;
+    bool strokeGeometry(QPainterPath *path) const override;
     QRectF internalFastBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states) const override;
     QRectF decoratedInternalBounds(QPainter *p, QSvgExtraStates &states) const override;
     bool requiresGroupRendering() const override;
+    QList<MarkerVertex> computeMarkerVertices() const override;
     const QPolygonF &polygon() const { return m_poly; }
 private:
     QRectF internalBounds(QPainter *p, QSvgExtraStates &states, BoundsMode mode) const;
@@ -151,6 +163,7 @@ class Q_SVG_EXPORT QSvgRect : public QSvgNode
 public:
     QSvgRect(QSvgNode *paren, const QRectF &rect, qreal rx=0, qreal ry=0);
     Type type() const override;
+    bool geometry(QPainterPath *path) const override;
     bool separateFillStroke() const override;
     void drawCommand(QPainter *p, QSvgExtraStates &states) override;
     QRectF internalFastBounds(QPainter *p, QSvgExtraStates &states) const override;
@@ -253,6 +266,9 @@ public:
     bool isRecursing() const { return m_recursing; }
 
 private:
+    bool drawCached(QPainter *p, QSvgExtraStates &states);
+    QImage renderCached(QPainter *p, QSvgExtraStates &states, const QTransform &transform);
+
     QSvgNode *m_link;
     QPointF   m_start;
     QString   m_linkId;
@@ -162,6 +162,9 @@ struct QSvgAttributes
 
     QStringView color;
     QStringView colorOpacity;
+    QStringView colorInterpolationFilters;
+    QStringView clipPath;
+    QStringView clipRule;
     QStringView fill;
     QStringView fillRule;
     QStringView fillOpacity;
@@ -246,6 +249,13 @@ QSvgAttributes::QSvgAttributes(const QXmlStreamAttributes &xmlAttributes, QSvgHa
                 colorOpacity = value;
             else if (name == QLatin1String("comp-op"))
                 compOp = value;
+            else if (name == QLatin1String("color-interpolation-filters"))
+                colorInterpolationFilters = value;
+            else if (name == QLatin1String("clip-path") &&
+                     !handler->options().testFlag(QtSvg::Tiny12FeaturesOnly))
+                clipPath = value;
+            else if (name == QLatin1String("clip-rule"))
+                clipRule = value;
             break;
 
         case 'd':
@@ -375,6 +385,13 @@ QSvgAttributes::QSvgAttributes(const QXmlStreamAttributes &xmlAttributes, QSvgHa
                     colorOpacity = value;
                 else if (name == QLatin1String("comp-op"))
                     compOp = value;
+                else if (name == QLatin1String("color-interpolation-filters"))
+                    colorInterpolationFilters = value;
+                else if (name == QLatin1String("clip-path") &&
+                         !handler->options().testFlag(QtSvg::Tiny12FeaturesOnly))
+                    clipPath = value;
+                else if (name == QLatin1String("clip-rule"))
+                    clipRule = value;
                 break;
 
             case 'd':
@@ -891,6 +908,25 @@ static void parseColor(QSvgNode *,
     }
 }
 
+static void parseColorInterpolationFilters(const QSvgAttributes &attributes, QSvgHandler *handler)
+{
+    const QStringView value = attributes.colorInterpolationFilters.trimmed();
+    if (value == QLatin1String("linearRGB"))
+        handler->setColorInterpolationFilters(QtSvg::ColorSpace::linearRGB);
+    else if (value == QLatin1String("sRGB") || value == QLatin1String("auto"))
+        handler->setColorInterpolationFilters(QtSvg::ColorSpace::sRGB);
+}
+
+static void parseClipRule(QSvgNode *node, const QSvgAttributes &attributes, QSvgHandler *handler)
+{
+    const QStringView value = attributes.clipRule.trimmed();
+    if (value == QLatin1String("evenodd"))
+        handler->setClipRule(Qt::OddEvenFill);
+    else if (value == QLatin1String("nonzero"))
+        handler->setClipRule(Qt::WindingFill);
+    node->setClipRule(handler->clipRule());
+}
+
 static QSvgStyleProperty *styleFromUrl(QSvgNode *node, const QString &url)
 {
     return node ? node->styleProperty(idFromUrl(url)) : 0;
@@ -2259,6 +2295,17 @@ static void parseExtendedAttributes(QSvgNode *node,
         node->setMaskId(maskId);
     }
 
+    if (!attributes.clipPath.isEmpty()) {
+        QString clipStr = attributes.clipPath.toString().trimmed();
+        if (clipStr.size() > 3 && clipStr.mid(0, 3) == QLatin1String("url"))
+            clipStr = clipStr.mid(3, clipStr.size() - 3);
+        QString clipId = idFromUrl(clipStr);
+        if (clipId.startsWith(QLatin1Char('#'))) //TODO: handle urls and ids in a single place
+            clipId.remove(0, 1);
+
+        node->setClipPathId(clipId);
+    }
+
     if (!attributes.markerStart.isEmpty() &&
         !handler->options().testFlag(QtSvg::Tiny12FeaturesOnly)) {
         QString markerStr = attributes.markerStart.toString().trimmed();
@@ -2327,6 +2374,8 @@ static bool parseStyle(QSvgNode *node,
                        QSvgHandler *handler)
 {
     parseColor(node, attributes, handler);
+    parseColorInterpolationFilters(attributes, handler);
+    parseClipRule(node, attributes, handler);
     parseBrush(node, attributes, handler);
     parsePen(node, attributes, handler);
     parseFont(node, attributes, handler);
@@ -3054,6 +3103,17 @@ static bool parseMarkerNode(QSvgNode *,
     return true;
 }
 
+static QSvgNode *createClipPathNode(QSvgNode *parent,
+                                    const QXmlStreamAttributes &attributes,
+                                    QSvgHandler *)
+{
+    const QStringView units = attributes.value(QLatin1String("clipPathUnits"));
+    const QtSvg::UnitTypes contentUnits = units.contains(QLatin1String("objectBoundingBox"))
+            ? QtSvg::UnitTypes::objectBoundingBox : QtSvg::UnitTypes::userSpaceOnUse;
+
+    return new QSvgClipPath(parent, contentUnits);
+}
+
 static QSvgNode *createMaskNode(QSvgNode *parent,
                           const QXmlStreamAttributes &attributes,
                           QSvgHandler *)
@@ -3511,6 +3571,264 @@ static QSvgNode *createFeBlendNode(QSvgNode *parent,
     return filter;
 }
 
+static QSvgNode *createFeConvolveMatrixNode(QSvgNode *parent,
+                                            const QXmlStreamAttributes &attributes,
+                                            QSvgHandler *handler)
+{
+    const QString orderString = attributes.value(QLatin1String("order")).toString();
+    const QString kernelString = attributes.value(QLatin1String("kernelMatrix")).toString();
+    const QString edgeModeString = attributes.value(QLatin1String("edgeMode")).toString();
+    const QStringView targetXString = attributes.value(QLatin1String("targetX"));
+    const QStringView targetYString = attributes.value(QLatin1String("targetY"));
+
+    QString inputString;
+    QString outputString;
+    QSvgRectF rect;
+
+    parseFilterAttributes(parent, attributes, handler,
+                          &inputString, &outputString, &rect);
+
+    QSize order(3, 3);
+    if (!orderString.isEmpty()) {
+        const QChar *s = orderString.constData();
+        const QList<qreal> values = parseNumbersList(s);
+        const qreal orderX = values.value(0);
+        const qreal orderY = values.value(1, orderX);
+        order = QSize(int(orderX), int(orderY));
+        if (values.isEmpty() || orderX != order.width() || orderY != order.height())
+            order = QSize();
+    }
+
+    const QChar *s = kernelString.constData();
+    const QList<qreal> kernel = parseNumbersList(s);
+
+    QPoint target(order.width() / 2, order.height() / 2);
+    if (!targetXString.isEmpty())
+        target.setX(int(QSvgUtils::toDouble(targetXString)));
+    if (!targetYString.isEmpty())
+        target.setY(int(QSvgUtils::toDouble(targetYString)));
+
+    // An invalid kernel disables the filter
+    if (order.isEmpty() || kernel.size() != order.width() * order.height()
+        || target.x() < 0 || target.x() >= order.width()
+        || target.y() < 0 || target.y() >= order.height()) {
+        return new QSvgFeUnsupported(parent, inputString, outputString, rect);
+    }
+
+    const qreal divisor = QSvgUtils::toDouble(attributes.value(QLatin1String("divisor")));
+    const qreal bias = QSvgUtils::toDouble(attributes.value(QLatin1String("bias")));
+
+    QSvgFeConvolveMatrix::EdgeMode edgeMode = QSvgFeConvolveMatrix::EdgeMode::Duplicate;
+    if (edgeModeString.startsWith(QLatin1String("wrap")))
+        edgeMode = QSvgFeConvolveMatrix::EdgeMode::Wrap;
+    else if (edgeModeString.startsWith(QLatin1String("none")))
+        edgeMode = QSvgFeConvolveMatrix::EdgeMode::None;
+
+    const bool preserveAlpha = attributes.value(QLatin1String("preserveAlpha")) == QLatin1String("true");
+
+    QSvgNode *filter = new QSvgFeConvolveMatrix(parent, inputString, outputString, rect,
+                                                order, kernel, divisor, bias, target,
+                                                edgeMode, preserveAlpha);
+    return filter;
+}
+
+static QSvgNode *createFeMorphologyNode(QSvgNode *parent,
+                                        const QXmlStreamAttributes &attributes,
+                                        QSvgHandler *handler)
+{
+    const QString operatorString = attributes.value(QLatin1String("operator")).toString();
+    const QString radiusString = attributes.value(QLatin1String("radius")).toString();
+
+    QString inputString;
+    QString outputString;
+    QSvgRectF rect;
+
+    parseFilterAttributes(parent, attributes, handler,
+                          &inputString, &outputString, &rect);
+
+    QSvgFeMorphology::Operator op = QSvgFeMorphology::Operator::Erode;
+    if (operatorString.startsWith(QLatin1String("dilate")))
+        op = QSvgFeMorphology::Operator::Dilate;
+
+    const QChar *s = radiusString.constData();
+    const QList<qreal> radius = parseNumbersList(s);
+    const qreal radiusX = radius.value(0);
+    const qreal radiusY = radius.value(1, radiusX);
+
+    QSvgNode *filter = new QSvgFeMorphology(parent, inputString, outputString, rect,
+                                            op, radiusX, radiusY);
+    return filter;
+}
+
+static QSvgNode *createFeTurbulenceNode(QSvgNode *parent,
+                                        const QXmlStreamAttributes &attributes,
+                                        QSvgHandler *handler)
+{
+    const QString typeString = attributes.value(QLatin1String("type")).toString();
+    const QString baseFrequencyString = attributes.value(QLatin1String("baseFrequency")).toString();
+    const QStringView numOctavesString = attributes.value(QLatin1String("numOctaves"));
+
+    QString inputString;
+    QString outputString;
+    QSvgRectF rect;
+
+    parseFilterAttributes(parent, attributes, handler,
+                          &inputString, &outputString, &rect);
+
+    const QChar *s = baseFrequencyString.constData();
+    const QList<qreal> baseFrequency = parseNumbersList(s);
+    const qreal baseFrequencyX = baseFrequency.value(0);
+    const qreal baseFrequencyY = baseFrequency.value(1, baseFrequencyX);
+
+    // Negative frequencies disable the filter
+    if (baseFrequencyX < 0 || baseFrequencyY < 0)
+        return new QSvgFeUnsupported(parent, inputString, outputString, rect);
+
+    int numOctaves = 1;
+    if (!numOctavesString.isEmpty())
+        numOctaves = qMax(0, int(QSvgUtils::toDouble(numOctavesString)));
+    const qreal seed = QSvgUtils::toDouble(attributes.value(QLatin1String("seed")));
+    const bool stitchTiles = attributes.value(QLatin1String("stitchTiles")) == QLatin1String("stitch");
+
+    QSvgFeTurbulence::NoiseType type = QSvgFeTurbulence::NoiseType::Turbulence;
+    if (typeString.startsWith(QLatin1String("fractalNoise")))
+        type = QSvgFeTurbulence::NoiseType::FractalNoise;
+
+    QSvgNode *filter = new QSvgFeTurbulence(parent, inputString, outputString, rect, type,
+                                            baseFrequencyX, baseFrequencyY, numOctaves, seed,
+                                            stitchTiles);
+    return filter;
+}
+
+static QSvgNode *createFeComponentTransferNode(QSvgNode *parent,
+                                               const QXmlStreamAttributes &attributes,
+                                               QSvgHandler *handler)
+{
+    QString inputString;
+    QString outputString;
+    QSvgRectF rect;
+
+    parseFilterAttributes(parent, attributes, handler,
+                          &inputString, &outputString, &rect);
+
+    QSvgNode *filter = new QSvgFeComponentTransfer(parent, inputString, outputString, rect);
+    return filter;
+}
+
+static bool parseFeFuncNode(QSvgNode *parent, const QXmlStreamAttributes &attributes,
+                            QSvgFeComponentTransfer::Channel channel)
+{
+    if (parent->type() != QSvgNode::FeComponenttransfer)
+        return false;
+
+    const QStringView typeString = attributes.value(QLatin1String("type"));
+    const QString tableValuesString = attributes.value(QLatin1String("tableValues")).toString();
+
+    auto number = [&](const char *name, qreal defaultValue) {
+        const QStringView value = attributes.value(QLatin1String(name));
+        return value.isEmpty() ? defaultValue : QSvgUtils::toDouble(value);
+    };
+
+    QSvgFeComponentTransfer::TransferFunction function;
+    if (typeString == QLatin1String("table"))
+        function.type = QSvgFeComponentTransfer::FunctionType::Table;
+    else if (typeString == QLatin1String("discrete"))
+        function.type = QSvgFeComponentTransfer::FunctionType::Discrete;
+    else if (typeString == QLatin1String("linear"))
+        function.type = QSvgFeComponentTransfer::FunctionType::Linear;
+    else if (typeString == QLatin1String("gamma"))
+        function.type = QSvgFeComponentTransfer::FunctionType::Gamma;
+
+    const QChar *s = tableValuesString.constData();
+    function.tableValues = parseNumbersList(s);
+    function.slope = number("slope", 1);
+    function.intercept = number("intercept", 0);
+    function.amplitude = number("amplitude", 1);
+    function.exponent = number("exponent", 1);
+    function.offset = number("offset", 0);
+
+    static_cast<QSvgFeComponentTransfer *>(parent)->setTransferFunction(channel, function);
+    return true;
+}
+
+static bool parseFeFuncRNode(QSvgNode *parent,
+                             const QXmlStreamAttributes &attributes,
+                             QSvgHandler *)
+{
+    return parseFeFuncNode(parent, attributes, QSvgFeComponentTransfer::Channel::Red);
+}
+
+static bool parseFeFuncGNode(QSvgNode *parent,
+                             const QXmlStreamAttributes &attributes,
+                             QSvgHandler *)
+{
+    return parseFeFuncNode(parent, attributes, QSvgFeComponentTransfer::Channel::Green);
+}
+
+static bool parseFeFuncBNode(QSvgNode *parent,
+                             const QXmlStreamAttributes &attributes,
+                             QSvgHandler *)
+{
+    return parseFeFuncNode(parent, attributes, QSvgFeComponentTransfer::Channel::Blue);
+}
+
+static bool parseFeFuncANode(QSvgNode *parent,
+                             const QXmlStreamAttributes &attributes,
+                             QSvgHandler *)
+{
+    return parseFeFuncNode(parent, attributes, QSvgFeComponentTransfer::Channel::Alpha);
+}
+
+static QSvgNode *createFeDropShadowNode(QSvgNode *parent,
+                                        const QXmlStreamAttributes &attributes,
+                                        QSvgHandler *handler)
+{
+    const QStringView dxString = attributes.value(QLatin1String("dx"));
+    const QStringView dyString = attributes.value(QLatin1String("dy"));
+    const QString stdDeviationString = attributes.value(QLatin1String("stdDeviation")).toString();
+    const QStringView colorStr = attributes.value(QLatin1String("flood-color"));
+    const QStringView opacityStr = attributes.value(QLatin1String("flood-opacity"));
+
+    QString inputString;
+    QString outputString;
+    QSvgRectF rect;
+
+    parseFilterAttributes(parent, attributes, handler,
+                          &inputString, &outputString, &rect);
+
+    // https://www.w3.org/TR/filter-effects-1/#feDropShadowElement
+    qreal dx = 2;
+    if (!dxString.isEmpty())
+        dx = QSvgUtils::toDouble(dxString);
+    qreal dy = 2;
+    if (!dyString.isEmpty())
+        dy = QSvgUtils::toDouble(dyString);
+
+    qreal stdDeviationX = 2;
+    qreal stdDeviationY = 2;
+    if (!stdDeviationString.isEmpty()) {
+        const QStringList values = stdDeviationString.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        stdDeviationX = stdDeviationY = QSvgUtils::toDouble(values.value(0));
+        if (values.size() > 1)
+            stdDeviationY = QSvgUtils::toDouble(values.at(1));
+    }
+    if (stdDeviationX < 0 || stdDeviationY < 0)
+        return new QSvgFeUnsupported(parent, inputString, outputString, rect);
+
+    QColor color;
+    if (!constructColor(colorStr, opacityStr, color, handler)) {
+        color = QColor(Qt::black);
+        bool ok;
+        qreal op = qMin(qreal(1.0), qMax(qreal(0.0), QSvgUtils::toDouble(opacityStr, &ok)));
+        if (ok)
+            color.setAlphaF(op);
+    }
+
+    QSvgNode *filter = new QSvgFeDropShadow(parent, inputString, outputString, rect,
+                                            dx, dy, stdDeviationX, stdDeviationY, color);
+    return filter;
+}
+
 static QSvgNode *createFeUnsupportedNode(QSvgNode *parent,
                                          const QXmlStreamAttributes &attributes,
                                          QSvgHandler *handler)
@@ -4230,6 +4548,7 @@ static QSvgNode *createUseNode(QSvgNode *parent,
     case QSvgNode::Group:
     case QSvgNode::Switch:
     case QSvgNode::Mask:
+    case QSvgNode::ClipPath:
         group = static_cast<QSvgStructureNode*>(parent);
         break;
     default:
@@ -4281,6 +4600,9 @@ static FactoryMethod findGroupFactory(const QString &name, QtSvg::Options option
 
     QStringView ref = QStringView{name}.mid(1, name.size() - 1);
     switch (name.at(0).unicode()) {
+    case 'c':
+        if (ref == QLatin1String("lipPath") && !options.testFlag(QtSvg::Tiny12FeaturesOnly)) return createClipPathNode;
+        break;
     case 'd':
         if (ref == QLatin1String("efs")) return createDefsNode;
         break;
@@ -4372,22 +4694,18 @@ static FactoryMethod findFilterFactory(const QString &name, QtSvg::Options optio
     if (name == QLatin1String("feComposite")) return createFeCompositeNode;
     if (name == QLatin1String("feFlood")) return createFeFloodNode;
     if (name == QLatin1String("feBlend")) return createFeBlendNode;
+    if (name == QLatin1String("feConvolveMatrix")) return createFeConvolveMatrixNode;
+    if (name == QLatin1String("feMorphology")) return createFeMorphologyNode;
+    if (name == QLatin1String("feTurbulence")) return createFeTurbulenceNode;
+    if (name == QLatin1String("feComponentTransfer")) return createFeComponentTransferNode;
+    if (name == QLatin1String("feDropShadow")) return createFeDropShadowNode;
 
     static const QStringList unsupportedFilters = {
-        QStringLiteral("feComponentTransfer"),
-        QStringLiteral("feConvolveMatrix"),
         QStringLiteral("feDiffuseLighting"),
         QStringLiteral("feDisplacementMap"),
-        QStringLiteral("feDropShadow"),
-        QStringLiteral("feFuncA"),
-        QStringLiteral("feFuncB"),
-        QStringLiteral("feFuncG"),
-        QStringLiteral("feFuncR"),
         QStringLiteral("feImage"),
-        QStringLiteral("feMorphology"),
         QStringLiteral("feSpecularLighting"),
-        QStringLiteral("feTile"),
-        QStringLiteral("feTurbulence")
+        QStringLiteral("feTile")
     };
 
     if (unsupportedFilters.contains(name))
@@ -4437,6 +4755,12 @@ static ParseMethod findUtilFactory(const QString &name, QtSvg::Options options)
         break;
     case 'f':
         if (ref == QLatin1String("oreignObject")) return parseForeignObjectNode;
+        if (!options.testFlag(QtSvg::Tiny12FeaturesOnly)) {
+            if (ref == QLatin1String("eFuncR")) return parseFeFuncRNode;
+            if (ref == QLatin1String("eFuncG")) return parseFeFuncGNode;
+            if (ref == QLatin1String("eFuncB")) return parseFeFuncBNode;
+            if (ref == QLatin1String("eFuncA")) return parseFeFuncANode;
+        }
         break;
     case 'h':
         if (ref == QLatin1String("andler")) return parseHandlerNode;
@@ -4728,6 +5052,9 @@ bool QSvgHandler::startElement(const QString &localName,
         m_whitespaceMode.push(QSvgText::Default);
     }
 
+    m_colorInterpolationFilters.push(colorInterpolationFilters());
+    m_clipRules.push(clipRule());
+
     if (!m_doc && localName != QLatin1String("svg"))
         return false;
 
@@ -4797,6 +5124,7 @@ bool QSvgHandler::startElement(const QString &localName,
             case QSvgNode::Symbol:
             case QSvgNode::Marker:
             case QSvgNode::Pattern:
+            case QSvgNode::ClipPath:
             {
                 if (node->type() == QSvgNode::Tspan) {
                     const QByteArray msg = QByteArrayLiteral("\'tspan\' element in wrong context.");
@@ -4856,6 +5184,8 @@ bool QSvgHandler::startElement(const QString &localName,
                 QSvgStructureNode *container =
                     static_cast<QSvgStructureNode*>(m_nodes.top());
                 container->addChild(node, someId(attributes));
+                parseColorInterpolationFilters(QSvgAttributes(attributes, this), this);
+                static_cast<QSvgFeFilterPrimitive *>(node)->setColorSpace(colorInterpolationFilters());
             } else {
                 const QByteArray msg = QByteArrayLiteral("Could not add child element to parent element because the types are incorrect.");
                 qCWarning(lcSvgHandler, "%s", prefixMessage(msg, xml).constData());
@@ -4918,6 +5248,8 @@ bool QSvgHandler::endElement(const QStringView localName)
 
     m_skipNodes.pop();
     m_whitespaceMode.pop();
+    m_colorInterpolationFilters.pop();
+    m_clipRules.pop();
 
     popColor();
 
@@ -5012,6 +5344,8 @@ void QSvgHandler::resolveNodes()
                     break;
                 }
             }
+            if (filter->supported())
+                filter->compile();
         } else if (node->type() == QSvgNode::AnimateTransform || node->type() == QSvgNode::AnimateColor) {
             QSvgAnimateNode *anim = static_cast<QSvgAnimateNode *>(node);
             QSvgNode *targetNode = m_doc->namedNode(anim->linkId());
@@ -5090,6 +5424,41 @@ void QSvgHandler::popColor()
     }
 }
 
+/*!
+    \internal
+
+    Sets the value of the color-interpolation-filters property for the
+    current element and the elements within it.
+*/
+void QSvgHandler::setColorInterpolationFilters(QtSvg::ColorSpace colorSpace)
+{
+    if (!m_colorInterpolationFilters.isEmpty())
+        m_colorInterpolationFilters.top() = colorSpace;
+}
+
+QtSvg::ColorSpace QSvgHandler::colorInterpolationFilters() const
+{
+    return m_colorInterpolationFilters.isEmpty() ? QtSvg::ColorSpace::linearRGB
+                                                 : m_colorInterpolationFilters.top();
+}
+
+/*!
+    \internal
+
+    Sets the value of the clip-rule property for the current element and
+    the elements within it.
+*/
+void QSvgHandler::setClipRule(Qt::FillRule rule)
+{
+    if (!m_clipRules.isEmpty())
+        m_clipRules.top() = rule;
+}
+
+Qt::FillRule QSvgHandler::clipRule() const
+{
+    return m_clipRules.isEmpty() ? Qt::WindingFill : m_clipRules.top();
+}
+
 QColor QSvgHandler::currentColor() const
 {
     if (!m_colorStack.isEmpty())
@@ -75,6 +75,12 @@ public:
     void popColor();
     QColor currentColor() const;
 
+    void setColorInterpolationFilters(QtSvg::ColorSpace colorSpace);
+    QtSvg::ColorSpace colorInterpolationFilters() const;
+
+    void setClipRule(Qt::FillRule rule);
+    Qt::FillRule clipRule() const;
+
 #ifndef QT_NO_CSSPARSER
     void setInStyle(bool b);
     bool inStyle() const;
@@ -129,6 +135,18 @@ private:
      */
     QStack<QSvgText::WhitespaceMode> m_whitespaceMode;
 
+    /*!
+        Follows the depths of elements. The top is the color space that
+        filter primitives within a given element operate in.
+     */
+    QStack<QtSvg::ColorSpace> m_colorInterpolationFilters;
+
+    /*!
+        Follows the depths of elements. The top is the clip-rule that
+        applies for a given element.
+     */
+    QStack<Qt::FillRule> m_clipRules;
+
     QSvgRefCounter<QSvgStyleProperty> m_style;
 
     QSvgUtils::LengthType m_defaultCoords;
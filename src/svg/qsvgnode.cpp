@@ -7,13 +7,19 @@
 
 #include <QLoggingCategory>
 #include<QElapsedTimer>
-#include <QtGui/qimageiohandler.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qmath.h>
+#include <QtGui/qpaintengine.h>
 
 #include "qdebug.h"
 #include "qstack.h"
 
+#include <QtCore/private/qsimd_p.h>
 #include <QtGui/private/qoutlinemapper_p.h>
 
+#include <algorithm>
+#include <cmath>
+
 QT_BEGIN_NAMESPACE
 
 #ifndef QT_NO_DEBUG
@@ -45,44 +51,72 @@ void QSvgNode::draw(QPainter *p, QSvgExtraStates &states)
     if (shouldDrawNode(p, states)) {
         applyStyle(p, states);
         applyAnimatedStyle(p, states);
+        QSvgNode *clipNode = this->hasClipPath() ? document()->namedNode(this->clipPathId()) : nullptr;
+        const bool clipped = clipNode && clipNode->type() == QSvgNode::ClipPath;
+        bool clippedAway = false;
+        if (clipped) {
+            const QPainterPath clipPath = static_cast<QSvgClipPath *>(clipNode)->clipPath(p, this);
+            clippedAway = clipPath.isEmpty();
+            p->save();
+            const QTransform xf = p->transform();
+            p->resetTransform();
+            p->setClipPath(clipPath, Qt::IntersectClip);
+            p->setTransform(xf);
+        }
         QSvgNode *maskNode = this->hasMask() ? document()->namedNode(this->maskId()) : nullptr;
         QSvgFilterContainer *filterNode = this->hasFilter() ? static_cast<QSvgFilterContainer*>(document()->namedNode(this->filterId()))
                                                             : nullptr;
-        if (filterNode && filterNode->type() == QSvgNode::Filter && filterNode->supported()) {
-            QTransform xf = p->transform();
-            p->resetTransform();
-            QRectF localRect = internalBounds(p, states);
-            p->setTransform(xf);
-            QRectF boundsRect = xf.mapRect(filterNode->filterRegion(localRect));
-            QImage proxy = drawIntoBuffer(p, states, boundsRect.toRect());
-            proxy = filterNode->applyFilter(proxy, p, localRect);
-            if (maskNode && maskNode->type() == QSvgNode::Mask) {
-                boundsRect = QRectF(proxy.offset(), proxy.size());
-                localRect = p->transform().inverted().mapRect(boundsRect);
-                QImage mask = static_cast<QSvgMask*>(maskNode)->createMask(p, states, localRect, &boundsRect);
-                applyMaskToBuffer(&proxy, mask);
+        if (clippedAway) {
+            // Nothing to draw
+        } else if (filterNode && filterNode->type() == QSvgNode::Filter && filterNode->supported()) {
+            QSvgFilterCache *filterCache = document()->filterCache();
+            QImage proxy;
+            bool tiled = false;
+            if (!filterCache->find(this, filterNode, p, states, &proxy)) {
+                QTransform xf = p->transform();
+                p->resetTransform();
+                QRectF localRect = internalBounds(p, states);
+                p->setTransform(xf);
+                const QRect region = xf.mapRect(filterNode->filterRegion(localRect)).toRect();
+                const int tileSize = QSvgFilterContainer::tileSize();
+                tiled = region.width() > tileSize || region.height() > tileSize;
+                if (tiled) {
+                    drawFilterTiles(p, states, filterNode, maskNode, localRect, region);
+                } else {
+                    QImage source = drawIntoBuffer(p, states, region);
+                    proxy = filterNode->applyFilter(source, p, localRect);
+                    document()->scratchBuffers()->recycle(std::move(source));
+                    filterCache->insert(this, filterNode, p, states, proxy);
+                }
+            }
+            if (!tiled) {
+                if (maskNode && maskNode->type() == QSvgNode::Mask) {
+                    QRectF boundsRect = QRectF(proxy.offset(), proxy.size());
+                    QRectF localRect = p->transform().inverted().mapRect(boundsRect);
+                    QImage mask = static_cast<QSvgMask*>(maskNode)->createMask(p, states, localRect, &boundsRect);
+                    applyMaskToBuffer(&proxy, mask);
+                }
+                applyBufferToCanvas(p, proxy);
+                document()->scratchBuffers()->recycle(std::move(proxy));
             }
-            applyBufferToCanvas(p, proxy);
 
         } else if (maskNode && maskNode->type() == QSvgNode::Mask) {
             QRectF boundsRect;
             QImage mask = static_cast<QSvgMask*>(maskNode)->createMask(p, states, this, &boundsRect);
             drawWithMask(p, states, mask, boundsRect.toRect());
-        } else if (!qFuzzyCompare(p->opacity(), 1.0) && requiresGroupRendering()) {
+        } else if (!qFuzzyCompare(p->opacity(), 1.0) && requiresGroupRendering()
+                   && !canFoldOpacity(p, states)) {
             QTransform xf = p->transform();
             p->resetTransform();
 
-            QRectF localRect = decoratedInternalBounds(p, states);
-            // adding safety border needed because of the antialiazing effects
-            QRectF boundsRect = xf.mapRect(localRect);
-            const int deltaX = boundsRect.width() * 0.1;
-            const int deltaY = boundsRect.height() * 0.1;
-            boundsRect = boundsRect.adjusted(-deltaX, -deltaY, deltaX, deltaY);
-
+            const QRect boundsRect = layerBounds(p, xf.mapRect(decoratedInternalBounds(p, states)));
             p->setTransform(xf);
 
-            QImage proxy = drawIntoBuffer(p, states, boundsRect.toAlignedRect());
-            applyBufferToCanvas(p, proxy);
+            if (!boundsRect.isEmpty()) {
+                QImage proxy = drawIntoBuffer(p, states, boundsRect);
+                applyBufferToCanvas(p, proxy);
+                document()->scratchBuffers()->recycle(std::move(proxy));
+            }
         } else {
             if (separateFillStroke())
                 fillThenStroke(p, states);
@@ -90,6 +124,8 @@ void QSvgNode::draw(QPainter *p, QSvgExtraStates &states)
                 drawCommand(p, states);
 
         }
+        if (clipped)
+            p->restore();
         revertAnimatedStyle(p ,states);
         revertStyle(p, states);
     }
@@ -135,12 +171,32 @@ void QSvgNode::drawWithMask(QPainter *p, QSvgExtraStates &states, const QImage &
     p->resetTransform();
     p->drawImage(boundsRect, proxy);
     p->restore();
+    document()->scratchBuffers()->recycle(std::move(proxy));
+}
+
+/*!
+    \internal
+
+    Returns the device pixels an offscreen layer needs to cover for content
+    with the device space bounds \a deviceBounds, when \a p has no
+    transform. Antialiasing only touches pixels that the bounds intersect,
+    and pixels outside of the clip and the device are never composited.
+*/
+QRect QSvgNode::layerBounds(const QPainter *p, const QRectF &deviceBounds)
+{
+    QRect rect = deviceBounds.toAlignedRect().adjusted(-1, -1, 1, 1);
+    if (p->hasClipping())
+        rect &= p->clipBoundingRect().toAlignedRect();
+    const QPaintDevice *device = p->device();
+    if (device && device->width() > 0 && device->height() > 0)
+        rect &= QRect(0, 0, device->width(), device->height());
+    return rect;
 }
 
 QImage QSvgNode::drawIntoBuffer(QPainter *p, QSvgExtraStates &states, const QRect &boundsRect)
 {
     QImage proxy;
-    if (!QImageIOHandler::allocateImage(boundsRect.size(), QImage::Format_ARGB32_Premultiplied, &proxy)) {
+    if (!document()->scratchBuffers()->allocate(boundsRect.size(), &proxy)) {
         qCWarning(lcSvgDraw) << "The requested buffer size is too big, ignoring";
         return proxy;
     }
@@ -160,12 +216,110 @@ QImage QSvgNode::drawIntoBuffer(QPainter *p, QSvgExtraStates &states, const QRec
     return proxy;
 }
 
+/*!
+    \internal
+
+    Draws the node with \a filter applied in tiles of the filter \a region,
+    so that no buffer is larger than a tile and the footprint of the filter
+    around it. The source graphic is drawn once per tile, for the area the
+    tile depends on.
+*/
+void QSvgNode::drawFilterTiles(QPainter *p, QSvgExtraStates &states, const QSvgFilterContainer *filter,
+                               QSvgNode *maskNode, const QRectF &localRect, const QRect &region)
+{
+    const QMargins halo = filter->footprint(p, localRect);
+    const int side = qMax(QSvgFilterContainer::tileSize(),
+                          2 * std::max({ halo.left(), halo.top(), halo.right(), halo.bottom() }));
+
+    for (int y = region.top(); y <= region.bottom(); y += side) {
+        for (int x = region.left(); x <= region.right(); x += side) {
+            const QRect tile = QRect(x, y, side, side).intersected(region);
+            QImage source = drawIntoBuffer(p, states, tile.marginsAdded(halo).intersected(region));
+            if (source.isNull())
+                continue;
+            QImage proxy = filter->applyFilter(source, p, localRect, tile);
+            document()->scratchBuffers()->recycle(std::move(source));
+            if (proxy.isNull())
+                continue;
+            if (maskNode && maskNode->type() == QSvgNode::Mask) {
+                QRectF boundsRect = QRectF(proxy.offset(), proxy.size());
+                QRectF maskRect = p->transform().inverted().mapRect(boundsRect);
+                QImage mask = static_cast<QSvgMask*>(maskNode)->createMask(p, states, maskRect, &boundsRect);
+                applyMaskToBuffer(&proxy, mask);
+            }
+            applyBufferToCanvas(p, proxy);
+            document()->scratchBuffers()->recycle(std::move(proxy));
+        }
+    }
+}
+
+namespace {
+
+// Scales premultiplied pixels by the alpha of the mask, rounded to nearest
+void multiplyByMask(QRgb *pixels, const uchar *mask, int count)
+{
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(0x80);
+    auto multiply = [&](__m128i channels, __m128i alpha) {
+        const __m128i product = _mm_add_epi16(_mm_mullo_epi16(channels, alpha), half);
+        return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+    };
+    for (; x + 4 <= count; x += 4) {
+        const quint32 alphas = qFromUnaligned<quint32>(mask + x);
+        __m128i alpha = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(alphas)), zero);
+        alpha = _mm_unpacklo_epi16(alpha, alpha);
+        const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + x));
+        const __m128i low = multiply(_mm_unpacklo_epi8(pixel, zero), _mm_unpacklo_epi32(alpha, alpha));
+        const __m128i high = multiply(_mm_unpackhi_epi8(pixel, zero), _mm_unpackhi_epi32(alpha, alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + x), _mm_packus_epi16(low, high));
+    }
+#elif defined(__ARM_NEON__)
+    auto multiply = [](uint8x8_t channel, uint8x8_t alpha) {
+        const uint16x8_t product = vmull_u8(channel, alpha);
+        return vraddhn_u16(product, vrshrq_n_u16(product, 8));
+    };
+    for (; x + 8 <= count; x += 8) {
+        const uint8x8_t alpha = vld1_u8(mask + x);
+        uint8x8x4_t pixel = vld4_u8(reinterpret_cast<const uint8_t *>(pixels + x));
+        for (int c = 0; c < 4; ++c)
+            pixel.val[c] = multiply(pixel.val[c], alpha);
+        vst4_u8(reinterpret_cast<uint8_t *>(pixels + x), pixel);
+    }
+#endif
+    for (; x < count; ++x) {
+        const uint alpha = mask[x];
+        if (alpha == 255)
+            continue;
+        const QRgb pixel = pixels[x];
+        uint rb = (pixel & 0xff00ff) * alpha + 0x800080;
+        rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+        uint ag = ((pixel >> 8) & 0xff00ff) * alpha + 0x800080;
+        ag = (ag + ((ag >> 8) & 0xff00ff)) & 0xff00ff00;
+        pixels[x] = ag | rb;
+    }
+}
+
+} // anonymous namespace
+
+/*!
+    \internal
+
+    Multiplies the pixels of \a proxy with the alpha of \a mask, an
+    Format_Alpha8 image aligned with the top left corner of \a proxy.
+*/
 void QSvgNode::applyMaskToBuffer(QImage *proxy, QImage mask) const
 {
-    QPainter proxyPainter(proxy);
-    proxyPainter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
-    proxyPainter.resetTransform();
-    proxyPainter.drawImage(QRect(0, 0, mask.width(), mask.height()), mask);
+    if (mask.isNull())
+        return;
+    Q_ASSERT(mask.format() == QImage::Format_Alpha8);
+    Q_ASSERT(proxy->format() == QImage::Format_ARGB32_Premultiplied);
+
+    const int width = qMin(proxy->width(), mask.width());
+    const int height = qMin(proxy->height(), mask.height());
+    for (int y = 0; y < height; ++y)
+        multiplyByMask(reinterpret_cast<QRgb *>(proxy->scanLine(y)), mask.constScanLine(y), width);
 }
 
 void QSvgNode::applyBufferToCanvas(QPainter *p, QImage proxy) const
@@ -275,16 +429,31 @@ void QSvgNode::revertStyleRecursive(QPainter *p, QSvgExtraStates &states) const
 
 void QSvgNode::applyAnimatedStyle(QPainter *p, QSvgExtraStates &states) const
 {
-    if (document()->animated())
+    if (m_animatedStyle.hasAnimations())
         m_animatedStyle.apply(p, this, states);
 }
 
 void QSvgNode::revertAnimatedStyle(QPainter *p, QSvgExtraStates &states) const
 {
-    if (document()->animated())
+    if (m_animatedStyle.hasAnimations())
         m_animatedStyle.revert(p, states);
 }
 
+void QSvgNode::appendAnimation(QSvgAbstractAnimation *anim)
+{
+    m_animatedStyle.appendAnimation(anim);
+}
+
+const QList<QSvgAbstractAnimation *> &QSvgNode::animations() const
+{
+    return m_animatedStyle.animations();
+}
+
+bool QSvgNode::hasAnimations() const
+{
+    return m_animatedStyle.hasAnimations();
+}
+
 QSvgStyleProperty * QSvgNode::styleProperty(QSvgStyleProperty::Type type) const
 {
     const QSvgNode *node = this;
@@ -416,6 +585,7 @@ QString QSvgNode::typeName() const
         case Use: return QStringLiteral("use");
         case Video: return QStringLiteral("video");
         case Mask: return QStringLiteral("mask");
+        case ClipPath: return QStringLiteral("clipPath");
         case Symbol: return QStringLiteral("symbol");
         case Marker: return QStringLiteral("marker");
         case Pattern: return QStringLiteral("pattern");
@@ -428,6 +598,11 @@ QString QSvgNode::typeName() const
         case FeComposite: return QStringLiteral("feComposite");
         case FeFlood: return QStringLiteral("feFlood");
         case FeBlend: return QStringLiteral("feBlend");
+        case FeConvolvematrix: return QStringLiteral("feConvolveMatrix");
+        case FeMorphology: return QStringLiteral("feMorphology");
+        case FeTurbulence: return QStringLiteral("feTurbulence");
+        case FeComponenttransfer: return QStringLiteral("feComponentTransfer");
+        case FeDropshadow: return QStringLiteral("feDropShadow");
         case FeUnsupported: return QStringLiteral("feUnsupported");
     }
     return QStringLiteral("unknown");
@@ -543,6 +718,23 @@ bool QSvgNode::hasMask() const
     return !m_maskId.isEmpty();
 }
 
+QString QSvgNode::clipPathId() const
+{
+    return m_clipPathId;
+}
+
+void QSvgNode::setClipPathId(const QString &str)
+{
+    m_clipPathId = str;
+}
+
+bool QSvgNode::hasClipPath() const
+{
+    if (document()->options().testFlag(QtSvg::Tiny12FeaturesOnly))
+        return false;
+    return !m_clipPathId.isEmpty();
+}
+
 QString QSvgNode::filterId() const
 {
     return m_filterId;
@@ -568,6 +760,7 @@ QString QSvgNode::markerStartId() const
 void QSvgNode::setMarkerStartId(const QString &str)
 {
     m_markerStartId = str;
+    m_markerVerticesValid = false;
 }
 
 bool QSvgNode::hasMarkerStart() const
@@ -585,6 +778,7 @@ QString QSvgNode::markerMidId() const
 void QSvgNode::setMarkerMidId(const QString &str)
 {
     m_markerMidId = str;
+    m_markerVerticesValid = false;
 }
 
 bool QSvgNode::hasMarkerMid() const
@@ -602,6 +796,7 @@ QString QSvgNode::markerEndId() const
 void QSvgNode::setMarkerEndId(const QString &str)
 {
     m_markerEndId = str;
+    m_markerVerticesValid = false;
 }
 
 bool QSvgNode::hasMarkerEnd() const
@@ -618,11 +813,120 @@ bool QSvgNode::hasAnyMarker() const
     return hasMarkerStart() || hasMarkerMid() || hasMarkerEnd();
 }
 
+/*!
+    \internal
+
+    Returns the positions and angles at which the markers of this node are
+    placed, in drawing order. The table is computed on first use and kept,
+    since the geometry of a node does not change after loading; setting a
+    marker id drops it.
+*/
+const QList<QSvgNode::MarkerVertex> &QSvgNode::markerVertices() const
+{
+    if (!m_markerVerticesValid) {
+        m_markerVertices = hasAnyMarker() ? computeMarkerVertices() : QList<MarkerVertex>();
+        m_markerVertices.squeeze();
+        m_markerVerticesValid = true;
+    }
+    return m_markerVertices;
+}
+
+/*!
+    \internal
+
+    Computes the vertices that the markers of this node are placed at. The
+    default implementation returns an empty list, for nodes that have no
+    markers.
+*/
+QList<QSvgNode::MarkerVertex> QSvgNode::computeMarkerVertices() const
+{
+    return {};
+}
+
 bool QSvgNode::requiresGroupRendering() const
 {
     return false;
 }
 
+/*!
+    \internal
+
+    Returns \c true if drawCommand() paints no pixel more than once with the
+    style currently set on \a p, so that the opacity of \a p can be applied
+    to each paint operation instead of to an offscreen layer.
+
+    The default implementation handles nodes that fill and stroke
+    separately: they paint once if they have no markers and either do not
+    fill, do not stroke, or their fill covers no area.
+*/
+bool QSvgNode::canFoldOpacity(QPainter *p, QSvgExtraStates &states) const
+{
+    if (!separateFillStroke() || hasAnyMarker())
+        return false;
+
+    const bool fills = p->brush().style() != Qt::NoBrush && states.fillOpacity > 0;
+    const bool strokes = p->pen() != Qt::NoPen && p->pen().brush() != Qt::NoBrush
+            && p->pen().widthF() != 0 && states.strokeOpacity > 0;
+    if (!fills || !strokes)
+        return true;
+
+    QPainterPath path;
+    if (!geometry(&path))
+        return false;
+    const QRectF rect = path.boundingRect();
+    return rect.width() == 0 || rect.height() == 0;
+}
+
+/*!
+    \internal
+
+    Returns \c true if drawing the node onto \a p paints no pixel more than
+    once, either because it is drawn through an offscreen layer or because
+    its opacity can be folded into the paint.
+*/
+bool QSvgNode::paintsOnce(QPainter *p, QSvgExtraStates &states) const
+{
+    applyStyle(p, states);
+    applyAnimatedStyle(p, states);
+
+    QSvgNode *filterNode = hasFilter() ? document()->namedNode(filterId()) : nullptr;
+    QSvgNode *maskNode = hasMask() ? document()->namedNode(maskId()) : nullptr;
+    bool once = (filterNode && filterNode->type() == QSvgNode::Filter
+                 && static_cast<QSvgFilterContainer *>(filterNode)->supported())
+            || (maskNode && maskNode->type() == QSvgNode::Mask)
+            || (!qFuzzyCompare(p->opacity(), 1.0) && requiresGroupRendering());
+    if (!once)
+        once = canFoldOpacity(p, states);
+
+    revertAnimatedStyle(p, states);
+    revertStyle(p, states);
+    return once;
+}
+
+/*!
+    \internal
+
+    Sets \a path to the fill geometry of the node in its own user space and
+    returns \c true. Returns \c false if the node has no geometry that can
+    be expressed as a path, for example text.
+*/
+bool QSvgNode::geometry(QPainterPath *path) const
+{
+    Q_UNUSED(path);
+    return false;
+}
+
+/*!
+    \internal
+
+    Sets \a path to the geometry that is stroked when the node is drawn and
+    returns \c true. The default implementation returns the fill geometry.
+*/
+bool QSvgNode::strokeGeometry(QPainterPath *path) const
+{
+    return geometry(path);
+}
+
 void QSvgNode::setDisplayMode(DisplayMode mode)
 {
     m_displayMode = mode;
@@ -669,6 +973,83 @@ QRectF QSvgNode::boundsOnStroke(QPainter *p, const QPainterPath &path,
     return p->transform().map(stroke).boundingRect();
 }
 
+QRectF QSvgNode::strokeBounds(QPainter *p, const QPainterPath &path, qreal width, BoundsMode mode) const
+{
+    QRectF rect;
+    if (mode == BoundsMode::IncludeMiterLimit && strokeOutline(p, nullptr, &rect))
+        return p->transform().mapRect(rect);
+    return boundsOnStroke(p, path, width, mode);
+}
+
+/*!
+    \internal
+
+    Stores the outline of the stroke geometry of the node, stroked with the
+    pen of \a p in the node's user space, and its bounds in \a outline and
+    \a bounds, taking them from the document's stroke cache if possible.
+    Either may be null.
+
+    Returns \c false if there is no such outline worth caching: the pen is
+    cosmetic, or no more than a pixel wide on the device, so that QPainter
+    strokes it directly, or the node has no stroke geometry.
+*/
+bool QSvgNode::strokeOutline(QPainter *p, QPainterPath *outline, QRectF *bounds) const
+{
+    const QPen &pen = p->pen();
+    if (pen.style() == Qt::NoPen || pen.brush().style() == Qt::NoBrush || pen.isCosmetic())
+        return false;
+
+    const QTransform xf = p->deviceTransform();
+    const qreal scale = qSqrt(qMax(xf.m11() * xf.m11() + xf.m12() * xf.m12(),
+                                   xf.m21() * xf.m21() + xf.m22() * xf.m22()));
+    if (pen.widthF() * scale <= 1)
+        return false;
+
+    QSvgStrokeCache *cache = document()->strokeCache();
+    if (!cache->isEnabled())
+        return false;
+
+    // Curves are flattened for the scale rounded up to half an octave
+    const int scaleStep = qCeil(2 * std::log2(scale));
+    if (cache->find(this, pen, scaleStep, outline, bounds))
+        return true;
+
+    QPainterPath path;
+    if (!strokeGeometry(&path) || path.isEmpty())
+        return false;
+
+    QPainterPathStroker stroker(pen);
+    stroker.setCurveThreshold(0.25 / std::exp2(scaleStep / 2.0));
+    const QPainterPath stroke = stroker.createStroke(path);
+    const QRectF strokeRect = stroke.boundingRect();
+    cache->insert(this, pen, scaleStep, stroke, strokeRect);
+
+    if (outline)
+        *outline = stroke;
+    if (bounds)
+        *bounds = strokeRect;
+    return true;
+}
+
+/*!
+    \internal
+
+    Strokes the node with the pen of \a p by filling its cached stroke
+    outline. Returns \c false, without drawing, if there is none or if \a p
+    does not rasterize, so that vector output keeps its strokes.
+*/
+bool QSvgNode::drawCachedStroke(QPainter *p) const
+{
+    if (!p->paintEngine() || p->paintEngine()->type() != QPaintEngine::Raster)
+        return false;
+
+    QPainterPath outline;
+    if (!strokeOutline(p, &outline, nullptr))
+        return false;
+    p->fillPath(outline, p->pen().brush());
+    return true;
+}
+
 bool QSvgNode::shouldDrawNode(QPainter *p, QSvgExtraStates &states) const
 {
     if (m_displayMode == DisplayMode::NoneMode)
@@ -26,6 +26,7 @@ QT_BEGIN_NAMESPACE
 
 class QPainter;
 class QSvgTinyDocument;
+class QSvgFilterContainer;
 
 class Q_SVG_EXPORT QSvgNode
 {
@@ -52,6 +53,7 @@ public:
         Use,
         Video,
         Mask,
+        ClipPath,
         Symbol,
         Marker,
         Pattern,
@@ -64,6 +66,11 @@ public:
         FeComposite,
         FeFlood,
         FeBlend,
+        FeConvolvematrix,
+        FeMorphology,
+        FeTurbulence,
+        FeComponenttransfer,
+        FeDropshadow,
         FeUnsupported
     };
     enum DisplayMode {
@@ -97,6 +104,8 @@ public:
     QImage drawIntoBuffer(QPainter *p, QSvgExtraStates &states, const QRect &boundsRect);
     void applyMaskToBuffer(QImage *proxy, QImage mask) const;
     void drawWithMask(QPainter *p, QSvgExtraStates &states, const QImage &mask, const QRect &boundsRect);
+    void drawFilterTiles(QPainter *p, QSvgExtraStates &states, const QSvgFilterContainer *filter,
+                         QSvgNode *maskNode, const QRectF &localRect, const QRect &region);
     void applyBufferToCanvas(QPainter *p, QImage proxy) const;
 
     QSvgNode *parent() const;
@@ -109,6 +118,9 @@ public:
     void revertStyleRecursive(QPainter *p, QSvgExtraStates &states) const;
     void applyAnimatedStyle(QPainter *p, QSvgExtraStates &states) const;
     void revertAnimatedStyle(QPainter *p, QSvgExtraStates &states) const;
+    void appendAnimation(QSvgAbstractAnimation *anim);
+    const QList<QSvgAbstractAnimation *> &animations() const;
+    bool hasAnimations() const;
     QSvgStyleProperty *styleProperty(QSvgStyleProperty::Type type) const;
     QSvgPaintStyleProperty *styleProperty(const QString &id) const;
 
@@ -154,6 +166,13 @@ public:
     void setMaskId(const QString &str);
     bool hasMask() const;
 
+    QString clipPathId() const;
+    void setClipPathId(const QString &str);
+    bool hasClipPath() const;
+
+    Qt::FillRule clipRule() const { return m_clipRule; }
+    void setClipRule(Qt::FillRule rule) { m_clipRule = rule; }
+
     QString filterId() const;
     void setFilterId(const QString &str);
     bool hasFilter() const;
@@ -172,7 +191,24 @@ public:
 
     bool hasAnyMarker() const;
 
+    enum class MarkerKind : quint8 {
+        Start,
+        Mid,
+        End
+    };
+    struct MarkerVertex {
+        QPointF position;
+        qreal angle;
+        MarkerKind kind;
+    };
+    const QList<MarkerVertex> &markerVertices() const;
+
     virtual bool requiresGroupRendering() const;
+    virtual bool canFoldOpacity(QPainter *p, QSvgExtraStates &states) const;
+    bool paintsOnce(QPainter *p, QSvgExtraStates &states) const;
+    virtual bool geometry(QPainterPath *path) const;
+    virtual bool strokeGeometry(QPainterPath *path) const;
+    virtual QList<MarkerVertex> computeMarkerVertices() const;
 
     virtual bool shouldDrawNode(QPainter *p, QSvgExtraStates &states) const;
     const QSvgStaticStyle &style() const { return m_style; }
@@ -183,6 +219,7 @@ protected:
     QRectF filterRegion(QRectF bounds) const;
 
     static qreal strokeWidth(QPainter *p);
+    static QRect layerBounds(const QPainter *p, const QRectF &deviceBounds);
     static void initPainter(QPainter *p);
 
     enum BoundsMode {
@@ -191,6 +228,9 @@ protected:
     };
     static QRectF boundsOnStroke(QPainter *p, const QPainterPath &path,
                                  qreal width, BoundsMode mode);
+    QRectF strokeBounds(QPainter *p, const QPainterPath &path, qreal width, BoundsMode mode) const;
+    bool strokeOutline(QPainter *p, QPainterPath *outline, QRectF *bounds) const;
+    bool drawCachedStroke(QPainter *p) const;
 
 private:
     QSvgNode   *m_parent;
@@ -206,6 +246,7 @@ private:
     QString m_id;
     QString m_class;
     QString m_maskId;
+    QString m_clipPathId;
     QString m_filterId;
     QString m_markerStartId;
     QString m_markerMidId;
@@ -213,7 +254,10 @@ private:
 
 
     DisplayMode m_displayMode;
+    Qt::FillRule m_clipRule = Qt::WindingFill;
     mutable QRectF m_cachedBounds;
+    mutable QList<MarkerVertex> m_markerVertices;
+    mutable bool m_markerVerticesValid = false;
 
     friend class QSvgTinyDocument;
 };
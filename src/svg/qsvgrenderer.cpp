@@ -92,6 +92,14 @@ public:
         }
     }
 
+    void bakeAnimations()
+    {
+        if (render && render->animated() && render->animator()
+            && options.testFlag(QtSvg::BakeAnimations)) {
+            render->animator()->bakeAnimations(fps);
+        }
+    }
+
     void ensureTimerCreated()
     {
         Q_Q(QSvgRenderer);
@@ -101,6 +109,31 @@ public:
         }
     }
 
+    // Makes sure the scratch buffers of the document are checked for being
+    // idle. Only one check is pending at a time, from any rendering thread.
+    void scheduleIdleRelease()
+    {
+        Q_Q(QSvgRenderer);
+        if (idleReleasePending.testAndSetAcquire(0, 1))
+            QMetaObject::invokeMethod(q, [this] { releaseIdleBuffers(); });
+    }
+
+    void releaseIdleBuffers()
+    {
+        Q_Q(QSvgRenderer);
+        idleReleasePending.storeRelease(0);
+        const int remaining = render ? render->scratchBuffers()->releaseIdle() : 0;
+        // A render since the flag was cleared has scheduled a check of its own
+        if (remaining <= 0 || !idleReleasePending.testAndSetAcquire(0, 1))
+            return;
+        if (!idleTimer) {
+            idleTimer = new QTimer(q);
+            idleTimer->setSingleShot(true);
+            q->connect(idleTimer, &QTimer::timeout, q, [this] { releaseIdleBuffers(); });
+        }
+        idleTimer->start(remaining);
+    }
+
     static void callRepaintNeeded(QSvgRenderer *const q);
 
     static QtSvg::Options defaultOptions()
@@ -113,6 +146,8 @@ public:
 
     QSvgTinyDocument *render;
     QTimer *timer;
+    QTimer *idleTimer = nullptr;
+    QAtomicInt idleReleasePending;
     int fps;
     QtSvg::Options options;
     static QtSvg::Options appDefaultOptions;
@@ -281,6 +316,7 @@ void QSvgRenderer::setFramesPerSecond(int num)
         return;
     }
     d->fps = num;
+    d->bakeAnimations();
     d->startOrStopTimer();
 }
 
@@ -421,6 +457,7 @@ static bool loadDocument(QSvgRenderer *const q,
         d->render = nullptr;
     }
     d->startOrStopTimer();
+    d->bakeAnimations();
 
     if (d->render)
         d->render->restartAnimation();
@@ -476,6 +513,7 @@ void QSvgRenderer::render(QPainter *painter)
     if (d->render) {
         d->render->animator()->advanceAnimations();
         d->render->draw(painter);
+        d->scheduleIdleRelease();
     }
 }
 
@@ -498,6 +536,7 @@ void QSvgRenderer::render(QPainter *painter, const QString &elementId,
     if (d->render) {
         d->render->animator()->advanceAnimations();
         d->render->draw(painter, elementId, bounds);
+        d->scheduleIdleRelease();
     }
 }
 
@@ -513,6 +552,7 @@ void QSvgRenderer::render(QPainter *painter, const QRectF &bounds)
     if (d->render) {
         d->render->animator()->advanceAnimations();
         d->render->draw(painter, bounds);
+        d->scheduleIdleRelease();
     }
 }
 
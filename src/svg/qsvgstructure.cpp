@@ -9,6 +9,7 @@
 #include "qsvggraphics_p.h"
 #include "qsvgstyle_p.h"
 #include "qsvgfilter_p.h"
+#include "qsvgcaches_p.h"
 
 #include "qpainter.h"
 #include "qlocale.h"
@@ -16,7 +17,19 @@
 
 #include <QLoggingCategory>
 #include <qscopedvaluerollback.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadpool.h>
 #include <QtGui/qimageiohandler.h>
+#include <QtGui/qpaintengine.h>
+#include <QtGui/qregion.h>
+
+#include <QtCore/private/qsimd_p.h>
+#include <QtGui/private/qguiapplication_p.h>
+
+#include <algorithm>
+#include <utility>
 
 QT_BEGIN_NAMESPACE
 
@@ -57,6 +70,85 @@ bool QSvgG::requiresGroupRendering() const
     return m_renderers.count() > 1;
 }
 
+// Groups with more drawn children are drawn through a layer without analysis
+static constexpr int MaxFoldedChildren = 64;
+
+/*!
+    \internal
+
+    A group paints every pixel once if each drawn child does, and the
+    device pixels touched by the children do not overlap.
+
+    If nothing in the group is animated, the verdict only depends on the
+    state of \a p and \a states, so the last one is kept and reused while
+    that state stays the same. Animations elsewhere in the document do not
+    matter. Groups with many children are not analyzed.
+*/
+bool QSvgG::canFoldOpacity(QPainter *p, QSvgExtraStates &states) const
+{
+    FoldVerdict verdict{ p->transform(), QSvgPaintState::capture(p, states), p->opacity(),
+                         states.inUse, false };
+    bool memoize;
+    {
+        QMutexLocker locker(&m_foldMutex);
+        if (m_staticContent < 0)
+            m_staticContent = QSvgCacheBase::isStaticContent(this) ? 1 : 0;
+        memoize = m_staticContent;
+        if (memoize && m_foldVerdictValid && m_foldVerdict.sameState(verdict))
+            return m_foldVerdict.canFold;
+    }
+
+    verdict.canFold = childrenPaintOnce(p, states);
+
+    if (memoize) {
+        QMutexLocker locker(&m_foldMutex);
+        m_foldVerdict = verdict;
+        m_foldVerdictValid = true;
+    }
+    return verdict.canFold;
+}
+
+bool QSvgG::childrenPaintOnce(QPainter *p, QSvgExtraStates &states) const
+{
+    QList<QRect> painted;
+    int drawn = 0;
+    for (QSvgNode *node : std::as_const(m_renderers)) {
+        if (!node->isVisible() || node->displayMode() == QSvgNode::NoneMode)
+            continue;
+        switch (node->type()) {
+        case QSvgNode::Defs:
+        case QSvgNode::Mask:
+        case QSvgNode::ClipPath:
+        case QSvgNode::Pattern:
+        case QSvgNode::Filter:
+            continue;
+        case QSvgNode::Symbol:
+        case QSvgNode::Marker:
+            if (!states.inUse)
+                continue;
+            return false;
+        default:
+            break;
+        }
+        if (++drawn > MaxFoldedChildren || !node->paintsOnce(p, states))
+            return false;
+        const QRect rect = node->decoratedBounds(p, states).toAlignedRect();
+        if (!rect.isEmpty())
+            painted.append(rect);
+    }
+
+    std::sort(painted.begin(), painted.end(), [](const QRect &a, const QRect &b) {
+        return a.left() < b.left();
+    });
+    for (qsizetype i = 0; i < painted.size(); ++i) {
+        for (qsizetype j = i + 1; j < painted.size() && painted.at(j).left() <= painted.at(i).right(); ++j) {
+            if (painted.at(i).intersects(painted.at(j)))
+                return false;
+        }
+    }
+    return true;
+}
+
 QSvgStructureNode::QSvgStructureNode(QSvgNode *parent)
     :QSvgNode(parent)
 {
@@ -233,6 +325,8 @@ QSvgFilterContainer::QSvgFilterContainer(QSvgNode *parent, const QSvgRectF &boun
 
 }
 
+QSvgFilterContainer::~QSvgFilterContainer() = default;
+
 bool QSvgFilterContainer::shouldDrawNode(QPainter *, QSvgExtraStates &) const
 {
     return false;
@@ -261,134 +355,6 @@ void QSvgMarker::drawCommand(QPainter *p, QSvgExtraStates &states)
     p->restore();
 }
 
-namespace {
-
-struct PositionMarkerPair {
-    qreal x;
-    qreal y;
-    qreal angle;
-    QString markerId;
-    bool isStartNode = false;
-};
-
-QList<PositionMarkerPair> markersForNode(const QSvgNode *node)
-{
-    if (!node->hasAnyMarker())
-        return {};
-
-    auto getMeanAngle = [](QPointF p0, QPointF p1, QPointF p2) -> qreal {
-        QPointF t1 = p1 - p0;
-        QPointF t2 = p2 - p1;
-        qreal hyp1 =  hypot(t1.x(), t1.y());
-        if (hyp1 > 0)
-            t1 /= hyp1;
-        else
-            return 0.;
-        qreal hyp2 =  hypot(t2.x(), t2.y());
-        if (hyp2 > 0)
-            t2 /= hyp2;
-        else
-            return 0.;
-        QPointF tangent = t1 + t2;
-        return -atan2(tangent.y(), tangent.x()) / M_PI * 180.;
-    };
-
-    QList<PositionMarkerPair> markers;
-
-    switch (node->type()) {
-    case QSvgNode::Line: {
-        const QSvgLine *line = static_cast<const QSvgLine*>(node);
-        if (node->hasMarkerStart())
-            markers << PositionMarkerPair { line->line().p1().x(), line->line().p1().y(),
-                                            line->line().angle(), line->markerStartId(),
-                                            true};
-        if (node->hasMarkerEnd())
-            markers << PositionMarkerPair { line->line().p2().x(), line->line().p2().y(),
-                                            line->line().angle(), line->markerEndId() };
-        break;
-    }
-    case QSvgNode::Polyline:
-    case QSvgNode::Polygon: {
-        const QPolygonF &polyData = (node->type() == QSvgNode::Polyline)
-                ? static_cast<const QSvgPolyline*>(node)->polygon()
-                : static_cast<const QSvgPolygon*>(node)->polygon();
-
-        if (node->hasMarkerStart() && polyData.size() > 1) {
-            QLineF line(polyData.at(0), polyData.at(1));
-            markers << PositionMarkerPair { line.p1().x(),
-                                            line.p1().y(),
-                                            line.angle(),
-                                            node->markerStartId(),
-                                            true };
-        }
-        if (node->hasMarkerMid()) {
-            for (int i = 1; i < polyData.size() - 1; i++) {
-                QPointF p0 = polyData.at(i - 1);
-                QPointF p1 = polyData.at(i);
-                QPointF p2 = polyData.at(i + 1);
-
-                markers << PositionMarkerPair { p1.x(),
-                                                p1.y(),
-                                                getMeanAngle(p0, p1, p2),
-                                                node->markerStartId() };
-            }
-        }
-        if (node->hasMarkerEnd() && polyData.size() > 1) {
-            QLineF line(polyData.at(polyData.size() - 1), polyData.last());
-            markers << PositionMarkerPair { line.p2().x(),
-                                            line.p2().y(),
-                                            line.angle(),
-                                            node->markerEndId() };
-        }
-        break;
-    }
-    case QSvgNode::Path: {
-        const QSvgPath *path = static_cast<const QSvgPath*>(node);
-        if (node->hasMarkerStart())
-            markers << PositionMarkerPair { path->path().pointAtPercent(0.).x(),
-                                            path->path().pointAtPercent(0.).y(),
-                                            path->path().angleAtPercent(0.),
-                                            path->markerStartId(),
-                                            true };
-        if (node->hasMarkerMid()) {
-            for (int i = 1; i < path->path().elementCount() - 1; i++) {
-                if (path->path().elementAt(i).type == QPainterPath::MoveToElement)
-                    continue;
-                if (path->path().elementAt(i).type == QPainterPath::CurveToElement)
-                    continue;
-                if (( path->path().elementAt(i).type == QPainterPath::CurveToDataElement &&
-                      path->path().elementAt(i + 1).type != QPainterPath::CurveToDataElement ) ||
-                      path->path().elementAt(i).type == QPainterPath::LineToElement) {
-
-                    QPointF p0(path->path().elementAt(i - 1).x, path->path().elementAt(i - 1).y);
-                    QPointF p1(path->path().elementAt(i).x, path->path().elementAt(i).y);
-                    QPointF p2(path->path().elementAt(i + 1).x, path->path().elementAt(i + 1).y);
-
-                    markers << PositionMarkerPair { p1.x(),
-                                                    p1.y(),
-                                                    getMeanAngle(p0, p1, p2),
-                                                    path->markerMidId() };
-                }
-            }
-        }
-        if (node->hasMarkerEnd())
-            markers << PositionMarkerPair { path->path().pointAtPercent(1.).x(),
-                                            path->path().pointAtPercent(1.).y(),
-                                            path->path().angleAtPercent(1.),
-                                            path->markerEndId() };
-        break;
-    }
-    default:
-        Q_UNREACHABLE();
-        break;
-    }
-
-    return markers;
-}
-
-} // anonymous namespace
-
-
 void QSvgMarker::drawMarkersForNode(QSvgNode *node, QPainter *p, QSvgExtraStates &states)
 {
     drawHelper(node, p, states);
@@ -412,35 +378,60 @@ void QSvgMarker::drawHelper(const QSvgNode *node, QPainter *p,
     QScopedValueRollback<bool> inUseGuard(states.inUse, true);
 
     const bool isPainting = (boundingRect == nullptr);
-    const auto markers = markersForNode(node);
-    for (auto &i : markers) {
-        QSvgMarker *markNode = static_cast<QSvgMarker*>(node->document()->namedNode(i.markerId));
+    const auto &vertices = node->markerVertices();
+    if (vertices.isEmpty())
+        return;
+
+    const QSvgTinyDocument *doc = node->document();
+    QSvgMarker *const markNodes[] = {
+        static_cast<QSvgMarker*>(doc->namedNode(node->markerStartId())),
+        static_cast<QSvgMarker*>(doc->namedNode(node->markerMidId())),
+        static_cast<QSvgMarker*>(doc->namedNode(node->markerEndId()))
+    };
+
+    QHash<const QSvgMarker *, QRectF> localBounds;
+    for (const auto &i : vertices) {
+        QSvgMarker *markNode = markNodes[int(i.kind)];
         if (!markNode)
             continue;
 
-        p->save();
-        p->translate(i.x, i.y);
-        if (markNode->orientation() == QSvgMarker::Orientation::Value) {
-            p->rotate(markNode->orientationAngle());
-        } else {
-            p->rotate(-i.angle);
-            if (i.isStartNode && markNode->orientation()
-                        == QSvgMarker::Orientation::AutoStartReverse) {
-                p->scale(-1, -1);
-            }
+        qreal angle = markNode->orientationAngle();
+        bool reverse = false;
+        if (markNode->orientation() != QSvgMarker::Orientation::Value) {
+            angle = -i.angle;
+            reverse = i.kind == MarkerKind::Start
+                    && markNode->orientation() == QSvgMarker::Orientation::AutoStartReverse;
         }
+
         QRectF oldRect = markNode->m_rect;
         if (markNode->markerUnits() == QSvgMarker::MarkerUnits::StrokeWidth) {
             markNode->m_rect.setWidth(markNode->m_rect.width() * p->pen().widthF());
             markNode->m_rect.setHeight(markNode->m_rect.height() * p->pen().widthF());
         }
+
+        if (isPainting && markNode->drawInstance(p, states, i.position, angle, reverse)) {
+            markNode->m_rect = oldRect;
+            continue;
+        }
+
+        p->save();
+        p->translate(i.position);
+        p->rotate(angle);
+        if (reverse)
+            p->scale(-1, -1);
         if (isPainting)
             markNode->draw(p, states);
 
         if (boundingRect) {
-            QTransform xf = p->transform();
-            p->resetTransform();
-            *boundingRect |=  xf.mapRect(markNode->decoratedInternalBounds(p, states));
+            // The painter state is the same at every vertex, only the transform differs
+            auto it = localBounds.constFind(markNode);
+            if (it == localBounds.cend()) {
+                QTransform xf = p->transform();
+                p->resetTransform();
+                it = localBounds.insert(markNode, markNode->decoratedInternalBounds(p, states));
+                p->setTransform(xf);
+            }
+            *boundingRect |= p->transform().mapRect(it.value());
         }
 
         markNode->m_rect = oldRect;
@@ -448,7 +439,253 @@ void QSvgMarker::drawHelper(const QSvgNode *node, QPainter *p,
     }
 }
 
-QImage QSvgFilterContainer::applyFilter(const QImage &buffer, QPainter *p, const QRectF &bounds) const
+// Stamps are positioned in quarter pixels, in int
+static constexpr qreal MaxInstanceCoordinate = 1 << 28;
+// Larger markers are drawn directly, they rarely repeat at one transform
+static constexpr int MaxInstanceSize = 512;
+
+/*!
+    \internal
+
+    Draws the marker at \a position, rotated by \a angle degrees and turned
+    around if \a reverse is set, by stamping a raster of it from the
+    document's marker cache. The angle is rounded to a quarter degree and
+    the device position to a quarter pixel, so that a raster is reused at
+    every vertex with the same orientation and sub-pixel phase.
+
+    Returns \c false, without drawing, if the marker has to be drawn as is:
+    \a p does not rasterize or composites with a mode other than source
+    over, the marker is animated or too large, or the transform is a
+    perspective one.
+*/
+bool QSvgMarker::drawInstance(QPainter *p, QSvgExtraStates &states, QPointF position,
+                              qreal angle, bool reverse)
+{
+    if (m_recursing || !p->paintEngine() || p->paintEngine()->type() != QPaintEngine::Raster
+        || p->compositionMode() != QPainter::CompositionMode_SourceOver) {
+        return false;
+    }
+
+    const QTransform xf = p->transform();
+    const QPointF origin = xf.map(position);
+    if (xf.type() == QTransform::TxProject || !qIsFinite(origin.x()) || !qIsFinite(origin.y())
+        || qAbs(origin.x()) > MaxInstanceCoordinate || qAbs(origin.y()) > MaxInstanceCoordinate) {
+        return false;
+    }
+
+    QSvgMarkerCache *cache = document()->markerCache();
+    if (!cache->isCacheable(this))
+        return false;
+
+    const int originX = qRound(origin.x() * 4);
+    const int originY = qRound(origin.y() * 4);
+    QTransform transform;
+    transform.rotate(qRound(angle * 4) / 4.0);
+    if (reverse)
+        transform.scale(-1, -1);
+    transform *= QTransform(xf.m11(), xf.m12(), xf.m21(), xf.m22(),
+                            (originX & 3) / 4.0, (originY & 3) / 4.0);
+
+    QImage stamp;
+    if (!cache->find(this, transform, m_rect.size(), p, states, &stamp)) {
+        stamp = renderInstance(p, states, transform);
+        if (stamp.isNull())
+            return false;
+        cache->insert(this, transform, m_rect.size(), p, states, stamp);
+    }
+
+    // The painter opacity is part of the stamp
+    p->save();
+    p->resetTransform();
+    p->setOpacity(1);
+    p->drawImage(QPoint(originX >> 2, originY >> 2) + stamp.offset(), stamp);
+    p->restore();
+    return true;
+}
+
+/*!
+    \internal
+
+    Renders the marker with \a transform into an image with the offset of
+    its top left corner from the origin, in the state of \a p and
+    \a states. Returns a null image if the marker is empty or too large to
+    be stamped.
+*/
+QImage QSvgMarker::renderInstance(QPainter *p, QSvgExtraStates &states, const QTransform &transform)
+{
+    const QTransform xf = p->transform();
+    p->setTransform(transform);
+    applyStyle(p, states);
+    p->save();
+    setPainterToRectAndAdjustment(p);
+    const QRectF bounds = QSvgStructureNode::decoratedInternalBounds(p, states);
+    p->restore();
+    revertStyle(p, states);
+    p->setTransform(xf);
+
+    QImage stamp;
+    const QRect rect = bounds.toAlignedRect().adjusted(-1, -1, 1, 1);
+    if (bounds.isEmpty() || rect.width() > MaxInstanceSize || rect.height() > MaxInstanceSize)
+        return stamp;
+    if (!QImageIOHandler::allocateImage(rect.size(), QImage::Format_ARGB32_Premultiplied, &stamp))
+        return stamp;
+    stamp.setOffset(rect.topLeft());
+    stamp.fill(Qt::transparent);
+
+    QPainter stampPainter(&stamp);
+    stampPainter.setPen(p->pen());
+    stampPainter.setBrush(p->brush());
+    stampPainter.setFont(p->font());
+    stampPainter.setRenderHints(p->renderHints());
+    stampPainter.setOpacity(p->opacity());
+    stampPainter.setTransform(transform * QTransform::fromTranslate(-rect.left(), -rect.top()));
+    draw(&stampPainter, states);
+    return stamp;
+}
+
+/*!
+    \internal
+
+    Turns the filter primitives into a graph of steps that read and write
+    numbered result slots. A step only depends on the steps that produce
+    its inputs, and steps of the same level are independent of each other.
+    A primitive without an \c in attribute reads the result of the previous
+    primitive, which is transparent black where that result is empty, for
+    example outside its subregion.
+    Steps that do not contribute to the filter result are dropped, and each
+    slot is released after the last level that reads it.
+
+    Slots are in the color space of the step that produced them, and the
+    source graphic and the filter result are in sRGB. Where a primitive reads
+    a slot in the other color space, a conversion step is added, once per
+    slot no matter how many primitives read it.
+
+    The drop shadow idiom of blur, offset, tint and merge primitives is
+    replaced by a single drop shadow step, see QSvgFeDropShadow::fuse().
+*/
+void QSvgFilterContainer::compile()
+{
+    QList<Step> steps;
+    QHash<QString, int> namedSlots;
+    namedSlots.insert(QStringLiteral("SourceGraphic"), SourceGraphicSlot);
+    namedSlots.insert(QStringLiteral("SourceAlpha"), SourceAlphaSlot);
+    QList<int> slotLevels = { 0, 0 };
+    QList<QtSvg::ColorSpace> slotColorSpaces = { QtSvg::ColorSpace::sRGB, QtSvg::ColorSpace::sRGB };
+    QHash<int, int> convertedSlots;
+    int previousSlot = SourceGraphicSlot;
+
+    // The source alpha has no color, and is the same in either color space
+    auto convertSlot = [&](int slot, QtSvg::ColorSpace colorSpace) {
+        if (slot < 0 || slot == SourceAlphaSlot || slotColorSpaces.at(slot) == colorSpace)
+            return slot;
+        if (const auto it = convertedSlots.constFind(slot); it != convertedSlots.cend())
+            return it.value();
+
+        Step conversion;
+        conversion.inputs.append(slot);
+        conversion.level = slotLevels.at(slot) + 1;
+        conversion.output = int(slotLevels.size());
+        conversion.colorSpace = colorSpace;
+        slotLevels.append(conversion.level);
+        slotColorSpaces.append(colorSpace);
+        convertedSlots.insert(slot, conversion.output);
+        steps.append(conversion);
+        return conversion.output;
+    };
+
+    QList<const QSvgFeFilterPrimitive *> primitives;
+    for (const QSvgNode *renderer : renderers()) {
+        if (const QSvgFeFilterPrimitive *filter = QSvgFeFilterPrimitive::castToFilterPrimitive(renderer))
+            primitives.append(filter);
+    }
+
+    // Drop shadows blur exactly, so they are not fused where large blurs are approximated
+    m_fusedPrimitives.clear();
+    const bool fuse = !document() || !document()->options().testFlag(QtSvg::ApproximateLargeBlurs);
+    for (qsizetype i = 0; fuse && i < primitives.size(); ++i) {
+        qsizetype count = 0;
+        if (QSvgFeDropShadow *dropShadow = QSvgFeDropShadow::fuse(this, primitives, i, &count)) {
+            m_fusedPrimitives.emplace_back(dropShadow);
+            primitives.replace(i, dropShadow);
+            primitives.remove(i + 1, count - 1);
+        }
+    }
+
+    for (const QSvgFeFilterPrimitive *filter : std::as_const(primitives)) {
+        Step step;
+        step.primitive = filter;
+        step.colorSpace = filter->colorSpace();
+        const QStringList inputs = filter->inputs();
+        for (const QString &input : inputs) {
+            const int slot = convertSlot(input.isEmpty() ? previousSlot : namedSlots.value(input, -1),
+                                         step.colorSpace);
+            step.inputs.append(slot);
+            if (slot >= 0)
+                step.level = qMax(step.level, slotLevels.at(slot));
+        }
+        step.level += 1;
+        step.output = int(slotLevels.size());
+        slotLevels.append(step.level);
+        slotColorSpaces.append(step.colorSpace);
+        namedSlots.insert(filter->result(), step.output);
+        previousSlot = step.output;
+        steps.append(step);
+    }
+
+    // The last primitive renders into a buffer of its own, clipped to its subregion
+    if (!steps.isEmpty())
+        steps.last().producesResult = true;
+    const int resultSlot = steps.isEmpty() ? -1 : convertSlot(previousSlot, QtSvg::ColorSpace::sRGB);
+
+    m_steps.clear();
+    m_slotCount = int(slotLevels.size());
+    m_resultSlot = resultSlot;
+
+    // Walk backwards from the result to find the steps that contribute to it
+    QList<bool> live(m_slotCount, false);
+    if (m_resultSlot >= 0)
+        live[m_resultSlot] = true;
+    for (qsizetype i = steps.size() - 1; i >= 0; --i) {
+        if (!live.at(steps.at(i).output))
+            continue;
+        for (int slot : std::as_const(steps.at(i).inputs)) {
+            if (slot >= 0)
+                live[slot] = true;
+        }
+        m_steps.prepend(steps.at(i));
+    }
+    m_usesSourceAlpha = live.at(SourceAlphaSlot);
+
+    std::stable_sort(m_steps.begin(), m_steps.end(), [](const Step &a, const Step &b) {
+        return a.level < b.level;
+    });
+
+    // Release every slot with the last step that reads it
+    QList<qsizetype> lastUse(m_slotCount, -1);
+    for (qsizetype i = 0; i < m_steps.size(); ++i) {
+        for (int slot : std::as_const(m_steps.at(i).inputs)) {
+            if (slot >= 0)
+                lastUse[slot] = i;
+        }
+    }
+    for (int slot = 0; slot < m_slotCount; ++slot) {
+        if (lastUse.at(slot) >= 0 && slot != m_resultSlot)
+            m_steps[lastUse.at(slot)].releases.append(slot);
+    }
+}
+
+/*!
+    \internal
+
+    Applies the filter to \a buffer, the source graphic rendered in device
+    coordinates, for an item with the local \a bounds.
+
+    If \a tile is not null, only that part of the result is produced.
+    \a buffer then needs to cover the tile and the footprint() around it,
+    and primitives only compute the pixels within the buffer.
+*/
+QImage QSvgFilterContainer::applyFilter(const QImage &buffer, QPainter *p, const QRectF &bounds,
+                                        const QRect &tile) const
 {
     QRectF localFilterRegion = m_rect.resolveRelativeLengths(bounds, m_filterUnits);
     QRect globalFilterRegion = p->transform().mapRect(localFilterRegion).toRect();
@@ -457,51 +694,159 @@ QImage QSvgFilterContainer::applyFilter(const QImage &buffer, QPainter *p, const
     if (globalFilterRegionRel.isEmpty())
         return buffer;
 
-    QImage proxy;
-    if (!QImageIOHandler::allocateImage(globalFilterRegionRel.size(), buffer.format(), &proxy)) {
-        qCWarning(lcSvgDraw) << "The requested filter is too big, ignoring";
-        return buffer;
-    }
-    proxy = buffer.copy(globalFilterRegionRel);
-    proxy.setOffset(globalFilterRegion.topLeft());
-    if (proxy.isNull())
-        return buffer;
-
-    QMap<QString, QImage> buffers;
-    buffers[QStringLiteral("")] = proxy;
-    buffers[QStringLiteral("SourceGraphic")] = proxy;
-
-    bool requiresSourceAlpha = false;
+    if (m_resultSlot < 0)
+        return QImage();
 
-    const QList<QSvgNode *> children = renderers();
-    for (const QSvgNode *renderer : children) {
-        const QSvgFeFilterPrimitive *filter = QSvgFeFilterPrimitive::castToFilterPrimitive(renderer);
-        if (filter && filter->requiresSourceAlpha()) {
-            requiresSourceAlpha = true;
-            break;
+    // The source graphic is clipped to the filter region, which usually is
+    // the area the buffer was rendered for already
+    QImage proxy = buffer;
+    if (!globalFilterRegion.contains(QRect(buffer.offset(), buffer.size()))) {
+        if (!QImageIOHandler::allocateImage(globalFilterRegionRel.size(), buffer.format(), &proxy)) {
+            qCWarning(lcSvgDraw) << "The requested filter is too big, ignoring";
+            return buffer;
         }
+        proxy = buffer.copy(globalFilterRegionRel);
+        proxy.setOffset(globalFilterRegion.topLeft());
+        if (proxy.isNull())
+            return buffer;
     }
 
-    if (requiresSourceAlpha) {
-        QImage proxyAlpha = proxy.convertedTo(QImage::Format_Alpha8).convertedTo(proxy.format());
-        proxyAlpha.setOffset(proxy.offset());
-        if (proxyAlpha.isNull())
+    QSvgFilterBufferPool pool;
+    if (!tile.isNull())
+        pool.setRegion(QRect(proxy.offset(), proxy.size()));
+    QList<QSvgFilterBuffer> slots(m_slotCount);
+    slots[SourceGraphicSlot] = QSvgFilterBuffer(proxy);
+
+    if (m_usesSourceAlpha) {
+        QImage proxyAlpha;
+        if (!pool.allocate(proxy.size(), &proxyAlpha))
             return buffer;
-        buffers[QStringLiteral("SourceAlpha")] = proxyAlpha;
+        for (int y = 0; y < proxy.height(); ++y) {
+            const QRgb *src = reinterpret_cast<const QRgb *>(proxy.constScanLine(y));
+            QRgb *dst = reinterpret_cast<QRgb *>(proxyAlpha.scanLine(y));
+            for (int x = 0; x < proxy.width(); ++x)
+                dst[x] = src[x] & 0xff000000;
+        }
+        proxyAlpha.setOffset(proxy.offset());
+        slots[SourceAlphaSlot] = QSvgFilterBuffer(proxyAlpha);
     }
 
-    QImage result;
-    for (const QSvgNode *renderer : children) {
-        const QSvgFeFilterPrimitive *filter = QSvgFeFilterPrimitive::castToFilterPrimitive(renderer);
-        if (filter) {
-            result = filter->apply(buffers, p, bounds, localFilterRegion, m_primitiveUnits, m_filterUnits);
-            if (!result.isNull()) {
-                buffers[QStringLiteral("")] = result;
-                buffers[filter->result()] = result;
+    QSvgFilterBuffer *slotData = slots.data();
+    auto runStep = [&](const Step &step) {
+        QSvgFilterInputs inputs;
+        for (int slot : step.inputs)
+            inputs.append(slot >= 0 ? slotData[slot] : QSvgFilterBuffer());
+
+        QSvgFilterBuffer &output = slotData[step.output];
+        if (!step.primitive) {
+            output = inputs.at(0).toColorSpace(step.colorSpace, &pool);
+            return;
+        }
+        if (step.producesResult
+            || !step.primitive->applyWithoutBuffer(inputs, p, bounds, localFilterRegion,
+                                                   m_primitiveUnits, m_filterUnits, &output)) {
+            output = QSvgFilterBuffer(step.primitive->apply(inputs, &pool, p, bounds, localFilterRegion,
+                                                            m_primitiveUnits, m_filterUnits));
+        } else if (output.isFlood() && !pool.region().isNull()) {
+            output = QSvgFilterBuffer::flood(pool.clipToRegion(output.rect()), output.floodColor());
+        }
+    };
+
+    for (qsizetype first = 0; first < m_steps.size();) {
+        qsizetype end = first + 1;
+        while (end < m_steps.size() && m_steps.at(end).level == m_steps.at(first).level)
+            ++end;
+
+        // Steps of one level only read results of earlier levels
+#if QT_CONFIG(thread) && !defined(Q_OS_WASM)
+        QThreadPool *threadPool = QGuiApplicationPrivate::qtGuiThreadPool();
+        if (end - first > 1 && threadPool && !threadPool->contains(QThread::currentThread())) {
+            QSemaphore semaphore;
+            for (qsizetype i = first + 1; i < end; ++i) {
+                threadPool->start([&, i]() {
+                    runStep(m_steps.at(i));
+                    semaphore.release(1);
+                });
             }
+            runStep(m_steps.at(first));
+            semaphore.acquire(int(end - first - 1));
+        } else
+#endif
+        {
+            for (qsizetype i = first; i < end; ++i)
+                runStep(m_steps.at(i));
         }
+
+        for (qsizetype i = first; i < end; ++i) {
+            for (int slot : m_steps.at(i).releases) {
+                QSvgFilterBuffer released = std::exchange(slots[slot], QSvgFilterBuffer());
+                if (!released.isFlood()) {
+                    QImage image = released.image();
+                    released = QSvgFilterBuffer();
+                    pool.recycle(std::move(image));
+                }
+            }
+        }
+        first = end;
     }
-    return result;
+
+    const QImage result = slots.at(m_resultSlot).toImage();
+    if (tile.isNull() || result.isNull())
+        return result;
+
+    const QRect rect = QRect(result.offset(), result.size()).intersected(tile);
+    QImage cropped = result.copy(rect.translated(-result.offset()));
+    cropped.setOffset(rect.topLeft());
+    return cropped;
+}
+
+/*!
+    \internal
+
+    Returns how far, in device pixels, the result of the filter depends on
+    source pixels around it. This is the sum of the footprints of all
+    primitives, which bounds the footprint of every chain of them.
+*/
+QMargins QSvgFilterContainer::footprint(QPainter *p, const QRectF &bounds) const
+{
+    QMargins margins;
+    for (const Step &step : m_steps) {
+        if (step.primitive)
+            margins += step.primitive->footprint(p, bounds, m_primitiveUnits);
+    }
+    return margins;
+}
+
+Q_CONSTINIT static QBasicAtomicInt filterTileSize = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+/*!
+    \internal
+
+    Returns the size of the tiles, in device pixels, that filter regions
+    larger than it in either direction are evaluated in. The default of 2048
+    can be changed with the \c QT_SVG_FILTER_TILE_SIZE environment variable,
+    which is read once, or with setTileSize().
+*/
+int QSvgFilterContainer::tileSize()
+{
+    static const int environmentSize = [] {
+        bool ok = false;
+        const int size = qEnvironmentVariableIntValue("QT_SVG_FILTER_TILE_SIZE", &ok);
+        return ok && size > 0 ? qMax(16, size) : 2048;
+    }();
+    const int size = filterTileSize.loadRelaxed();
+    return size > 0 ? size : environmentSize;
+}
+
+/*!
+    \internal
+
+    Overrides the tile size with \a size, at least 16. A \a size of 0
+    restores the default.
+*/
+void QSvgFilterContainer::setTileSize(int size)
+{
+    filterTileSize.storeRelaxed(size > 0 ? qMax(16, size) : 0);
 }
 
 void QSvgFilterContainer::setSupported(bool supported)
@@ -704,19 +1049,96 @@ QImage QSvgMask::createMask(QPainter *p, QSvgExtraStates &states, QSvgNode *targ
     return createMask(p, states, basicRect, globalRect);
 }
 
+/*!
+    \internal
+
+    Returns the mask for a target with the local bounds \a localRect, as an
+    Format_Alpha8 image that covers \a globalRect, aligned to device pixels.
+    The alpha of the image is the luminance of the mask content times its
+    alpha, and 0 outside of the mask region.
+*/
 QImage QSvgMask::createMask(QPainter *p, QSvgExtraStates &states, const QRectF &localRect, QRectF *globalRect) const
 {
-    QRect imageBound = globalRect->toAlignedRect();
+    const QRect imageBound = globalRect->toAlignedRect();
     *globalRect = imageBound.toRectF();
 
+    QSvgMaskCache *cache = document() ? document()->maskCache() : nullptr;
     QImage mask;
-    if (!QImageIOHandler::allocateImage(imageBound.size(), QImage::Format_RGBA8888, &mask)) {
+    if (cache && !m_recursing && cache->find(this, localRect, p->transform(), imageBound, &mask))
+        return mask;
+
+    mask = renderMask(p, states, localRect, imageBound);
+    if (cache && !m_recursing)
+        cache->insert(this, localRect, p->transform(), imageBound, mask);
+    return mask;
+}
+
+namespace {
+
+// Weights of the SVG 1.1 luminanceToAlpha in 1/32768, which sum to 32768
+constexpr int LuminanceRed = 6963;
+constexpr int LuminanceGreen = 23442;
+constexpr int LuminanceBlue = 2363;
+
+// On premultiplied pixels, the luminance is already multiplied by the alpha
+void luminanceToAlpha(const QRgb *src, uchar *dst, int count)
+{
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i colorMask = _mm_set1_epi32(0x00ff00ff);
+    const __m128i greenMask = _mm_set1_epi32(0xff);
+    const __m128i redBlueWeights = _mm_set1_epi32((LuminanceRed << 16) | LuminanceBlue);
+    const __m128i greenWeight = _mm_set1_epi32(LuminanceGreen);
+    const __m128i half = _mm_set1_epi32(1 << 14);
+    auto luminance = [&](__m128i pixels) {
+        const __m128i redBlue = _mm_madd_epi16(_mm_and_si128(pixels, colorMask), redBlueWeights);
+        const __m128i green = _mm_madd_epi16(_mm_and_si128(_mm_srli_epi32(pixels, 8), greenMask),
+                                             greenWeight);
+        return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(redBlue, green), half), 15);
+    };
+    for (; x + 8 <= count; x += 8) {
+        const __m128i low = luminance(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x)));
+        const __m128i high = luminance(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + 4)));
+        const __m128i packed = _mm_packs_epi32(low, high);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(packed, packed));
+    }
+#elif defined(__ARM_NEON__) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    for (; x + 8 <= count; x += 8) {
+        const uint8x8x4_t pixels = vld4_u8(reinterpret_cast<const uint8_t *>(src + x));
+        const uint16x8_t blue = vmovl_u8(pixels.val[0]);
+        const uint16x8_t green = vmovl_u8(pixels.val[1]);
+        const uint16x8_t red = vmovl_u8(pixels.val[2]);
+        uint32x4_t low = vmull_n_u16(vget_low_u16(red), LuminanceRed);
+        low = vmlal_n_u16(low, vget_low_u16(green), LuminanceGreen);
+        low = vmlal_n_u16(low, vget_low_u16(blue), LuminanceBlue);
+        uint32x4_t high = vmull_n_u16(vget_high_u16(red), LuminanceRed);
+        high = vmlal_n_u16(high, vget_high_u16(green), LuminanceGreen);
+        high = vmlal_n_u16(high, vget_high_u16(blue), LuminanceBlue);
+        vst1_u8(dst + x, vmovn_u16(vcombine_u16(vrshrn_n_u32(low, 15), vrshrn_n_u32(high, 15))));
+    }
+#endif
+    for (; x < count; ++x) {
+        const QRgb pixel = src[x];
+        dst[x] = uchar((qRed(pixel) * LuminanceRed + qGreen(pixel) * LuminanceGreen
+                        + qBlue(pixel) * LuminanceBlue + (1 << 14)) >> 15);
+    }
+}
+
+} // anonymous namespace
+
+QImage QSvgMask::renderMask(QPainter *p, QSvgExtraStates &states, const QRectF &localRect,
+                            const QRect &imageBound) const
+{
+    QImage mask;
+    if (!QImageIOHandler::allocateImage(imageBound.size(), QImage::Format_Alpha8, &mask)) {
         qCWarning(lcSvgDraw) << "The requested mask size is too big, ignoring";
         return mask;
     }
 
-    if (Q_UNLIKELY(m_recursing))
+    if (Q_UNLIKELY(m_recursing)) {
+        mask.fill(0);
         return mask;
+    }
     QScopedValueRollback<bool> recursingGuard(m_recursing, true);
 
     // Chrome seems to return the mask of the mask if a mask is set on the mask
@@ -731,11 +1153,14 @@ QImage QSvgMask::createMask(QPainter *p, QSvgExtraStates &states, const QRectF &
     // The mask is created with other elements during rendering.
     // Black pixels are masked out, white pixels are not masked.
     // The strategy is to draw the elements in a buffer (QImage) and to map
-    // the white-black image into a transparent-white image that can be used
-    // with QPainters composition mode to set the mask.
-
-    mask.fill(Qt::transparent);
-    QPainter painter(&mask);
+    // its luminance into the alpha of the mask.
+    QImage content;
+    if (!document()->scratchBuffers()->allocate(imageBound.size(), &content)) {
+        qCWarning(lcSvgDraw) << "The requested mask size is too big, ignoring";
+        return QImage();
+    }
+    content.fill(Qt::transparent);
+    QPainter painter(&content);
     initPainter(&painter);
 
     QSvgExtraStates maskNodeStates;
@@ -762,15 +1187,6 @@ QImage QSvgMask::createMask(QPainter *p, QSvgExtraStates &states, const QRectF &
         ++itr;
     }
 
-    for (int i=0; i < mask.height(); i++) {
-        QRgb *line = reinterpret_cast<QRgb *>(mask.scanLine(i));
-        for (int j=0; j < mask.width(); j++) {
-            const qreal rC = 0.2125, gC = 0.7154, bC = 0.0721; //luminanceToAlpha times alpha following SVG 1.1
-            int alpha = 255 - (qRed(line[j]) * rC + qGreen(line[j]) * gC + qBlue(line[j]) * bC) * qAlpha(line[j])/255.;
-            line[j] = qRgba(0, 0, 0, alpha);
-        }
-    }
-
     // Make a path out of the clipRectangle and draw it inverted - black over all content items.
     // This is required to apply a clip rectangle with transformations.
     // painter.setClipRect(clipRect) sounds like the obvious thing to do but
@@ -778,11 +1194,18 @@ QImage QSvgMask::createMask(QPainter *p, QSvgExtraStates &states, const QRectF &
     QRectF clipRect = m_rect.resolveRelativeLengths(localRect);
     QPainterPath clipPath;
     clipPath.setFillRule(Qt::OddEvenFill);
-    clipPath.addRect(mask.rect().adjusted(-10, -10, 20, 20));
+    clipPath.addRect(content.rect().adjusted(-10, -10, 20, 20));
     clipPath.addPolygon(oldT.map(QPolygonF(clipRect)));
     painter.resetTransform();
     painter.fillPath(clipPath, Qt::black);
     revertStyleRecursive(&painter, maskNodeStates);
+    painter.end();
+
+    for (int y = 0; y < content.height(); ++y) {
+        luminanceToAlpha(reinterpret_cast<const QRgb *>(content.constScanLine(y)),
+                         mask.scanLine(y), content.width());
+    }
+    document()->scratchBuffers()->recycle(std::move(content));
     return mask;
 }
 
@@ -791,6 +1214,156 @@ QSvgNode::Type QSvgMask::type() const
     return Mask;
 }
 
+QSvgClipPath::QSvgClipPath(QSvgNode *parent, QtSvg::UnitTypes contentUnits)
+    : QSvgStructureNode(parent)
+    , m_contentUnits(contentUnits)
+{
+}
+
+bool QSvgClipPath::shouldDrawNode(QPainter *, QSvgExtraStates &) const
+{
+    return false;
+}
+
+/*!
+    \internal
+
+    Returns the clip region for \a target, in the coordinates of the device
+    of \a p, whose transform maps from the user space of the target.
+
+    The region is the union of the geometry of the children, each with its
+    own transform, clip-rule and clip-path. Shapes, and uses of shapes, are
+    combined as paths, so that the target can be clipped by the painter
+    without drawing into an offscreen buffer. Only text, which has no path
+    geometry, is rasterized.
+*/
+QPainterPath QSvgClipPath::clipPath(QPainter *p, const QSvgNode *target) const
+{
+    // A clip path that references itself clips everything away
+    if (Q_UNLIKELY(m_recursing))
+        return QPainterPath();
+    QScopedValueRollback<bool> recursingGuard(m_recursing, true);
+
+    const QTransform oldT = p->transform();
+    QSvgExtraStates clipStates;
+
+    QTransform xf = oldT;
+    if (m_style.transform)
+        xf = m_style.transform->qtransform() * xf;
+    if (m_contentUnits == QtSvg::UnitTypes::objectBoundingBox) {
+        // The bounding box of the fill geometry, without the stroke
+        const QPen oldPen = p->pen();
+        p->setPen(Qt::NoPen);
+        p->resetTransform();
+        const QRectF box = target->internalBounds(p, clipStates);
+        p->setPen(oldPen);
+        xf = QTransform(box.width(), 0, 0, box.height(), box.x(), box.y()) * xf;
+    }
+
+    QPainterPath path;
+    for (QSvgNode *node : std::as_const(m_renderers)) {
+        if (!node->isVisible() || node->displayMode() == QSvgNode::NoneMode)
+            continue;
+        p->setTransform(xf);
+        const QPainterPath nodePath = childClipPath(p, clipStates, node);
+        if (!nodePath.isEmpty())
+            path = path.isEmpty() ? nodePath : path.united(nodePath);
+    }
+    p->setTransform(oldT);
+
+    // A clip-path on the clipPath element further clips the region
+    if (!path.isEmpty() && hasClipPath()) {
+        QSvgNode *clipNode = document()->namedNode(clipPathId());
+        if (clipNode && clipNode->type() == QSvgNode::ClipPath)
+            path = path.intersected(static_cast<QSvgClipPath *>(clipNode)->clipPath(p, target));
+    }
+    return path;
+}
+
+QPainterPath QSvgClipPath::childClipPath(QPainter *p, QSvgExtraStates &states, QSvgNode *node)
+{
+    node->applyStyle(p, states);
+    node->applyAnimatedStyle(p, states);
+
+    QPainterPath path;
+    QPainterPath geometry;
+    if (node->type() == QSvgNode::Use) {
+        // Only uses of shapes and text are valid in a clip path
+        const QSvgUse *use = static_cast<const QSvgUse *>(node);
+        QSvgNode *link = use->link();
+        if (link && link->type() != QSvgNode::Use && link->isVisible()
+            && link->displayMode() != QSvgNode::NoneMode) {
+            p->translate(use->start());
+            path = childClipPath(p, states, link);
+        }
+    } else if (node->geometry(&geometry)) {
+        geometry.setFillRule(node->clipRule());
+        path = p->transform().map(geometry);
+    } else if (node->type() == QSvgNode::Text || node->type() == QSvgNode::Textarea) {
+        path = rasterClipPath(p, states, node);
+    }
+
+    if (!path.isEmpty() && node->hasClipPath()) {
+        QSvgNode *clipNode = node->document()->namedNode(node->clipPathId());
+        if (clipNode && clipNode->type() == QSvgNode::ClipPath)
+            path = path.intersected(static_cast<QSvgClipPath *>(clipNode)->clipPath(p, node));
+    }
+
+    node->revertAnimatedStyle(p, states);
+    node->revertStyle(p, states);
+    return path;
+}
+
+/*!
+    \internal
+
+    Returns the device pixels covered by \a node, for children without a
+    path geometry. The glyphs are drawn into a buffer and every pixel with
+    a coverage of at least one half becomes part of the clip region.
+*/
+QPainterPath QSvgClipPath::rasterClipPath(QPainter *p, QSvgExtraStates &states, QSvgNode *node)
+{
+    QPainterPath path;
+    const QRect deviceRect = node->internalBounds(p, states).toAlignedRect();
+    if (deviceRect.isEmpty())
+        return path;
+
+    // The fill and stroke of the child are not part of its clip geometry
+    p->save();
+    p->setPen(Qt::NoPen);
+    p->setBrush(Qt::black);
+    const QImage coverage = node->drawIntoBuffer(p, states, deviceRect);
+    p->restore();
+    if (coverage.isNull())
+        return path;
+
+    QList<QRect> rects;
+    const int width = coverage.width();
+    for (int y = 0; y < coverage.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(coverage.constScanLine(y));
+        int x = 0;
+        while (x < width) {
+            while (x < width && qAlpha(line[x]) < 128)
+                ++x;
+            const int start = x;
+            while (x < width && qAlpha(line[x]) >= 128)
+                ++x;
+            if (x > start)
+                rects.append(QRect(coverage.offset() + QPoint(start, y), QSize(x - start, 1)));
+        }
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), int(rects.size()));
+    path.addRegion(region);
+    return path;
+}
+
+QSvgNode::Type QSvgClipPath::type() const
+{
+    return ClipPath;
+}
+
 QSvgPattern::QSvgPattern(QSvgNode *parent, QSvgRectF bounds, QRectF viewBox,
                          QtSvg::UnitTypes contentUnits, QTransform transform)
     : QSvgStructureNode(parent),
@@ -861,7 +1434,16 @@ QImage QSvgPattern::patternImage(QPainter *p, QSvgExtraStates &states, const QSv
     imageSize.setHeight(qCeil(patternBoundingBox.height() * t.m22() * m_transform.m22()));
 
     calculateAppliedTransform(t, peBoundingBox, imageSize);
-    return renderPattern(imageSize, contentScaleFactorX, contentScaleFactorY);
+
+    QSvgPatternCache *patternCache = document()->patternCache();
+    QImage pattern;
+    if (!patternCache->find(this, imageSize, contentScaleFactorX, contentScaleFactorY, &pattern)) {
+        pattern = renderPattern(imageSize, contentScaleFactorX, contentScaleFactorY);
+        // The checker pattern that stands in for a tile that cannot be rendered is not kept
+        if (pattern.size() == imageSize)
+            patternCache->insert(this, imageSize, contentScaleFactorX, contentScaleFactorY, pattern);
+    }
+    return pattern;
 }
 
 QSvgNode::Type QSvgPattern::type() const
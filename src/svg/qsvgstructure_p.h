@@ -16,9 +16,15 @@
 //
 
 #include "qsvgnode_p.h"
+#include "qsvgcaches_p.h"
 
 #include "QtCore/qlist.h"
 #include "QtCore/qhash.h"
+#include "QtCore/qmargins.h"
+#include "QtCore/qvarlengtharray.h"
+
+#include <memory>
+#include <vector>
 
 QT_BEGIN_NAMESPACE
 
@@ -26,6 +32,7 @@ class QSvgTinyDocument;
 class QSvgNode;
 class QPainter;
 class QSvgDefs;
+class QSvgFeFilterPrimitive;
 
 class Q_SVG_EXPORT QSvgStructureNode : public QSvgNode
 {
@@ -53,6 +60,29 @@ public:
     bool shouldDrawNode(QPainter *p, QSvgExtraStates &states) const override;
     Type type() const override;
     bool requiresGroupRendering() const override;
+    bool canFoldOpacity(QPainter *p, QSvgExtraStates &states) const override;
+private:
+    bool childrenPaintOnce(QPainter *p, QSvgExtraStates &states) const;
+
+    // The last verdict of canFoldOpacity() and the state it was reached in
+    struct FoldVerdict
+    {
+        QTransform transform;
+        QSvgPaintState state;
+        qreal opacity;
+        bool inUse;
+        bool canFold;
+
+        bool sameState(const FoldVerdict &other) const
+        {
+            return transform == other.transform && opacity == other.opacity
+                    && inUse == other.inUse && state == other.state;
+        }
+    };
+    mutable QMutex m_foldMutex;
+    mutable FoldVerdict m_foldVerdict;
+    mutable bool m_foldVerdictValid = false;
+    mutable qint8 m_staticContent = -1;
 };
 
 class Q_SVG_EXPORT QSvgDefs : public QSvgStructureNode
@@ -154,6 +184,9 @@ public:
 private:
     static void drawHelper(const QSvgNode *node, QPainter *p,
                            QSvgExtraStates &states, QRectF *boundingRect = nullptr);
+    bool drawInstance(QPainter *p, QSvgExtraStates &states, QPointF position,
+                      qreal angle, bool reverse);
+    QImage renderInstance(QPainter *p, QSvgExtraStates &states, const QTransform &transform);
 
     Orientation m_orientation;
     qreal m_orientationAngle;
@@ -165,18 +198,46 @@ class Q_SVG_EXPORT QSvgFilterContainer : public QSvgStructureNode
 public:
 
     QSvgFilterContainer(QSvgNode *parent, const QSvgRectF &bounds, QtSvg::UnitTypes filterUnits, QtSvg::UnitTypes primitiveUnits);
+    ~QSvgFilterContainer();
     void drawCommand(QPainter *, QSvgExtraStates &) override {};
     bool shouldDrawNode(QPainter *, QSvgExtraStates &) const override;
     Type type() const override;
-    QImage applyFilter(const QImage &buffer, QPainter *p, const QRectF &bounds) const;
+    QImage applyFilter(const QImage &buffer, QPainter *p, const QRectF &bounds,
+                       const QRect &tile = QRect()) const;
+    QMargins footprint(QPainter *p, const QRectF &bounds) const;
+    static int tileSize();
+    static void setTileSize(int size);
     void setSupported(bool supported);
     bool supported() const;
     QRectF filterRegion(const QRectF &itemBounds) const;
+    void compile();
 private:
+    enum : int {
+        SourceGraphicSlot,
+        SourceAlphaSlot,
+        FirstResultSlot
+    };
+
+    // A step without a primitive converts its input into colorSpace
+    struct Step {
+        const QSvgFeFilterPrimitive *primitive = nullptr;
+        QVarLengthArray<int, 2> inputs;
+        QVarLengthArray<int, 2> releases;
+        int output = -1;
+        int level = 0;
+        QtSvg::ColorSpace colorSpace = QtSvg::ColorSpace::sRGB;
+        bool producesResult = false;
+    };
+
     QSvgRectF m_rect;
     QtSvg::UnitTypes m_filterUnits;
     QtSvg::UnitTypes m_primitiveUnits;
     bool m_supported;
+    bool m_usesSourceAlpha = false;
+    QList<Step> m_steps;
+    std::vector<std::unique_ptr<QSvgFeFilterPrimitive>> m_fusedPrimitives;
+    int m_slotCount = FirstResultSlot;
+    int m_resultSlot = -1;
 };
 
 
@@ -217,10 +278,34 @@ public:
     }
 
 private:
+    QImage renderMask(QPainter *p, QSvgExtraStates &states, const QRectF &localRect,
+                      const QRect &imageBound) const;
+
     QSvgRectF m_rect;
     QtSvg::UnitTypes m_contentUnits;
 };
 
+class Q_SVG_EXPORT QSvgClipPath : public QSvgStructureNode
+{
+public:
+    QSvgClipPath(QSvgNode *parent, QtSvg::UnitTypes contentUnits);
+    void drawCommand(QPainter *, QSvgExtraStates &) override {};
+    bool shouldDrawNode(QPainter *, QSvgExtraStates &) const override;
+    Type type() const override;
+    QPainterPath clipPath(QPainter *p, const QSvgNode *target) const;
+
+    QtSvg::UnitTypes contentUnits() const
+    {
+        return m_contentUnits;
+    }
+
+private:
+    static QPainterPath childClipPath(QPainter *p, QSvgExtraStates &states, QSvgNode *node);
+    static QPainterPath rasterClipPath(QPainter *p, QSvgExtraStates &states, QSvgNode *node);
+
+    QtSvg::UnitTypes m_contentUnits;
+};
+
 class Q_SVG_EXPORT QSvgPattern : public QSvgStructureNode
 {
 public:
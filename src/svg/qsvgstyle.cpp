@@ -678,14 +678,11 @@ QSvgAnimatedStyle::~QSvgAnimatedStyle()
 
 void QSvgAnimatedStyle::apply(QPainter *p, const QSvgNode *node, QSvgExtraStates &states)
 {
-    QSharedPointer<QSvgAbstractAnimator> animator = node->document()->animator();
-    QList<QSvgAbstractAnimation *> nodeAnims = animator->animationsForNode(node);
-
     savePaintingState(p, node, states);
-    if (nodeAnims.isEmpty())
+    if (m_animations.isEmpty())
         return;
 
-    for (auto anim : nodeAnims) {
+    for (auto anim : std::as_const(m_animations)) {
         if (!anim->isActive())
             continue;
 
@@ -705,10 +702,18 @@ void QSvgAnimatedStyle::revert(QPainter *p, QSvgExtraStates &states)
     p->setPen(m_pen);
 }
 
+void QSvgAnimatedStyle::appendAnimation(QSvgAbstractAnimation *anim)
+{
+    if (anim->animationType() == QSvgAbstractAnimation::SMIL)
+        m_animations.insert(m_smilCount++, anim);
+    else
+        m_animations.append(anim);
+}
+
 void QSvgAnimatedStyle::savePaintingState(const QPainter *p, const QSvgNode *node, QSvgExtraStates &states)
 {
     Q_UNUSED(states);
-    QSvgStaticStyle style = node->style();
+    const QSvgStaticStyle &style = node->style();
     m_worldTransform = m_transformToNode = p->worldTransform();
     if (style.transform)
         m_transformToNode = style.transform->qtransform().inverted() * m_transformToNode;
@@ -720,25 +725,33 @@ void QSvgAnimatedStyle::savePaintingState(const QPainter *p, const QSvgNode *nod
 void QSvgAnimatedStyle::applyPropertyAnimation(QPainter *p, QSvgAbstractAnimatedProperty *property,
                                                bool replace)
 {
-    if (property->propertyName() == QStringLiteral("fill")) {
+    switch (property->propertyId()) {
+    case QSvgAbstractAnimatedProperty::PropertyId::Fill: {
         QBrush brush = p->brush();
         QColor brushColor = brush.color();
-        QColor animatedColor = property->interpolatedValue().value<QColor>();
+        QColor animatedColor = property->interpolatedColor();
         brush.setColor(replace == true ? animatedColor : sumColor(brushColor, animatedColor));
         p->setBrush(brush);
-    } else if (property->propertyName() == QStringLiteral("stroke")) {
+        break;
+    }
+    case QSvgAbstractAnimatedProperty::PropertyId::Stroke: {
         QPen pen = p->pen();
         QBrush penBrush = pen.brush();
         QColor penColor = penBrush.color();
-        QColor animatedColor = property->interpolatedValue().value<QColor>();
+        QColor animatedColor = property->interpolatedColor();
         penBrush.setColor(replace == true ? animatedColor : sumColor(penColor, animatedColor));
         pen.setBrush(penBrush);
         p->setPen(pen);
-    } else if (property->propertyName() == QStringLiteral("transform")) {
+        break;
+    }
+    case QSvgAbstractAnimatedProperty::PropertyId::Transform:
         if (replace)
-            p->setWorldTransform(property->interpolatedValue().value<QTransform>() * m_transformToNode);
+            p->setWorldTransform(property->interpolatedTransform() * m_transformToNode);
         else
-            p->setWorldTransform(property->interpolatedValue().value<QTransform>() * p->worldTransform());
+            p->setWorldTransform(property->interpolatedTransform() * p->worldTransform());
+        break;
+    case QSvgAbstractAnimatedProperty::PropertyId::Unknown:
+        break;
     }
 }
 
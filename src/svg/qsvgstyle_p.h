@@ -671,6 +671,7 @@ public:
 };
 
 class QSvgAbstractAnimatedProperty;
+class QSvgAbstractAnimation;
 class Q_SVG_EXPORT QSvgAnimatedStyle
 {
 public:
@@ -680,11 +681,19 @@ public:
     void apply(QPainter *p, const QSvgNode *node, QSvgExtraStates &states);
     void revert(QPainter *p, QSvgExtraStates &states);
 
+    void appendAnimation(QSvgAbstractAnimation *anim);
+    const QList<QSvgAbstractAnimation *> &animations() const { return m_animations; }
+    bool hasAnimations() const { return !m_animations.isEmpty(); }
+
 private:
     void savePaintingState(const QPainter *p, const QSvgNode *node, QSvgExtraStates &states);
     void applyPropertyAnimation(QPainter *p, QSvgAbstractAnimatedProperty *property, bool replace);
 
 private:
+    // SMIL animations first, followed by CSS ones; bound once at load time
+    QList<QSvgAbstractAnimation *> m_animations;
+    qsizetype m_smilCount = 0;
+
     QBrush m_brush;
     QPen m_pen;
     QTransform m_worldTransform;
@@ -30,6 +30,7 @@ QSvgTinyDocument::QSvgTinyDocument(QtSvg::Options options, QtSvg::AnimatorType t
     , m_animated(false)
     , m_fps(30)
     , m_options(options)
+    , m_useCache(options.testFlag(QtSvg::CacheUseElements))
 {
     bool animationEnabled = !m_options.testFlag(QtSvg::DisableAnimations);
     switch (type) {
@@ -268,6 +269,8 @@ void QSvgTinyDocument::draw(QPainter *p, const QRectF &bounds)
     }
     revertStyle(p, m_states);
     p->restore();
+    m_scratchBuffers.endFrame();
+    m_useCache.endFrame();
 }
 
 
@@ -324,6 +327,8 @@ void QSvgTinyDocument::draw(QPainter *p, const QString &id,
     //p->fillRect(bounds.adjusted(-5, -5, 5, 5), QColor(0, 0, 255, 100));
 
     p->restore();
+    m_scratchBuffers.endFrame();
+    m_useCache.endFrame();
 }
 
 QSvgNode::Type QSvgTinyDocument::type() const
@@ -26,6 +26,7 @@
 #include "QtCore/qsharedpointer.h"
 #include "qsvgstyle_p.h"
 #include "qsvgfont_p.h"
+#include "qsvgcaches_p.h"
 #include "private/qsvganimator_p.h"
 
 QT_BEGIN_NAMESPACE
@@ -95,6 +96,14 @@ public:
 
     QSharedPointer<QSvgAbstractAnimator> animator() const;
 
+    QSvgFilterCache *filterCache() const { return &m_filterCache; }
+    QSvgMaskCache *maskCache() const { return &m_maskCache; }
+    QSvgMarkerCache *markerCache() const { return &m_markerCache; }
+    QSvgPatternCache *patternCache() const { return &m_patternCache; }
+    QSvgStrokeCache *strokeCache() const { return &m_strokeCache; }
+    QSvgUseCache *useCache() const { return &m_useCache; }
+    QSvgScratchBufferPool *scratchBuffers() const { return &m_scratchBuffers; }
+
 private:
     void mapSourceToTarget(QPainter *p, const QRectF &targetRect, const QRectF &sourceRect = QRectF());
 private:
@@ -117,6 +126,13 @@ private:
 
     const QtSvg::Options m_options;
     QSharedPointer<QSvgAbstractAnimator> m_animator;
+    mutable QSvgFilterCache m_filterCache;
+    mutable QSvgMaskCache m_maskCache;
+    mutable QSvgMarkerCache m_markerCache;
+    mutable QSvgPatternCache m_patternCache;
+    mutable QSvgStrokeCache m_strokeCache;
+    mutable QSvgUseCache m_useCache;
+    mutable QSvgScratchBufferPool m_scratchBuffers;
 };
 
 Q_SVG_EXPORT QDebug operator<<(QDebug debug, const QSvgTinyDocument &doc);
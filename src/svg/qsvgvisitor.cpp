@@ -109,6 +109,7 @@ void QSvgVisitor::traverse(const QSvgNode *node)
         break;
 
         // Enum values that don't have any QSvgNode classes yet:
+    case QSvgNode::ClipPath:
     case QSvgNode::Symbol:
     case QSvgNode::Marker:
     case QSvgNode::Pattern:
@@ -121,6 +122,11 @@ void QSvgVisitor::traverse(const QSvgNode *node)
     case QSvgNode::FeComposite:
     case QSvgNode::FeFlood:
     case QSvgNode::FeBlend:
+    case QSvgNode::FeConvolvematrix:
+    case QSvgNode::FeMorphology:
+    case QSvgNode::FeTurbulence:
+    case QSvgNode::FeComponenttransfer:
+    case QSvgNode::FeDropshadow:
     case QSvgNode::FeUnsupported:
         qDebug() << "Unhandled type in switch" << node->type();
         break;
@@ -23,7 +23,10 @@ enum Option : quint32 {
     // reserved for potentially other animations: 0x40
     // reserved for potentially other animations: 0x80
     DisableAnimations = 0xf0,
-    // next value for non-animations: 0x0100
+    BakeAnimations = 0x0100,
+    ApproximateLargeBlurs = 0x0200,
+    CacheUseElements = 0x0400,
+    // next value for non-animations: 0x0800
 };
 Q_DECLARE_FLAGS(Options, Option)
 Q_DECLARE_OPERATORS_FOR_FLAGS(Options)
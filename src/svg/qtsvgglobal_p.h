@@ -28,6 +28,11 @@ enum class UnitTypes : quint32 {
     userSpaceOnUse
 };
 
+enum class ColorSpace : quint32 {
+    sRGB,
+    linearRGB
+};
+
 enum class AnimatorType : quint32 {
     Controlled,
     Automatic,
@@ -12,6 +12,9 @@
 #include <QPen>
 #include <QPicture>
 #include <QXmlStreamReader>
+#include <QtSvg/private/qsvgcaches_p.h>
+#include <QtSvg/private/qsvgframesequence_p.h>
+#include <QtSvg/private/qsvgtinydocument_p.h>
 
 #ifndef SRCDIR
 #define SRCDIR
@@ -74,7 +77,15 @@ private slots:
     void tSpanLineBreak();
     void animated();
     void notAnimated();
+    void animatedNodeBinding();
+    void animatedTransform();
+    void frameSequenceExport();
+    void bakedAnimations();
     void testMaskElement();
+    void testMaskCache();
+    void testClipPath_data();
+    void testClipPath();
+    void testClipPathText();
     void testSymbol();
     void testMarker();
     void testPatternElement();
@@ -82,10 +93,41 @@ private slots:
     void testFeFlood();
     void testFeOffset();
     void testFeColorMatrix();
+    void testFeColorMatrixKernels_data();
+    void testFeColorMatrixKernels();
     void testFeMerge();
+    void testFilterGraph();
+    void testFilterCache();
+    void testScratchBufferPool();
+    void testCacheBudget();
+    void testGroupOpacityBounds();
+    void testGroupOpacityFold_data();
+    void testGroupOpacityFold();
+    void testGroupOpacityFoldAnimated();
+    void testStrokeCache();
+    void testPatternCache();
+    void testMarkerInstancing();
+    void testMarkerVertices();
+    void testUseCache();
+    void testFilterTiles();
     void testFeComposite();
+    void testFeCompositeArithmetic();
     void testFeGaussian();
+    void testFeGaussianApproximate();
     void testFeBlend();
+    void testFeBlendModes_data();
+    void testFeBlendModes();
+    void testFeConvolveMatrix_data();
+    void testFeConvolveMatrix();
+    void testFeMorphology_data();
+    void testFeMorphology();
+    void testFeTurbulence();
+    void testFeComponentTransfer_data();
+    void testFeComponentTransfer();
+    void testColorInterpolationFilters_data();
+    void testColorInterpolationFilters();
+    void testFeDropShadow_data();
+    void testFeDropShadow();
     void testUseCycles();
 
     void testOption_data();
@@ -1870,8 +1912,6 @@ void tst_QSvgRenderer::testMaskElement()
 
     QImage image(240, 240, QImage::Format_ARGB32_Premultiplied);
     image.fill(Qt::transparent);
-    QImage refImage(240, 240, QImage::Format_ARGB32_Premultiplied);
-    refImage.fill(Qt::transparent);
     QImage refMask(240, 240, QImage::QImage::Format_RGBA8888);
 
     QPainter p;
@@ -1890,22 +1930,188 @@ void tst_QSvgRenderer::testMaskElement()
     p.drawEllipse(QPointF(120, 120), 120, 120);
     p.end();
 
-    for (int i=0; i < refMask.height(); i++) {
-        QRgb *line = reinterpret_cast<QRgb *>(refMask.scanLine(i));
-        for (int j=0; j < refMask.width(); j++) {
+    // Where the mask is white, the red rect is kept exactly
+    QCOMPARE(image.pixel(0, 0), QColor(Qt::red).rgba());
+    QCOMPARE(image.pixel(239, 239), QColor(Qt::red).rgba());
+
+    // Elsewhere it keeps the luminance of the mask as its alpha. The mask is
+    // rounded to the nearest level, while a DestinationOut composition of the
+    // inverted mask truncates it, so the two may differ by one level.
+    for (int i = 0; i < refMask.height(); i++) {
+        const QRgb *maskLine = reinterpret_cast<const QRgb *>(refMask.constScanLine(i));
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(i));
+        for (int j = 0; j < refMask.width(); j++) {
             const qreal rC = 0.2125, gC = 0.7154, bC = 0.0721; //luminanceToAlpha following SVG 1.1
-            int alpha = 255 - (qRed(line[j]) * rC + qGreen(line[j]) * gC + qBlue(line[j]) * bC) * qAlpha(line[j])/255.;
-            line[j] = qRgba(0, 0, 0, alpha);
+            const int alpha = qRound((qRed(maskLine[j]) * rC + qGreen(maskLine[j]) * gC
+                                      + qBlue(maskLine[j]) * bC) * qAlpha(maskLine[j]) / 255.);
+            QVERIFY(qAbs(qAlpha(line[j]) - alpha) <= 1);
+            QCOMPARE(qRed(line[j]), qAlpha(line[j]));
+            QCOMPARE(qGreen(line[j]), 0);
+            QCOMPARE(qBlue(line[j]), 0);
         }
     }
+}
 
-    p.begin(&refImage);
-    p.fillRect(0, 0, 240, 240, QColorConstants::Svg::red);
-    p.setCompositionMode(QPainter::CompositionMode_DestinationOut);
-    p.drawImage(QRect(0, 0, 240, 240), refMask);
+// Renders the first frames of an animated document at two frames per second
+static QList<QImage> renderAnimationFrames(const QByteArray &svg, int frames)
+{
+    QSvgRenderer renderer(svg);
+    renderer.setFramesPerSecond(2);
+
+    QList<QImage> images;
+    for (int frame = 0; frame < frames; ++frame) {
+        renderer.setCurrentFrame(frame);
+        QImage image(renderer.defaultSize(), QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+        p.end();
+        images.append(image);
+    }
+    return images;
+}
+
+void tst_QSvgRenderer::testMaskCache()
+{
+    // One mask shared by nodes of different bounds, rendered twice
+    QByteArray svgDoc(R"(<svg width="60" height="30">
+                      <mask id="m" maskContentUnits="objectBoundingBox">
+                      <rect width="0.5" height="1" fill="white"/>
+                      </mask>
+                      <rect width="20" height="20" fill="blue" mask="url(#m)"/>
+                      <rect x="30" width="30" height="30" fill="blue" mask="url(#m)"/>
+                      </svg>)");
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    for (int i = 0; i < 2; ++i) {
+        QImage image(60, 30, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::white);
+        QPainter p(&image);
+        renderer.render(&p);
+        p.end();
+
+        QCOMPARE(image.pixel(5, 10), QColor(Qt::blue).rgb());
+        QCOMPARE(image.pixel(15, 10), QColor(Qt::white).rgb());
+        QCOMPARE(image.pixel(40, 25), QColor(Qt::blue).rgb());
+        QCOMPARE(image.pixel(50, 25), QColor(Qt::white).rgb());
+    }
+
+    // Animated mask content is rendered again on every frame
+    QByteArray animatedDoc(R"(<svg width="20" height="20">
+                           <mask id="m">
+                           <rect width="20" height="20" fill="white">
+                           <animateColor attributeName="fill" values="white;black" dur="1s"/>
+                           </rect>
+                           </mask>
+                           <rect width="20" height="20" fill="red" mask="url(#m)"/>
+                           </svg>)");
+
+    const QList<QImage> images = renderAnimationFrames(animatedDoc, 2);
+    QCOMPARE(images.size(), 2);
+    QCOMPARE(images.at(0).pixel(10, 10), QColor(Qt::red).rgba());
+    QVERIFY(images.at(1).pixel(10, 10) != images.at(0).pixel(10, 10));
+}
+
+void tst_QSvgRenderer::testClipPath_data()
+{
+    QTest::addColumn<QByteArray>("clip");
+    QTest::addColumn<QByteArray>("attributes");
+    QTest::addColumn<QPoint>("inside");
+    QTest::addColumn<QPoint>("outside");
+
+    QTest::newRow("userSpaceOnUse") << QByteArray("<circle cx=\"50\" cy=\"50\" r=\"20\"/>")
+                                    << QByteArray() << QPoint(50, 50) << QPoint(25, 25);
+    QTest::newRow("objectBoundingBox") << QByteArray("<rect width=\"0.5\" height=\"1\"/>")
+                                       << QByteArray("clipPathUnits=\"objectBoundingBox\"")
+                                       << QPoint(30, 50) << QPoint(70, 50);
+    QTest::newRow("union") << QByteArray("<rect width=\"30\" height=\"30\"/>"
+                                         "<rect x=\"60\" y=\"60\" width=\"30\" height=\"30\"/>")
+                           << QByteArray() << QPoint(75, 75) << QPoint(50, 50);
+    QTest::newRow("nonzero") << QByteArray("<path d=\"M10,10 h80 v80 h-80 z M30,30 h40 v40 h-40 z\"/>")
+                             << QByteArray() << QPoint(50, 50) << QPoint(5, 5);
+    QTest::newRow("evenodd") << QByteArray("<path clip-rule=\"evenodd\" "
+                                           "d=\"M10,10 h80 v80 h-80 z M30,30 h40 v40 h-40 z\"/>")
+                             << QByteArray() << QPoint(20, 20) << QPoint(50, 50);
+    QTest::newRow("inherited clip-rule") << QByteArray("<path d=\"M10,10 h80 v80 h-80 z M30,30 h40 v40 h-40 z\"/>")
+                                         << QByteArray("clip-rule=\"evenodd\"")
+                                         << QPoint(20, 20) << QPoint(50, 50);
+    QTest::newRow("child transform") << QByteArray("<rect width=\"20\" height=\"20\" transform=\"translate(60 60)\"/>")
+                                     << QByteArray() << QPoint(70, 70) << QPoint(10, 10);
+    QTest::newRow("clipPath transform") << QByteArray("<rect width=\"20\" height=\"20\"/>")
+                                        << QByteArray("transform=\"scale(2)\"")
+                                        << QPoint(35, 35) << QPoint(45, 45);
+    QTest::newRow("use") << QByteArray("<use href=\"#shape\" x=\"50\"/>")
+                         << QByteArray() << QPoint(60, 10) << QPoint(10, 10);
+    QTest::newRow("nested") << QByteArray("<rect width=\"50\" height=\"100\" clip-path=\"url(#inner)\"/>")
+                            << QByteArray() << QPoint(25, 25) << QPoint(25, 75);
+    QTest::newRow("clip-path on clipPath") << QByteArray("<rect width=\"50\" height=\"100\"/>")
+                                           << QByteArray("clip-path=\"url(#inner)\"")
+                                           << QPoint(25, 25) << QPoint(75, 25);
+    QTest::newRow("hidden child") << QByteArray("<rect width=\"50\" height=\"100\"/>"
+                                                "<rect x=\"50\" width=\"50\" height=\"100\" visibility=\"hidden\"/>")
+                                  << QByteArray() << QPoint(25, 50) << QPoint(75, 50);
+}
+
+void tst_QSvgRenderer::testClipPath()
+{
+    QFETCH(QByteArray, clip);
+    QFETCH(QByteArray, attributes);
+    QFETCH(QPoint, inside);
+    QFETCH(QPoint, outside);
+
+    const QByteArray svgDoc = "<svg width=\"100\" height=\"100\">"
+            "<defs><rect id=\"shape\" width=\"20\" height=\"20\"/>"
+            "<clipPath id=\"inner\"><rect width=\"100\" height=\"50\"/></clipPath></defs>"
+            "<clipPath id=\"c\" " + attributes + ">" + clip + "</clipPath>"
+            "<rect x=\"10\" y=\"10\" width=\"80\" height=\"80\" fill=\"blue\" clip-path=\"url(#c)\"/>"
+            "</svg>";
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter p(&image);
+    renderer.render(&p);
     p.end();
 
-    QCOMPARE(refImage, image);
+    QCOMPARE(image.pixel(inside), QColor(Qt::blue).rgb());
+    QCOMPARE(image.pixel(outside), QColor(Qt::white).rgb());
+}
+
+void tst_QSvgRenderer::testClipPathText()
+{
+    // Text has no path geometry and is rasterized into the clip region
+    QByteArray svgDoc(R"(<svg width="100" height="100">
+                      <clipPath id="c"><text x="0" y="90" font-size="90" fill="none">I</text></clipPath>
+                      <rect width="100" height="100" fill="blue" clip-path="url(#c)"/>
+                      <rect width="100" height="100" fill="red" clip-path="url(#empty)"/>
+                      <clipPath id="empty"/>
+                      </svg>)");
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter p(&image);
+    renderer.render(&p);
+    p.end();
+
+    // The rasterized clip region is aliased
+    int blue = 0;
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            const QRgb pixel = image.pixel(x, y);
+            QVERIFY(pixel == QColor(Qt::white).rgb() || pixel == QColor(Qt::blue).rgb());
+            if (pixel == QColor(Qt::blue).rgb())
+                ++blue;
+        }
+    }
+    QVERIFY(blue > 0);
+    QCOMPARE(image.pixel(99, 0), QColor(Qt::white).rgb());
 }
 
 void tst_QSvgRenderer::testSymbol()
@@ -2038,6 +2244,144 @@ void tst_QSvgRenderer::notAnimated()
     QVERIFY(!renderer.isAnimationEnabled());
 }
 
+void tst_QSvgRenderer::animatedNodeBinding()
+{
+    // Only the first rect is animated, its sibling must keep its static fill
+    QByteArray svgDoc(R"(<svg width="20" height="10">
+                      <rect x="0" y="0" width="10" height="10" fill="blue">
+                      <animateColor attributeName="fill" from="red" to="red" dur="1s" repeatCount="indefinite"/>
+                      </rect>
+                      <rect x="10" y="0" width="10" height="10" fill="blue"/>
+                      </svg>)");
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+    QVERIFY(renderer.animated());
+
+    QImage image(20, 10, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QImage refImage(20, 10, QImage::Format_ARGB32_Premultiplied);
+    refImage.fill(Qt::white);
+
+    QPainter p;
+    p.begin(&image);
+    renderer.render(&p);
+    p.end();
+
+    p.begin(&refImage);
+    p.fillRect(0, 0, 10, 10, Qt::red);
+    p.fillRect(10, 0, 10, 10, Qt::blue);
+    p.end();
+
+    QCOMPARE(refImage, image);
+}
+
+void tst_QSvgRenderer::animatedTransform()
+{
+    QByteArray svgDoc(R"(<svg width="20" height="10">
+                      <rect x="0" y="0" width="10" height="10" fill="blue">
+                      <animateTransform attributeName="transform" type="translate" from="10 0" to="10 0" dur="1s" repeatCount="indefinite"/>
+                      </rect>
+                      </svg>)");
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+    QVERIFY(renderer.animated());
+
+    QImage image(20, 10, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QImage refImage(20, 10, QImage::Format_ARGB32_Premultiplied);
+    refImage.fill(Qt::white);
+
+    QPainter p;
+    p.begin(&image);
+    renderer.render(&p);
+    p.end();
+
+    p.begin(&refImage);
+    p.fillRect(10, 0, 10, 10, Qt::blue);
+    p.end();
+
+    QCOMPARE(refImage, image);
+}
+
+void tst_QSvgRenderer::frameSequenceExport()
+{
+    QByteArray svgDoc(R"(<svg width="20" height="10">
+                      <rect x="0" y="0" width="10" height="10" fill="blue">
+                      <animateTransform attributeName="transform" type="translate" from="0 0" to="10 0" dur="1s"/>
+                      </rect>
+                      </svg>)");
+
+    QSvgFrameSequenceExporter exporter(svgDoc);
+    QVERIFY(exporter.isValid());
+    QCOMPARE(exporter.duration(), 1000);
+    QCOMPARE(exporter.size(), QSize(20, 10));
+
+    exporter.setFramesPerSecond(10);
+    exporter.setSize(QSize(40, 20));
+    QCOMPARE(exporter.frameCount(), 10);
+
+    QList<int> frames;
+    QList<QImage> images;
+    QVERIFY(exporter.exportFrames([&](int frame, const QImage &image) {
+        frames.append(frame);
+        images.append(image);
+    }));
+
+    QCOMPARE(frames, QList<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    for (const QImage &image : std::as_const(images))
+        QCOMPARE(image.size(), QSize(40, 20));
+
+    // The rect moves by 2px per frame in device space
+    QCOMPARE(images.at(0).pixel(0, 10), QColor(Qt::blue).rgba());
+    QCOMPARE(images.at(0).pixel(30, 10), 0u);
+    QCOMPARE(images.at(5).pixel(0, 10), 0u);
+    QCOMPARE(images.at(5).pixel(15, 10), QColor(Qt::blue).rgba());
+
+    // Exporting from the only thread of the pool renders on that thread
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    exporter.setThreadPool(&pool);
+    QList<int> pooledFrames;
+    bool pooledResult = false;
+    pool.start([&]() {
+        pooledResult = exporter.exportFrames([&](int frame, const QImage &) {
+            pooledFrames.append(frame);
+        });
+    });
+    QVERIFY(pool.waitForDone(10000));
+    QVERIFY(pooledResult);
+    QCOMPARE(pooledFrames, frames);
+}
+
+void tst_QSvgRenderer::bakedAnimations()
+{
+    QByteArray svgDoc(R"(<svg width="20" height="10">
+                      <rect x="0" y="0" width="10" height="10" fill="blue">
+                      <animateColor attributeName="fill" values="red;lime;blue" dur="1s"/>
+                      <animateTransform attributeName="transform" type="translate" from="0 0" to="10 0" dur="1s"/>
+                      </rect>
+                      </svg>)");
+
+    auto renderFrames = [&](QtSvg::Options options) {
+        QSvgFrameSequenceExporter exporter(svgDoc, options);
+        exporter.setFramesPerSecond(10);
+        QList<QImage> images;
+        exporter.exportFrames([&](int, const QImage &image) { images.append(image); });
+        return images;
+    };
+
+    const QList<QImage> exact = renderFrames(QtSvg::NoOption);
+    const QList<QImage> baked = renderFrames(QtSvg::BakeAnimations);
+    QCOMPARE(exact.size(), 10);
+    QCOMPARE(baked.size(), exact.size());
+
+    // Frames on the sampling grid match the interpolated ones
+    for (int i = 0; i < exact.size(); ++i)
+        QCOMPARE(baked.at(i), exact.at(i));
+}
+
 void tst_QSvgRenderer::testPatternElement()
 {
     QByteArray svgDoc(R"(<svg viewBox="0 0 200 200">
@@ -2195,6 +2539,73 @@ void tst_QSvgRenderer::testFeColorMatrix()
     QVERIFY(image.allGray());
 }
 
+void tst_QSvgRenderer::testFeColorMatrixKernels_data()
+{
+    QTest::addColumn<QByteArray>("type");
+    QTest::addColumn<QByteArray>("values");
+    QTest::addColumn<QList<qreal>>("matrix");
+
+    QTest::newRow("identity") << QByteArray("matrix")
+                              << QByteArray("1 0 0 0 0 0 1 0 0 0 0 0 1 0 0 0 0 0 1 0")
+                              << QList<qreal>{ 1, 0, 0, 0, 0, 0, 1, 0, 0, 0,
+                                               0, 0, 1, 0, 0, 0, 0, 0, 1, 0 };
+    QTest::newRow("gray") << QByteArray("matrix")
+                          << QByteArray("0.3 0.6 0.1 0 0 0.3 0.6 0.1 0 0 0.3 0.6 0.1 0 0 0 0 0 1 0")
+                          << QList<qreal>{ 0.3, 0.6, 0.1, 0, 0, 0.3, 0.6, 0.1, 0, 0,
+                                           0.3, 0.6, 0.1, 0, 0, 0, 0, 0, 1, 0 };
+    QTest::newRow("luminanceToAlpha") << QByteArray("luminanceToAlpha") << QByteArray()
+                                      << QList<qreal>{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                       0, 0, 0, 0, 0, 0.2125, 0.7154, 0.0721, 0, 0 };
+    QTest::newRow("general") << QByteArray("matrix")
+                             << QByteArray("0.5 0.2 0 0 0.1 0 1 0 0 0 0.3 0 0.6 0 0 0 0 0 0.8 0.1")
+                             << QList<qreal>{ 0.5, 0.2, 0, 0, 0.1, 0, 1, 0, 0, 0,
+                                              0.3, 0, 0.6, 0, 0, 0, 0, 0, 0.8, 0.1 };
+}
+
+void tst_QSvgRenderer::testFeColorMatrixKernels()
+{
+    QFETCH(QByteArray, type);
+    QFETCH(QByteArray, values);
+    QFETCH(QList<qreal>, matrix);
+
+    const QByteArray rect = R"(<rect width="10" height="10" fill="#c86432" fill-opacity="0.6")";
+    const QByteArray svgDoc = R"(<svg width="10" height="10">
+                              <filter id="f1" color-interpolation-filters="sRGB">
+                              <feColorMatrix type=")" + type + R"(" values=")" + values + R"("/>
+                              </filter>)" + rect + R"( filter="url(#f1)"/></svg>)";
+    const QByteArray plainDoc = R"(<svg width="10" height="10">)" + rect + R"(/></svg>)";
+
+    auto render = [](const QByteArray &data) {
+        QImage image(10, 10, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QSvgRenderer renderer(data);
+        QPainter p(&image);
+        renderer.render(&p);
+        return image.pixel(5, 5);
+    };
+
+    const QRgb source = render(plainDoc);
+    const QRgb filtered = render(svgDoc);
+
+    const QColor color = QColor::fromRgba(qUnpremultiply(source));
+    const qreal in[5] = { color.redF(), color.greenF(), color.blueF(), color.alphaF(), 1 };
+    qreal out[4];
+    for (int row = 0; row < 4; ++row) {
+        out[row] = 0;
+        for (int column = 0; column < 5; ++column)
+            out[row] += matrix.at(5 * row + column) * in[column];
+        out[row] = qBound(0., out[row], 1.);
+    }
+    const QRgb expected = qPremultiply(qRgba(qRound(out[0] * 255), qRound(out[1] * 255),
+                                             qRound(out[2] * 255), qRound(out[3] * 255)));
+
+    QVERIFY2(qAbs(qRed(filtered) - qRed(expected)) <= 2
+             && qAbs(qGreen(filtered) - qGreen(expected)) <= 2
+             && qAbs(qBlue(filtered) - qBlue(expected)) <= 2
+             && qAbs(qAlpha(filtered) - qAlpha(expected)) <= 2,
+             qPrintable(QString::number(filtered, 16) + u" != "_s + QString::number(expected, 16)));
+}
+
 void tst_QSvgRenderer::testFeMerge()
 {
     QByteArray svgDoc(R"(<svg width="50" height="50">
@@ -2229,6 +2640,748 @@ void tst_QSvgRenderer::testFeMerge()
     QCOMPARE(refImage, image);
 }
 
+void tst_QSvgRenderer::testFilterGraph()
+{
+    // Independent branches, named results and a result nobody reads
+    QByteArray svgDoc(R"(<svg width="50" height="50">
+                      <filter id="f1">
+                      <feFlood flood-color="red" result="unused"/>
+                      <feOffset in="SourceAlpha" dx="2" dy="2" result="shadow"/>
+                      <feFlood flood-color="lime" result="color"/>
+                      <feComposite in="color" in2="SourceGraphic" operator="in" result="tinted"/>
+                      <feMerge>
+                      <feMergeNode in="shadow"/>
+                      <feMergeNode in="tinted"/>
+                      </feMerge>
+                      </filter>
+                      <rect x="10" y="10" width="30" height="30" fill="blue" filter="url(#f1) "/>
+                      </svg>)");
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(50, 50, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QImage refImage(50, 50, QImage::Format_ARGB32_Premultiplied);
+    refImage.fill(Qt::white);
+
+    QPainter p;
+    p.begin(&image);
+    renderer.render(&p);
+    p.end();
+
+    p.begin(&refImage);
+    p.fillRect(12, 12, 30, 30, Qt::black);
+    p.fillRect(10, 10, 30, 30, QColor(0, 255, 0));
+    p.end();
+
+    QCOMPARE(refImage, image);
+
+    // The implicit input after a primitive with an empty subregion is
+    // transparent black, not the last non-empty result
+    QByteArray emptyDoc(R"(<svg width="50" height="50">
+                        <filter id="f2">
+                        <feFlood flood-color="red" width="0" height="0"/>
+                        <feOffset dx="5" dy="5"/>
+                        </filter>
+                        <rect x="10" y="10" width="30" height="30" fill="blue" filter="url(#f2)"/>
+                        </svg>)");
+
+    QSvgRenderer emptyRenderer(emptyDoc);
+    QVERIFY(emptyRenderer.isValid());
+    image.fill(Qt::white);
+    p.begin(&image);
+    emptyRenderer.render(&p);
+    p.end();
+
+    refImage.fill(Qt::white);
+    QCOMPARE(refImage, image);
+}
+
+
+void tst_QSvgRenderer::testFilterCache()
+{
+    // The same filtered node drawn at two positions, rendered twice
+    QByteArray svgDoc(R"(<svg width="50" height="50">
+                      <filter id="f1">
+                      <feOffset in="SourceAlpha" dx="2" dy="2"/>
+                      <feComposite in2="SourceGraphic" operator="over"/>
+                      </filter>
+                      <defs><rect id="r" width="10" height="10" fill="blue" filter="url(#f1)"/></defs>
+                      <use href="#r" x="5" y="5"/>
+                      <use href="#r" x="25" y="25"/>
+                      </svg>)");
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage refImage(50, 50, QImage::Format_ARGB32_Premultiplied);
+    refImage.fill(Qt::white);
+    QPainter p;
+    p.begin(&refImage);
+    for (int offset : {5, 25}) {
+        p.fillRect(offset, offset, 10, 10, Qt::blue);
+        p.fillRect(offset + 2, offset + 2, 10, 10, Qt::black);
+    }
+    p.end();
+
+    for (int i = 0; i < 2; ++i) {
+        QImage image(50, 50, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::white);
+        p.begin(&image);
+        renderer.render(&p);
+        p.end();
+        QCOMPARE(refImage, image);
+    }
+
+    // A different device transform is not served from the cache
+    QImage scaled(100, 100, QImage::Format_ARGB32_Premultiplied);
+    scaled.fill(Qt::white);
+    p.begin(&scaled);
+    renderer.render(&p);
+    p.end();
+    QCOMPARE(scaled.pixel(12, 12), QColor(Qt::blue).rgb());
+    QCOMPARE(scaled.pixel(31, 31), QColor(Qt::black).rgb());
+
+    // Animated subtrees are filtered again on every frame
+    QByteArray animatedDoc(R"(<svg width="20" height="20">
+                           <filter id="f1"><feOffset dx="0" dy="0"/></filter>
+                           <g filter="url(#f1)">
+                           <rect width="20" height="20" fill="red">
+                           <animateColor attributeName="fill" values="red;blue" dur="1s"/>
+                           </rect>
+                           </g>
+                           </svg>)");
+
+    const QList<QImage> images = renderAnimationFrames(animatedDoc, 2);
+    QCOMPARE(images.size(), 2);
+    QCOMPARE(images.at(0).pixel(10, 10), QColor(Qt::red).rgba());
+    QVERIFY(images.at(1).pixel(10, 10) != images.at(0).pixel(10, 10));
+}
+
+
+void tst_QSvgRenderer::testScratchBufferPool()
+{
+    QSvgScratchBufferPool pool;
+    pool.setMaxCost(1024);
+
+    QImage image;
+    QVERIFY(pool.allocate(QSize(32, 16), &image));
+    const uchar *bits = image.constBits();
+    pool.recycle(std::move(image));
+    QCOMPARE(pool.totalCost(), 2);
+
+    // A buffer of the same size is reused, one of another size is not
+    QImage other;
+    QVERIFY(pool.allocate(QSize(16, 32), &other));
+    QVERIFY(other.constBits() != bits);
+    QVERIFY(pool.allocate(QSize(32, 16), &image));
+    QCOMPARE(image.constBits(), bits);
+    QCOMPARE(image.size(), QSize(32, 16));
+    QCOMPARE(pool.totalCost(), 0);
+    QCOMPARE(pool.hits(), 1);
+    QCOMPARE(pool.misses(), 2);
+
+    // Buffers that are still shared are not taken
+    QImage shared = image;
+    pool.recycle(std::move(image));
+    QCOMPARE(pool.totalCost(), 0);
+    shared = QImage();
+
+    // Buffers that were not used during a whole frame are released
+    pool.recycle(std::move(image));
+    pool.recycle(std::move(other));
+    QCOMPARE(pool.totalCost(), 4);
+    pool.endFrame();
+    QVERIFY(pool.allocate(QSize(32, 16), &image));
+    QCOMPARE(image.constBits(), bits);
+    pool.recycle(std::move(image));
+    pool.endFrame();
+    QCOMPARE(pool.totalCost(), 2);
+    pool.endFrame();
+    QCOMPARE(pool.totalCost(), 0);
+
+    // Nothing is kept beyond the limit
+    pool.setMaxCost(1);
+    QVERIFY(pool.allocate(QSize(32, 16), &image));
+    pool.recycle(std::move(image));
+    QCOMPARE(pool.totalCost(), 0);
+
+    // Drawing single elements ends frames too
+    QByteArray svgDoc(R"(<svg width="20" height="20">
+                      <g id="layer" opacity="0.5">
+                      <rect width="15" height="20" fill="blue"/>
+                      <rect x="5" width="15" height="20" fill="blue"/>
+                      </g>
+                      <rect id="plain" width="20" height="20" fill="blue"/>
+                      </svg>)");
+    std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(svgDoc));
+    QVERIFY(doc);
+    QImage target(20, 20, QImage::Format_ARGB32_Premultiplied);
+    QPainter p(&target);
+    doc->draw(&p, u"layer"_s, QRectF(0, 0, 20, 20));
+    QVERIFY(doc->scratchBuffers()->totalCost() > 0);
+    doc->draw(&p, u"plain"_s, QRectF(0, 0, 20, 20));
+    doc->draw(&p, u"plain"_s, QRectF(0, 0, 20, 20));
+    QCOMPARE(doc->scratchBuffers()->totalCost(), 0);
+
+    // The buffers of the last frame are only released once the pool is idle
+    doc->draw(&p, u"layer"_s, QRectF(0, 0, 20, 20));
+    QVERIFY(doc->scratchBuffers()->releaseIdle(60000) > 0);
+    QVERIFY(doc->scratchBuffers()->totalCost() > 0);
+    QCOMPARE(doc->scratchBuffers()->releaseIdle(0), 0);
+    QCOMPARE(doc->scratchBuffers()->totalCost(), 0);
+}
+
+void tst_QSvgRenderer::testCacheBudget()
+{
+    const qsizetype budget = QSvgCacheBase::globalMaxCost();
+    auto restore = qScopeGuard([budget] { QSvgCacheBase::setGlobalMaxCost(budget); });
+
+    QSvgScratchBufferPool first;
+    QSvgScratchBufferPool second;
+    first.setMaxCost(1024);
+    second.setMaxCost(1024);
+    const qsizetype used = QSvgCacheBase::globalTotalCost();
+    QSvgCacheBase::setGlobalMaxCost(used + 3);
+
+    // The caches share the budget, each within its own limit
+    QImage image;
+    QVERIFY(first.allocate(QSize(32, 16), &image));
+    first.recycle(std::move(image));
+    QCOMPARE(first.totalCost(), 2);
+    QCOMPARE(QSvgCacheBase::globalTotalCost(), used + 2);
+    QVERIFY(second.allocate(QSize(32, 16), &image));
+    second.recycle(std::move(image));
+    QCOMPARE(second.totalCost(), 0);
+
+    first.clear();
+    QCOMPARE(QSvgCacheBase::globalTotalCost(), used);
+    QVERIFY(second.allocate(QSize(32, 16), &image));
+    second.recycle(std::move(image));
+    QCOMPARE(second.totalCost(), 2);
+
+    // A budget of 0 disables all caches
+    QSvgCacheBase::setGlobalMaxCost(0);
+    QVERIFY(!first.isEnabled());
+    QVERIFY(!second.isEnabled());
+}
+
+void tst_QSvgRenderer::testGroupOpacityBounds()
+{
+    // An opacity group with an antialiased stroke, partly outside the device
+    QByteArray svgDoc(R"(<svg width="100" height="100">
+                      <g opacity="0.5">
+                      <rect x="-20.5" y="10.5" width="60" height="60" fill="blue" stroke="blue" stroke-width="9"/>
+                      <rect x="30.5" y="30.5" width="60" height="60" fill="blue" stroke="blue" stroke-width="9"/>
+                      </g>
+                      </svg>)");
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter p(&image);
+    renderer.render(&p);
+    p.end();
+
+    QImage refImage(100, 100, QImage::Format_ARGB32_Premultiplied);
+    refImage.fill(Qt::white);
+    QImage layer(100, 100, QImage::Format_ARGB32_Premultiplied);
+    layer.fill(Qt::transparent);
+    p.begin(&layer);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(QPen(Qt::blue, 9, Qt::SolidLine, Qt::FlatCap, Qt::SvgMiterJoin));
+    p.setBrush(Qt::blue);
+    p.drawRect(QRectF(-20.5, 10.5, 60, 60));
+    p.drawRect(QRectF(30.5, 30.5, 60, 60));
+    p.end();
+    p.begin(&refImage);
+    p.setOpacity(0.5);
+    p.drawImage(0, 0, layer);
+    p.end();
+
+    // The antialiased edges of the stroke are within the layer
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            const QRgb pixel = image.pixel(x, y);
+            const QRgb refPixel = refImage.pixel(x, y);
+            QVERIFY2(qAbs(qRed(pixel) - qRed(refPixel)) <= 1 && qAbs(qBlue(pixel) - qBlue(refPixel)) <= 1,
+                     qPrintable(u"pixel %1,%2"_s.arg(x).arg(y)));
+        }
+    }
+}
+
+void tst_QSvgRenderer::testGroupOpacityFold_data()
+{
+    QTest::addColumn<QByteArray>("content");
+    QTest::addColumn<bool>("layer");
+
+    QTest::newRow("disjoint fills") << R"(<rect width="10" height="20" fill="blue"/>
+                                       <rect x="10" width="10" height="20" fill="blue"/>)"_ba << false;
+    QTest::newRow("disjoint strokes") << R"(<line x1="5" y1="0" x2="5" y2="20" stroke="blue" stroke-width="10"/>
+                                         <polyline points="15,0 15,20" fill="red" stroke="blue" stroke-width="10"/>)"_ba << false;
+    QTest::newRow("nested groups") << R"(<g><rect width="10" height="20" fill="blue"/></g>
+                                      <g><rect x="10" width="10" height="10" fill="blue"/>
+                                      <rect x="10" y="10" width="10" height="10" fill="blue"/></g>)"_ba << false;
+    QTest::newRow("hidden child") << R"(<rect width="20" height="20" fill="blue"/>
+                                     <rect width="20" height="20" fill="red" display="none"/>)"_ba << false;
+    QTest::newRow("overlapping fills") << R"(<rect width="15" height="20" fill="blue"/>
+                                          <rect x="5" width="15" height="20" fill="blue"/>)"_ba << true;
+    QTest::newRow("shared pixel") << R"(<rect width="10.5" height="20" fill="blue"/>
+                                     <rect x="10.5" width="9.5" height="20" fill="blue"/>)"_ba << true;
+    QTest::newRow("fill and stroke") << R"(<rect x="5" y="5" width="10" height="10" fill="blue" stroke="blue" stroke-width="10"/>
+                                        <rect x="30" width="10" height="10" fill="blue"/>)"_ba << true;
+    QTest::newRow("text") << R"(<rect width="20" height="20" fill="blue"/>
+                             <text x="30" y="15" fill="blue">AV</text>)"_ba << true;
+
+    // Groups with more than 64 children are not analyzed
+    QByteArray columns;
+    for (int x = 0; x < 65; ++x)
+        columns += QByteArray("<rect x=\"") + QByteArray::number(x) + R"(" width="1" height="20" fill="blue"/>)";
+    QTest::newRow("many children") << columns << true;
+}
+
+void tst_QSvgRenderer::testGroupOpacityFold()
+{
+    QFETCH(QByteArray, content);
+    QFETCH(bool, layer);
+
+    const QByteArray svgDoc = R"(<svg width="60" height="20"><g opacity="0.5">)"_ba + content
+            + R"(</g></svg>)"_ba;
+    std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(svgDoc));
+    QVERIFY(doc);
+
+    QImage image(60, 20, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter p(&image);
+    doc->draw(&p, QRectF(0, 0, 60, 20));
+    p.end();
+
+    // A layer that was used is kept for the next frame
+    QCOMPARE(doc->scratchBuffers()->totalCost() > 0, layer);
+
+    // Either way, the group is composited as a whole
+    const QRgb pixel = image.pixel(5, 15);
+    QVERIFY(qAbs(qRed(pixel) - 127) <= 1);
+    QVERIFY(qAbs(qGreen(pixel) - 127) <= 1);
+    QCOMPARE(qBlue(pixel), 255);
+}
+
+void tst_QSvgRenderer::testGroupOpacityFoldAnimated()
+{
+    // An animated child that comes to overlap its sibling, next to a static group
+    QByteArray svgDoc(R"(<svg width="40" height="20">
+                      <g opacity="0.5">
+                      <rect width="10" height="20" fill="blue"/>
+                      <rect x="10" width="10" height="20" fill="blue">
+                      <animateTransform attributeName="transform" type="translate" from="0 0" to="-5 0" dur="1s"/>
+                      </rect>
+                      </g>
+                      <g opacity="0.5">
+                      <rect x="20" width="10" height="20" fill="blue"/>
+                      <rect x="30" width="10" height="20" fill="blue"/>
+                      </g>
+                      </svg>)");
+
+    const QList<QImage> images = renderAnimationFrames(svgDoc, 2);
+    QCOMPARE(images.size(), 2);
+    for (const QImage &image : images) {
+        // Both groups are composited as a whole in every frame
+        for (int x : { 8, 25, 35 }) {
+            const QRgb pixel = image.pixel(x, 10);
+            QVERIFY2(qAbs(qAlpha(pixel) - 127) <= 1, qPrintable(QString::number(x)));
+            QVERIFY2(qAbs(qBlue(pixel) - 127) <= 1, qPrintable(QString::number(x)));
+        }
+    }
+}
+
+void tst_QSvgRenderer::testStrokeCache()
+{
+    QByteArray svgDoc(R"(<svg width="100" height="100">
+                      <g fill="none" stroke="blue" stroke-width="6" stroke-dasharray="8 4">
+                      <path id="p" d="M 10 10 C 40 0 60 40 90 10" stroke-linecap="round"/>
+                      <rect id="r" x="10" y="30" width="30" height="20" rx="4" stroke-dashoffset="3"/>
+                      <circle cx="70" cy="40" r="15" stroke="red" stroke-width="3" stroke-dasharray="none"/>
+                      <polyline id="l" points="10,60 40,90 70,60" stroke-linejoin="miter"/>
+                      <polygon points="60,70 90,70 90,95" fill="green" stroke-width="0.5"/>
+                      </g>
+                      </svg>)");
+
+    auto render = [](QSvgTinyDocument *doc, qreal scale) {
+        QImage image(QSize(100, 100) * scale, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::white);
+        QPainter p(&image);
+        doc->draw(&p, QRectF(QPointF(0, 0), image.size()));
+        return image;
+    };
+
+    std::unique_ptr<QSvgTinyDocument> reference(QSvgTinyDocument::load(svgDoc));
+    std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(svgDoc));
+    QVERIFY(reference);
+    QVERIFY(doc);
+    reference->strokeCache()->setMaxCost(0);
+
+    for (qreal scale : { 1.0, 2.0, 1.0 }) {
+        const QImage refImage = render(reference.get(), scale);
+        const QImage image = render(doc.get(), scale);
+        QCOMPARE(reference->strokeCache()->totalCost(), 0);
+        QVERIFY(doc->strokeCache()->totalCost() > 0);
+
+        // Filling the cached outline matches stroking the shape
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                const QRgb pixel = image.pixel(x, y);
+                const QRgb refPixel = refImage.pixel(x, y);
+                QVERIFY2(qAbs(qRed(pixel) - qRed(refPixel)) <= 8
+                         && qAbs(qGreen(pixel) - qGreen(refPixel)) <= 8
+                         && qAbs(qBlue(pixel) - qBlue(refPixel)) <= 8,
+                         qPrintable(u"pixel %1,%2 at scale %3"_s.arg(x).arg(y).arg(scale)));
+            }
+        }
+    }
+
+    // The decorated bounds of a node come from its cached outline
+    for (const QString &id : { u"p"_s, u"r"_s, u"l"_s }) {
+        QSvgNode *node = doc->namedNode(id);
+        QVERIFY(node);
+        QImage dummy(1, 1, QImage::Format_ARGB32_Premultiplied);
+        QPainter p(&dummy);
+        p.scale(2, 2);
+        QSvgExtraStates states;
+        node->parent()->applyStyleRecursive(&p, states);
+        const qsizetype cost = doc->strokeCache()->totalCost();
+        const QRectF bounds = node->decoratedBounds(&p, states);
+        QCOMPARE(doc->strokeCache()->totalCost(), cost);
+        QSvgNode *refNode = reference->namedNode(id);
+        const QRectF refBounds = refNode->decoratedBounds(&p, states);
+        QVERIFY(!bounds.isEmpty());
+        QVERIFY2(refBounds.contains(bounds), qPrintable(id));
+        node->parent()->revertStyleRecursive(&p, states);
+    }
+}
+
+void tst_QSvgRenderer::testPatternCache()
+{
+    // One hatch shared by shapes at one scale, and a bounding box pattern
+    QByteArray svgDoc(R"(<svg width="100" height="100">
+                      <pattern id="hatch" patternUnits="userSpaceOnUse" width="10" height="10">
+                      <rect width="10" height="10" fill="white"/>
+                      <path d="M 0 10 L 10 0" stroke="blue" stroke-width="2"/>
+                      </pattern>
+                      <pattern id="box" width="0.5" height="0.5" patternContentUnits="objectBoundingBox">
+                      <rect width="0.25" height="0.25" fill="red"/>
+                      </pattern>
+                      <rect width="40" height="40" fill="url(#hatch)"/>
+                      <rect x="50" width="40" height="40" fill="url(#hatch)"/>
+                      <circle cx="20" cy="70" r="18" fill="url(#hatch)"/>
+                      <rect x="50" y="50" width="40" height="40" fill="url(#box)"/>
+                      </svg>)");
+
+    auto render = [](QSvgTinyDocument *doc) {
+        QImage image(200, 200, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        doc->draw(&p, QRectF(0, 0, 200, 200));
+        return image;
+    };
+
+    std::unique_ptr<QSvgTinyDocument> reference(QSvgTinyDocument::load(svgDoc));
+    std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(svgDoc));
+    QVERIFY(reference);
+    QVERIFY(doc);
+    reference->patternCache()->setMaxCost(0);
+
+    const QImage refImage = render(reference.get());
+    QCOMPARE(reference->patternCache()->totalCost(), 0);
+
+    // The three hatched shapes share one 20x20 tile, 2 KB, the box has a 40x40 one
+    QCOMPARE(render(doc.get()), refImage);
+    const qsizetype cost = doc->patternCache()->totalCost();
+    QCOMPARE(cost, 2 + 7);
+    QCOMPARE(render(doc.get()), refImage);
+    QCOMPARE(doc->patternCache()->totalCost(), cost);
+
+    // Animated pattern content is rendered again on every frame
+    QByteArray animatedDoc(R"(<svg width="20" height="20">
+                           <pattern id="p" patternUnits="userSpaceOnUse" width="10" height="10">
+                           <rect width="10" height="10" fill="white">
+                           <animateColor attributeName="fill" values="white;black" dur="1s"/>
+                           </rect>
+                           </pattern>
+                           <rect width="20" height="20" fill="url(#p)"/>
+                           </svg>)");
+
+    const QList<QImage> images = renderAnimationFrames(animatedDoc, 2);
+    QCOMPARE(images.size(), 2);
+    QCOMPARE(images.at(0).pixel(5, 5), QColor(Qt::white).rgba());
+    QVERIFY(images.at(1).pixel(5, 5) != images.at(0).pixel(5, 5));
+}
+
+void tst_QSvgRenderer::testMarkerInstancing()
+{
+    // Dots at whole pixel vertices, and arrows oriented along a zigzag
+    QByteArray svgDoc(R"(<svg width="100" height="100">
+                      <marker id="dot" markerWidth="6" markerHeight="6" refX="3" refY="3" markerUnits="userSpaceOnUse">
+                      <circle cx="3" cy="3" r="2" fill="red" stroke="blue" stroke-width="1"/>
+                      </marker>
+                      <marker id="arrow" markerWidth="4" markerHeight="4" refX="0" refY="2" orient="auto">
+                      <path d="M 0 0 L 4 2 L 0 4 z" fill="green"/>
+                      </marker>
+                      <polyline points="10,10 30,10 50,10 70,10 90,10 90,30 70,30 50,30 30,30 10,30"
+                      fill="none" stroke="black" marker-mid="url(#dot)"/>
+                      <polyline points="10,50 25,70 40,50 55,70 70,50 85,70"
+                      fill="none" stroke="black" stroke-width="2" marker-mid="url(#arrow)" marker-end="url(#arrow)"/>
+                      </svg>)");
+
+    auto render = [](QSvgTinyDocument *doc) {
+        QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        doc->draw(&p, QRectF(0, 0, 100, 100));
+        return image;
+    };
+
+    std::unique_ptr<QSvgTinyDocument> reference(QSvgTinyDocument::load(svgDoc));
+    std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(svgDoc));
+    QVERIFY(reference);
+    QVERIFY(doc);
+    reference->markerCache()->setMaxCost(0);
+
+    const QImage refImage = render(reference.get());
+    QCOMPARE(reference->markerCache()->totalCost(), 0);
+
+    const QImage image = render(doc.get());
+    const qsizetype cost = doc->markerCache()->totalCost();
+    QVERIFY(cost > 0);
+    QCOMPARE(render(doc.get()), image);
+    QCOMPARE(doc->markerCache()->totalCost(), cost);
+
+    // The dots are stamped at their exact positions
+    for (int y = 0; y < 40; ++y) {
+        for (int x = 0; x < 100; ++x) {
+            const QRgb pixel = image.pixel(x, y);
+            const QRgb refPixel = refImage.pixel(x, y);
+            QVERIFY2(qAbs(qRed(pixel) - qRed(refPixel)) <= 2
+                     && qAbs(qGreen(pixel) - qGreen(refPixel)) <= 2
+                     && qAbs(qBlue(pixel) - qBlue(refPixel)) <= 2
+                     && qAbs(qAlpha(pixel) - qAlpha(refPixel)) <= 2,
+                     qPrintable(QString::asprintf("(%d, %d)", x, y)));
+        }
+    }
+
+    // The arrows are snapped to a quarter degree and a quarter pixel
+    qint64 green = 0;
+    qint64 refGreen = 0;
+    for (int y = 40; y < 80; ++y) {
+        for (int x = 0; x < 100; ++x) {
+            green += qGreen(image.pixel(x, y));
+            refGreen += qGreen(refImage.pixel(x, y));
+        }
+    }
+    QVERIFY(refGreen > 0);
+    QVERIFY(qAbs(green - refGreen) * 50 < refGreen);
+
+    // Translucent markers paint each of their shapes with the opacity
+    QByteArray translucentDoc(R"(<svg width="100" height="100">
+                              <marker id="dot" markerWidth="6" markerHeight="6" refX="3" refY="3" markerUnits="userSpaceOnUse">
+                              <circle cx="3" cy="3" r="2" fill="red" stroke="blue" stroke-width="1"/>
+                              </marker>
+                              <polyline points="10,10 20,10 30,10" fill="none" stroke="none" opacity="0.5" marker-mid="url(#dot)"/>
+                              </svg>)");
+    reference.reset(QSvgTinyDocument::load(translucentDoc));
+    doc.reset(QSvgTinyDocument::load(translucentDoc));
+    QVERIFY(reference);
+    QVERIFY(doc);
+    reference->markerCache()->setMaxCost(0);
+
+    const QImage translucentRef = render(reference.get());
+    const QImage translucent = render(doc.get());
+    QVERIFY(doc->markerCache()->totalCost() > 0);
+    for (int y = 5; y < 15; ++y) {
+        for (int x = 15; x < 25; ++x) {
+            const QRgb pixel = translucent.pixel(x, y);
+            const QRgb refPixel = translucentRef.pixel(x, y);
+            QVERIFY2(qAbs(qRed(pixel) - qRed(refPixel)) <= 2
+                     && qAbs(qBlue(pixel) - qBlue(refPixel)) <= 2
+                     && qAbs(qAlpha(pixel) - qAlpha(refPixel)) <= 2,
+                     qPrintable(QString::asprintf("(%d, %d)", x, y)));
+        }
+    }
+}
+
+void tst_QSvgRenderer::testMarkerVertices()
+{
+    QByteArray svgDoc(R"(<svg width="100" height="100">
+                      <marker id="m" markerWidth="4" markerHeight="4" refX="2" refY="2">
+                      <rect width="4" height="4" fill="red"/>
+                      </marker>
+                      <polyline id="poly" points="10,10 50,10 50,50" fill="none" stroke="black"
+                      marker-mid="url(#m)" marker-end="url(#m)"/>
+                      <path id="path" d="M 10 60 L 50 60 Q 90 60 90 90" fill="none" stroke="black"
+                      marker-start="url(#m)" marker-mid="url(#m)"/>
+                      <rect id="rect" width="10" height="10"/>
+                      </svg>)");
+
+    std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(svgDoc));
+    QVERIFY(doc);
+    using MarkerKind = QSvgNode::MarkerKind;
+
+    const auto &polyVertices = doc->namedNode(u"poly"_s)->markerVertices();
+    QCOMPARE(polyVertices.size(), 2);
+    QCOMPARE(polyVertices.at(0).position, QPointF(50, 10));
+    QCOMPARE(polyVertices.at(0).kind, MarkerKind::Mid);
+    QCOMPARE(polyVertices.at(0).angle, -45.);
+    QCOMPARE(polyVertices.at(1).position, QPointF(50, 50));
+    QCOMPARE(polyVertices.at(1).kind, MarkerKind::End);
+    QCOMPARE(polyVertices.at(1).angle, 270.);
+    // The table is kept
+    QCOMPARE(doc->namedNode(u"poly"_s)->markerVertices().constData(), polyVertices.constData());
+
+    const auto &pathVertices = doc->namedNode(u"path"_s)->markerVertices();
+    QCOMPARE(pathVertices.size(), 2);
+    QCOMPARE(pathVertices.at(0).position, QPointF(10, 60));
+    QCOMPARE(pathVertices.at(0).kind, MarkerKind::Start);
+    QCOMPARE(pathVertices.at(1).position, QPointF(50, 60));
+    QCOMPARE(pathVertices.at(1).kind, MarkerKind::Mid);
+
+    QVERIFY(doc->namedNode(u"rect"_s)->markerVertices().isEmpty());
+
+    // Mid markers of polylines are drawn with the marker-mid marker
+    QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    doc->draw(&p, QRectF(0, 0, 100, 100));
+    p.end();
+    QCOMPARE(image.pixel(50, 9), QColor(Qt::red).rgba());
+}
+
+void tst_QSvgRenderer::testUseCache()
+{
+    // An icon placed nine times in one color and once in another
+    QByteArray svgDoc(R"(<svg width="100" height="100" xmlns:xlink="http://www.w3.org/1999/xlink">
+                      <defs>
+                      <g id="icon"><circle cx="5" cy="5" r="4" stroke="black"/></g>
+                      </defs>
+                      <use xlink:href="#icon" x="0" y="0" fill="red"/>
+                      <use xlink:href="#icon" x="10" y="0" fill="red"/>
+                      <use xlink:href="#icon" x="20" y="0" fill="red"/>
+                      <use xlink:href="#icon" x="0" y="10" fill="red"/>
+                      <use xlink:href="#icon" x="10" y="10" fill="red"/>
+                      <use xlink:href="#icon" x="20" y="10" fill="red"/>
+                      <use xlink:href="#icon" x="0" y="20" fill="red"/>
+                      <use xlink:href="#icon" x="10" y="20" fill="red"/>
+                      <use xlink:href="#icon" x="20" y="20" fill="red"/>
+                      <use xlink:href="#icon" x="50" y="50" fill="blue"/>
+                      </svg>)");
+
+    auto render = [](QSvgTinyDocument *doc) {
+        QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        doc->draw(&p, QRectF(0, 0, 100, 100));
+        return image;
+    };
+
+    std::unique_ptr<QSvgTinyDocument> reference(QSvgTinyDocument::load(svgDoc));
+    std::unique_ptr<QSvgTinyDocument> doc(QSvgTinyDocument::load(svgDoc, QtSvg::CacheUseElements));
+    QVERIFY(reference);
+    QVERIFY(doc);
+
+    // The cache is opt-in
+    QVERIFY(!reference->useCache()->isEnabled());
+    QVERIFY(doc->useCache()->isEnabled());
+    const QImage refImage = render(reference.get());
+    QCOMPARE(reference->useCache()->hits() + reference->useCache()->misses(), 0);
+
+    const QImage image = render(doc.get());
+    QCOMPARE(doc->useCache()->misses(), 2);
+    QCOMPARE(doc->useCache()->hits(), 8);
+    QVERIFY(doc->useCache()->totalCost() > 0);
+    QCOMPARE(render(doc.get()), image);
+    QCOMPARE(doc->useCache()->misses(), 2);
+    QCOMPARE(doc->useCache()->hits(), 18);
+
+    for (int y = 0; y < 100; ++y) {
+        for (int x = 0; x < 100; ++x) {
+            const QRgb pixel = image.pixel(x, y);
+            const QRgb refPixel = refImage.pixel(x, y);
+            QVERIFY2(qAbs(qRed(pixel) - qRed(refPixel)) <= 2
+                     && qAbs(qGreen(pixel) - qGreen(refPixel)) <= 2
+                     && qAbs(qBlue(pixel) - qBlue(refPixel)) <= 2
+                     && qAbs(qAlpha(pixel) - qAlpha(refPixel)) <= 2,
+                     qPrintable(QString::asprintf("(%d, %d)", x, y)));
+        }
+    }
+    QCOMPARE(image.pixel(25, 25), QColor(Qt::red).rgba());
+    QCOMPARE(image.pixel(55, 55), QColor(Qt::blue).rgba());
+
+    doc->useCache()->resetStatistics();
+    QCOMPARE(doc->useCache()->hits(), 0);
+    QCOMPARE(doc->useCache()->misses(), 0);
+
+    // The renderer passes the option on to the document
+    QSvgRenderer renderer;
+    renderer.setOptions(QtSvg::CacheUseElements);
+    QVERIFY(renderer.load(svgDoc));
+    QImage rendered(100, 100, QImage::Format_ARGB32_Premultiplied);
+    rendered.fill(Qt::transparent);
+    QPainter p(&rendered);
+    renderer.render(&p);
+    p.end();
+    QCOMPARE(rendered, image);
+}
+
+void tst_QSvgRenderer::testFilterTiles()
+{
+    // Tiles with the blur and offset footprints match the whole region
+    QByteArray svgDoc(R"(<svg width="100" height="100">
+                      <filter id="f1">
+                      <feGaussianBlur in="SourceAlpha" stdDeviation="3"/>
+                      <feOffset dx="4" dy="-3" result="shadow"/>
+                      <feFlood flood-color="red" flood-opacity="0.5"/>
+                      <feComposite in2="shadow" operator="in"/>
+                      <feMerge>
+                      <feMergeNode/>
+                      <feMergeNode in="SourceGraphic"/>
+                      </feMerge>
+                      </filter>
+                      <g filter="url(#f1)">
+                      <circle cx="40" cy="50" r="30" fill="blue"/>
+                      <rect x="50" y="20" width="35" height="60" fill="lime"/>
+                      </g>
+                      </svg>)");
+
+    auto render = [&]() {
+        QSvgRenderer renderer(svgDoc);
+        QImage image(200, 200, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+        p.end();
+        return image;
+    };
+
+    const QImage whole = render();
+    QSvgFilterContainer::setTileSize(32);
+    const QImage tiled = render();
+    QSvgFilterContainer::setTileSize(0);
+
+    QCOMPARE(tiled.size(), whole.size());
+    int maxDifference = 0;
+    for (int y = 0; y < whole.height(); ++y) {
+        for (int x = 0; x < whole.width(); ++x) {
+            const QRgb a = whole.pixel(x, y);
+            const QRgb b = tiled.pixel(x, y);
+            for (int shift : {0, 8, 16, 24})
+                maxDifference = qMax(maxDifference, qAbs(int((a >> shift) & 0xff) - int((b >> shift) & 0xff)));
+        }
+    }
+    // Antialiased edges may be rasterized slightly differently per tile
+    QVERIFY(maxDifference <= 1);
+}
+
 
 void tst_QSvgRenderer::testFeComposite()
 {
@@ -2261,6 +3414,36 @@ void tst_QSvgRenderer::testFeComposite()
     QCOMPARE(refImage, image);
 }
 
+void tst_QSvgRenderer::testFeCompositeArithmetic()
+{
+    // Overlapping inputs, and the constant k4 outside of both
+    QByteArray svgDoc(R"(<svg width="50" height="50">
+                      <filter id="f1" filterUnits="userSpaceOnUse" x="0" y="0" width="50" height="50"
+                              color-interpolation-filters="sRGB">
+                      <feOffset in="SourceGraphic" dx="10" result="moved"/>
+                      <feComposite in="SourceGraphic" in2="moved" operator="arithmetic"
+                                   k1="0.5" k2="0.4" k3="0.4" k4="0.2"/>
+                      </filter>
+                      <rect x="10" y="10" width="20" height="20" fill="blue" filter="url(#f1) "/>
+                      </svg>)");
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(50, 50, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    renderer.render(&p);
+    p.end();
+
+    // Color channels are clamped to alpha
+    QCOMPARE(image.pixel(5, 5), qRgba(51, 51, 51, 51));
+    QCOMPARE(image.pixel(15, 20), qRgba(51, 51, 153, 153));
+    QCOMPARE(image.pixel(25, 20), qRgba(51, 51, 255, 255));
+    QCOMPARE(image.pixel(35, 20), qRgba(51, 51, 153, 153));
+    QCOMPARE(image.pixel(45, 45), qRgba(51, 51, 51, 51));
+}
+
 void tst_QSvgRenderer::testFeGaussian()
 {
     QByteArray svgDoc(R"(<svg width="50" height="50">
@@ -2291,6 +3474,40 @@ void tst_QSvgRenderer::testFeGaussian()
 
 }
 
+void tst_QSvgRenderer::testFeGaussianApproximate()
+{
+    QByteArray svgDoc(R"(<svg width="400" height="300">
+                      <filter id="f1" x="-50%" y="-50%" width="200%" height="200%">
+                      <feGaussianBlur in="SourceGraphic" stdDeviation="40"/>
+                      </filter>
+                      <rect x="120" y="90" width="160" height="120" fill="black" filter="url(#f1)"/>
+                      </svg>)");
+
+    auto render = [&](QtSvg::Options options) {
+        QSvgRenderer renderer;
+        renderer.setOptions(options);
+        renderer.load(svgDoc);
+        QImage image(400, 300, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::white);
+        QPainter p(&image);
+        renderer.render(&p);
+        p.end();
+        return image;
+    };
+
+    const QImage exact = render(QtSvg::NoOption);
+    const QImage approximate = render(QtSvg::ApproximateLargeBlurs);
+
+    int maxError = 0;
+    for (int y = 0; y < exact.height(); ++y) {
+        for (int x = 0; x < exact.width(); ++x)
+            maxError = qMax(maxError, qAbs(qGray(exact.pixel(x, y)) - qGray(approximate.pixel(x, y))));
+    }
+    QCOMPARE_LE(maxError, 13);
+    QCOMPARE_LE(qGray(approximate.pixel(200, 150)), 100);
+    QCOMPARE(qGray(approximate.pixel(0, 0)), 255);
+}
+
 void tst_QSvgRenderer::testFeBlend()
 {
     QByteArray svgDoc(R"(<svg width="50" height="50">
@@ -2322,6 +3539,386 @@ void tst_QSvgRenderer::testFeBlend()
     QCOMPARE(refImage, image);
 }
 
+void tst_QSvgRenderer::testFeBlendModes_data()
+{
+    QTest::addColumn<QByteArray>("mode");
+
+    QTest::newRow("normal") << QByteArray("normal");
+    QTest::newRow("multiply") << QByteArray("multiply");
+    QTest::newRow("screen") << QByteArray("screen");
+    QTest::newRow("darken") << QByteArray("darken");
+    QTest::newRow("lighten") << QByteArray("lighten");
+}
+
+void tst_QSvgRenderer::testFeBlendModes()
+{
+    QFETCH(QByteArray, mode);
+
+    const QByteArray svgDoc = R"(<svg width="20" height="20">
+                              <filter id="f1" color-interpolation-filters="sRGB">
+                              <feFlood flood-color="#c86432" flood-opacity="0.8" result="top"/>
+                              <feFlood flood-color="#1496fa" flood-opacity="0.6" result="bottom"/>
+                              <feBlend in="top" in2="bottom" mode=")" + mode + R"("/>
+                              </filter>
+                              <rect width="20" height="20" filter="url(#f1)"/></svg>)";
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(20, 20, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    renderer.render(&p);
+    p.end();
+
+    const QRgb top = qPremultiply(qRgba(0xc8, 0x64, 0x32, qRound(0.8 * 255)));
+    const QRgb bottom = qPremultiply(qRgba(0x14, 0x96, 0xfa, qRound(0.6 * 255)));
+    const qreal a1 = qAlpha(top) / 255.;
+    const qreal a2 = qAlpha(bottom) / 255.;
+    auto channel = [&](int shift) {
+        const qreal c1 = ((top >> shift) & 0xff) / 255.;
+        const qreal c2 = ((bottom >> shift) & 0xff) / 255.;
+        qreal c = 0;
+        if (mode == "normal")
+            c = (1 - a1) * c2 + c1;
+        else if (mode == "multiply")
+            c = (1 - a1) * c2 + (1 - a2) * c1 + c1 * c2;
+        else if (mode == "screen")
+            c = c1 + c2 - c1 * c2;
+        else if (mode == "darken")
+            c = qMin((1 - a1) * c2 + c1, (1 - a2) * c1 + c2);
+        else
+            c = qMax((1 - a1) * c2 + c1, (1 - a2) * c1 + c2);
+        return qRound(c * 255);
+    };
+    const QRgb expected = qRgba(channel(16), channel(8), channel(0),
+                                qRound((1 - (1 - a1) * (1 - a2)) * 255));
+
+    const QRgb pixel = image.pixel(10, 10);
+    for (int shift : {0, 8, 16, 24})
+        QVERIFY(qAbs(int((pixel >> shift) & 0xff) - int((expected >> shift) & 0xff)) <= 2);
+}
+
+void tst_QSvgRenderer::testFeConvolveMatrix_data()
+{
+    QTest::addColumn<QByteArray>("attributes");
+    QTest::addColumn<QPoint>("position");
+    QTest::addColumn<QRgb>("expected");
+
+    QTest::newRow("box") << QByteArray(R"(kernelMatrix="1 1 1 1 1 1 1 1 1")")
+                         << QPoint(10, 10) << qRgba(255, 0, 0, 255);
+    QTest::newRow("box none") << QByteArray(R"(kernelMatrix="1 1 1 1 1 1 1 1 1" edgeMode="none")")
+                              << QPoint(10, 10) << qRgba(255, 0, 0, 113);
+    QTest::newRow("box none edge") << QByteArray(R"(kernelMatrix="1 1 1 1 1 1 1 1 1" edgeMode="none")")
+                                   << QPoint(15, 10) << qRgba(255, 0, 0, 170);
+    QTest::newRow("turned") << QByteArray(R"(kernelMatrix="1 0 0 0 0 0 0 0 0" edgeMode="none")")
+                            << QPoint(19, 10) << qRgba(0, 0, 0, 0);
+    QTest::newRow("diagonal") << QByteArray(R"(kernelMatrix="1 0 0 0 0 0 0 0 1" edgeMode="none")")
+                              << QPoint(10, 10) << qRgba(255, 0, 0, 128);
+    QTest::newRow("order") << QByteArray(R"(order="3 1" kernelMatrix="1 1 1" edgeMode="none")")
+                           << QPoint(10, 10) << qRgba(255, 0, 0, 170);
+    QTest::newRow("target") << QByteArray(R"(order="3 1" kernelMatrix="1 1 1" targetX="0" edgeMode="none")")
+                            << QPoint(19, 10) << qRgba(255, 0, 0, 85);
+    QTest::newRow("bias") << QByteArray(R"(kernelMatrix="0 0 0 0 1 0 0 0 0" divisor="2" bias="0.2")")
+                          << QPoint(15, 15) << qRgba(255, 73, 73, 179);
+    QTest::newRow("preserveAlpha") << QByteArray(R"(kernelMatrix="0 0 0 0 1 0 0 0 0" divisor="2" preserveAlpha="true")")
+                                   << QPoint(15, 15) << qRgba(128, 0, 0, 255);
+}
+
+void tst_QSvgRenderer::testFeConvolveMatrix()
+{
+    QFETCH(QByteArray, attributes);
+    QFETCH(QPoint, position);
+    QFETCH(QRgb, expected);
+
+    const QByteArray svgDoc = R"(<svg width="30" height="30">
+                              <filter id="f1" x="0" y="0" width="1" height="1" color-interpolation-filters="sRGB">
+                              <feConvolveMatrix )" + attributes + R"(/>
+                              </filter>
+                              <rect x="10" y="10" width="10" height="10" fill="red" filter="url(#f1)"/></svg>)";
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(30, 30, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    renderer.render(&p);
+    p.end();
+
+    const QRgb pixel = qUnpremultiply(image.pixel(position));
+    for (int shift : {0, 8, 16, 24})
+        QVERIFY(qAbs(int((pixel >> shift) & 0xff) - int((expected >> shift) & 0xff)) <= 2);
+}
+
+void tst_QSvgRenderer::testFeMorphology_data()
+{
+    QTest::addColumn<QByteArray>("attributes");
+    QTest::addColumn<QPoint>("inside");
+    QTest::addColumn<QPoint>("outside");
+
+    QTest::newRow("erode") << QByteArray(R"(operator="erode" radius="2")")
+                           << QPoint(12, 12) << QPoint(11, 15);
+    QTest::newRow("dilate") << QByteArray(R"(operator="dilate" radius="2")")
+                            << QPoint(8, 8) << QPoint(7, 15);
+    QTest::newRow("dilate x y") << QByteArray(R"(operator="dilate" radius="3 1")")
+                                << QPoint(7, 9) << QPoint(7, 8);
+    QTest::newRow("zero radius") << QByteArray(R"(operator="dilate" radius="0")")
+                                 << QPoint(10, 10) << QPoint(9, 9);
+}
+
+void tst_QSvgRenderer::testFeMorphology()
+{
+    QFETCH(QByteArray, attributes);
+    QFETCH(QPoint, inside);
+    QFETCH(QPoint, outside);
+
+    const QByteArray svgDoc = R"(<svg width="30" height="30">
+                              <filter id="f1" filterUnits="userSpaceOnUse" x="0" y="0" width="30" height="30">
+                              <feMorphology )" + attributes + R"(/>
+                              </filter>
+                              <rect x="10" y="10" width="10" height="10" fill="red" filter="url(#f1)"/></svg>)";
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(30, 30, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    renderer.render(&p);
+    p.end();
+
+    QCOMPARE(image.pixel(inside), qRgba(255, 0, 0, 255));
+    QCOMPARE(image.pixel(outside), qRgba(0, 0, 0, 0));
+}
+
+void tst_QSvgRenderer::testFeTurbulence()
+{
+    auto render = [](const QByteArray &attributes) {
+        const QByteArray svgDoc = R"(<svg width="60" height="60">
+                                  <filter id="f1" filterUnits="userSpaceOnUse" x="0" y="0" width="60" height="60"
+                                          color-interpolation-filters="sRGB">
+                                  <feTurbulence )" + attributes + R"(/>
+                                  </filter>
+                                  <rect width="60" height="60" filter="url(#f1)"/></svg>)";
+        QSvgRenderer renderer(svgDoc);
+        QImage image(60, 60, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+        p.end();
+        return image;
+    };
+    auto fuzzyCompare = [](QRgb pixel, QRgb expected) {
+        pixel = qUnpremultiply(pixel);
+        for (int shift : {0, 8, 16, 24}) {
+            if (qAbs(int((pixel >> shift) & 0xff) - int((expected >> shift) & 0xff)) > 3)
+                return false;
+        }
+        return true;
+    };
+
+    // Values of the reference implementation in the specification
+    const QImage noise = render(R"(type="fractalNoise" baseFrequency="0.05 0.08" numOctaves="4")");
+    QVERIFY(fuzzyCompare(noise.pixel(10, 20), qRgba(178, 77, 73, 113)));
+    QVERIFY(fuzzyCompare(noise.pixel(37, 5), qRgba(161, 144, 127, 178)));
+
+    // Without frequency, fractal noise is gray and turbulence is empty
+    QVERIFY(fuzzyCompare(render(R"(type="fractalNoise")").pixel(30, 30), qRgba(128, 128, 128, 128)));
+    QCOMPARE(render(R"(type="turbulence")").pixel(30, 30), qRgba(0, 0, 0, 0));
+
+    // The seed selects a different lattice
+    QVERIFY(render(R"(type="fractalNoise" baseFrequency="0.05" seed="1")")
+            != render(R"(type="fractalNoise" baseFrequency="0.05" seed="2")"));
+
+    // Stitched noise repeats at the size of the subregion
+    const QImage stitched = render(R"(baseFrequency="0.07" numOctaves="2" stitchTiles="stitch")");
+    QVERIFY(!stitched.isNull());
+    QVERIFY(stitched != render(R"(baseFrequency="0.07" numOctaves="2")"));
+}
+
+void tst_QSvgRenderer::testFeComponentTransfer_data()
+{
+    QTest::addColumn<QByteArray>("functions");
+    QTest::addColumn<QPoint>("position");
+    QTest::addColumn<QRgb>("expected");
+
+    QTest::newRow("identity") << QByteArray() << QPoint(20, 20) << qRgba(200, 100, 50, 255);
+    QTest::newRow("linear") << QByteArray(R"(<feFuncR type="linear" slope="0.5" intercept="0.1"/>)")
+                            << QPoint(20, 20) << qRgba(126, 100, 50, 255);
+    QTest::newRow("table") << QByteArray(R"(<feFuncG type="table" tableValues="0 1 0"/>)")
+                           << QPoint(20, 20) << qRgba(200, 200, 50, 255);
+    QTest::newRow("discrete") << QByteArray(R"(<feFuncB type="discrete" tableValues="0.2 0.8"/>)")
+                              << QPoint(20, 20) << qRgba(200, 100, 51, 255);
+    QTest::newRow("gamma") << QByteArray(R"(<feFuncR type="gamma" amplitude="2" offset="-0.5"/>)")
+                           << QPoint(20, 20) << qRgba(255, 100, 50, 255);
+    QTest::newRow("alpha") << QByteArray(R"(<feFuncA type="linear" slope="0.5"/>)")
+                           << QPoint(20, 20) << qRgba(200, 100, 50, 128);
+    QTest::newRow("transparent") << QByteArray(R"(<feFuncA type="linear" slope="0" intercept="1"/>)")
+                                 << QPoint(9, 9) << qRgba(0, 0, 0, 255);
+}
+
+void tst_QSvgRenderer::testFeComponentTransfer()
+{
+    QFETCH(QByteArray, functions);
+    QFETCH(QPoint, position);
+    QFETCH(QRgb, expected);
+
+    const QByteArray svgDoc = R"(<svg width="40" height="40">
+                              <filter id="f1" color-interpolation-filters="sRGB">
+                              <feComponentTransfer>)" + functions + R"(</feComponentTransfer>
+                              </filter>
+                              <rect x="10" y="10" width="20" height="20" fill="#c86432" filter="url(#f1)"/></svg>)";
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(40, 40, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    renderer.render(&p);
+    p.end();
+
+    const QRgb pixel = qUnpremultiply(image.pixel(position));
+    for (int shift : {0, 8, 16, 24})
+        QVERIFY(qAbs(int((pixel >> shift) & 0xff) - int((expected >> shift) & 0xff)) <= 1);
+}
+
+void tst_QSvgRenderer::testColorInterpolationFilters_data()
+{
+    QTest::addColumn<QByteArray>("svgAttributes");
+    QTest::addColumn<QByteArray>("filterAttributes");
+    QTest::addColumn<QByteArray>("primitiveAttributes");
+    QTest::addColumn<int>("expected");
+
+    // Halving the gray in linearRGB is lighter than halving it in sRGB
+    QTest::newRow("default") << QByteArray() << QByteArray() << QByteArray() << 93;
+    QTest::newRow("sRGB") << QByteArray() << QByteArray(R"(color-interpolation-filters="sRGB")")
+                          << QByteArray() << 64;
+    QTest::newRow("style") << QByteArray() << QByteArray(R"(style="color-interpolation-filters:sRGB")")
+                           << QByteArray() << 64;
+    QTest::newRow("inherited") << QByteArray(R"(color-interpolation-filters="sRGB")") << QByteArray()
+                               << QByteArray() << 64;
+    QTest::newRow("primitive") << QByteArray() << QByteArray(R"(color-interpolation-filters="sRGB")")
+                               << QByteArray(R"(color-interpolation-filters="linearRGB")") << 93;
+}
+
+void tst_QSvgRenderer::testColorInterpolationFilters()
+{
+    QFETCH(QByteArray, svgAttributes);
+    QFETCH(QByteArray, filterAttributes);
+    QFETCH(QByteArray, primitiveAttributes);
+    QFETCH(int, expected);
+
+    const QByteArray svgDoc = R"(<svg width="20" height="20" )" + svgAttributes + R"(>
+                              <filter id="f1" )" + filterAttributes + R"(>
+                              <feComponentTransfer )" + primitiveAttributes + R"(>
+                              <feFuncR type="linear" slope="0.5"/>
+                              <feFuncG type="linear" slope="0.5"/>
+                              <feFuncB type="linear" slope="0.5"/>
+                              </feComponentTransfer>
+                              </filter>
+                              <rect width="20" height="20" fill="#808080" filter="url(#f1)"/></svg>)";
+
+    QSvgRenderer renderer(svgDoc);
+    QVERIFY(renderer.isValid());
+
+    QImage image(20, 20, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    renderer.render(&p);
+    p.end();
+
+    const QRgb pixel = image.pixel(10, 10);
+    QCOMPARE(qAlpha(pixel), 255);
+    for (int channel : {qRed(pixel), qGreen(pixel), qBlue(pixel)})
+        QVERIFY2(qAbs(channel - expected) <= 2, qPrintable(QString::number(channel)));
+}
+
+static QByteArray dropShadowIdiom(bool offsetFirst, bool tint, bool over,
+                                  const QByteArray &lastAttributes)
+{
+    QByteArray filter = offsetFirst
+            ? R"(<feOffset in="SourceAlpha" dx="4" dy="3"/><feGaussianBlur stdDeviation="2" result="shadow"/>)"
+            : R"(<feGaussianBlur in="SourceAlpha" stdDeviation="2"/><feOffset dx="4" dy="3" result="shadow"/>)";
+    if (tint) {
+        filter += R"(<feFlood flood-color="#0000ff" flood-opacity="0.5"/>
+                     <feComposite in2="shadow" operator="in" result="shadow"/>)";
+    }
+    if (over) {
+        filter += R"(<feComposite in="SourceGraphic" in2="shadow" operator="over" )"
+                + lastAttributes + "/>";
+    } else {
+        filter += "<feMerge " + lastAttributes + R"(><feMergeNode in="shadow"/>
+                   <feMergeNode in="SourceGraphic"/></feMerge>)";
+    }
+    return filter;
+}
+
+void tst_QSvgRenderer::testFeDropShadow_data()
+{
+    QTest::addColumn<QByteArray>("filter");
+    QTest::addColumn<QByteArray>("reference");
+
+    // An explicit subregion equal to the filter region keeps the idiom from being fused
+    const QByteArray unfused = R"(x="5" y="5" width="40" height="40")";
+
+    QTest::newRow("feDropShadow")
+            << QByteArray(R"(<feDropShadow dx="4" dy="3" stdDeviation="2" flood-color="#0000ff" flood-opacity="0.5"/>)")
+            << dropShadowIdiom(false, true, false, unfused);
+    QTest::newRow("feDropShadow defaults")
+            << QByteArray("<feDropShadow/>")
+            << QByteArray(R"(<feGaussianBlur in="SourceAlpha" stdDeviation="2"/><feOffset dx="2" dy="2"/>
+                             <feMerge x="5" y="5" width="40" height="40"><feMergeNode/>
+                             <feMergeNode in="SourceGraphic"/></feMerge>)");
+    QTest::newRow("tinted merge")
+            << dropShadowIdiom(false, true, false, QByteArray())
+            << dropShadowIdiom(false, true, false, unfused);
+    QTest::newRow("offset first")
+            << dropShadowIdiom(true, true, false, QByteArray())
+            << dropShadowIdiom(true, true, false, unfused);
+    QTest::newRow("untinted over")
+            << dropShadowIdiom(false, false, true, QByteArray())
+            << dropShadowIdiom(false, false, true, unfused);
+}
+
+void tst_QSvgRenderer::testFeDropShadow()
+{
+    QFETCH(QByteArray, filter);
+    QFETCH(QByteArray, reference);
+
+    auto render = [](const QByteArray &primitives) {
+        const QByteArray svgDoc = R"(<svg width="50" height="50">
+                                  <filter id="f1" x="-50%" y="-50%" width="200%" height="200%"
+                                  color-interpolation-filters="sRGB">)" + primitives + R"(</filter>
+                                  <rect x="15" y="15" width="20" height="20" fill="#c86432"
+                                  filter="url(#f1)"/></svg>)";
+        QImage image(50, 50, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QSvgRenderer renderer(svgDoc);
+        QPainter p(&image);
+        renderer.render(&p);
+        p.end();
+        return image;
+    };
+
+    const QImage actual = render(filter);
+    const QImage expected = render(reference);
+    QVERIFY(qAlpha(expected.pixel(37, 37)) > 0);
+    QCOMPARE(qAlpha(expected.pixel(10, 10)), 0);
+
+    for (int y = 0; y < actual.height(); ++y) {
+        for (int x = 0; x < actual.width(); ++x) {
+            const QRgb a = actual.pixel(x, y);
+            const QRgb e = expected.pixel(x, y);
+            const int difference = qMax(qMax(qAbs(qRed(a) - qRed(e)), qAbs(qGreen(a) - qGreen(e))),
+                                        qMax(qAbs(qBlue(a) - qBlue(e)), qAbs(qAlpha(a) - qAlpha(e))));
+            QVERIFY2(difference <= 3, qPrintable(QStringLiteral("(%1, %2): %3 != %4")
+                                                 .arg(x).arg(y).arg(a, 8, 16).arg(e, 8, 16)));
+        }
+    }
+}
+
 void tst_QSvgRenderer::testOption_data()
 {
     QTest::addColumn<QtSvg::Option>("option");
@@ -2331,6 +3928,8 @@ void tst_QSvgRenderer::testOption_data()
     QTest::newRow("Assume Trusted Source") << QtSvg::Option::AssumeTrustedSource;
     QTest::newRow("Disable SMIL") << QtSvg::Option::DisableSMILAnimations;
     QTest::newRow("Disable Animations") << QtSvg::Option::DisableAnimations;
+    QTest::newRow("Bake Animations") << QtSvg::Option::BakeAnimations;
+    QTest::newRow("Approximate Large Blurs") << QtSvg::Option::ApproximateLargeBlurs;
 }
 
 void tst_QSvgRenderer::testOption()
@@ -4,6 +4,8 @@
 #include <qtest.h>
 
 #include <QFile>
+#include <QImage>
+#include <QPainter>
 #include <QSvgRenderer>
 
 class tst_QSvgRenderer : public QObject
@@ -21,10 +23,44 @@ public slots:
 private slots:
     void construct();
     void load();
+    void renderAnimatedFrame();
+    void gaussianBlur_data();
+    void gaussianBlur();
+    void colorMatrix_data();
+    void colorMatrix();
+    void composite_data();
+    void composite();
+    void blend_data();
+    void blend();
+    void convolveMatrix_data();
+    void convolveMatrix();
+    void morphology_data();
+    void morphology();
+    void turbulence_data();
+    void turbulence();
+    void componentTransfer_data();
+    void componentTransfer();
+    void dropShadow_data();
+    void dropShadow();
+    void mask();
+    void clipPath_data();
+    void clipPath();
+    void groupOpacity_data();
+    void groupOpacity();
+    void dashedStrokes_data();
+    void dashedStrokes();
+    void pattern_data();
+    void pattern();
+    void markers_data();
+    void markers();
+    void useSymbols_data();
+    void useSymbols();
 };
 
 tst_QSvgRenderer::tst_QSvgRenderer()
 {
+    // Measure the filters rather than the filter cache
+    qputenv("QT_SVG_FILTER_CACHE_LIMIT", "0");
 }
 
 tst_QSvgRenderer::~tst_QSvgRenderer()
@@ -59,5 +95,602 @@ void tst_QSvgRenderer::load()
     }
 }
 
+void tst_QSvgRenderer::renderAnimatedFrame()
+{
+    // 10000 nodes, every tenth one carrying a color and a transform animation
+    QByteArray data("<svg width=\"1000\" height=\"1000\">");
+    for (int i = 0; i < 10000; ++i) {
+        const QByteArray x = QByteArray::number((i % 100) * 10);
+        const QByteArray y = QByteArray::number((i / 100) * 10);
+        data += "<rect x=\"" + x + "\" y=\"" + y + "\" width=\"8\" height=\"8\" fill=\"blue\"";
+        if (i % 10) {
+            data += "/>";
+            continue;
+        }
+        data += "><animateColor attributeName=\"fill\" from=\"blue\" to=\"red\" dur=\"1s\" repeatCount=\"indefinite\"/>"
+                "<animateTransform attributeName=\"transform\" type=\"rotate\" from=\"0 " + x + " " + y + "\" to=\"360 "
+                + x + " " + y + "\" dur=\"1s\" repeatCount=\"indefinite\"/></rect>";
+    }
+    data += "</svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+    QVERIFY(renderer.animated());
+
+    QImage image(1000, 1000, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::gaussianBlur_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<qreal>("stdDeviation");
+
+    QTest::newRow("512x512, sigma 2") << QSize(512, 512) << 2.0;
+    QTest::newRow("512x512, sigma 20") << QSize(512, 512) << 20.0;
+    QTest::newRow("1920x1080, sigma 4") << QSize(1920, 1080) << 4.0;
+    QTest::newRow("1920x1080, sigma 32") << QSize(1920, 1080) << 32.0;
+}
+
+void tst_QSvgRenderer::gaussianBlur()
+{
+    QFETCH(QSize, size);
+    QFETCH(qreal, stdDeviation);
+
+    const QByteArray width = QByteArray::number(size.width());
+    const QByteArray height = QByteArray::number(size.height());
+    const QByteArray data = "<svg width=\"" + width + "\" height=\"" + height + "\">"
+            "<filter id=\"blur\" x=\"0\" y=\"0\" width=\"1\" height=\"1\">"
+            "<feGaussianBlur stdDeviation=\"" + QByteArray::number(stdDeviation) + "\"/></filter>"
+            "<g filter=\"url(#blur)\"><rect width=\"" + width + "\" height=\"" + height + "\" fill=\"blue\"/>"
+            "<circle cx=\"50%\" cy=\"50%\" r=\"25%\" fill=\"red\"/></g></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::colorMatrix_data()
+{
+    QTest::addColumn<QByteArray>("type");
+    QTest::addColumn<QByteArray>("values");
+
+    QTest::newRow("identity") << QByteArray("matrix")
+                              << QByteArray("1 0 0 0 0 0 1 0 0 0 0 0 1 0 0 0 0 0 1 0");
+    QTest::newRow("saturate") << QByteArray("saturate") << QByteArray("0.3");
+    QTest::newRow("hueRotate") << QByteArray("hueRotate") << QByteArray("90");
+    QTest::newRow("luminanceToAlpha") << QByteArray("luminanceToAlpha") << QByteArray();
+    QTest::newRow("matrix") << QByteArray("matrix")
+                            << QByteArray("0.5 0.2 0 0 0.1 0 1 0 0 0 0.3 0 0.6 0 0 0 0 0 0.8 0.1");
+}
+
+void tst_QSvgRenderer::colorMatrix()
+{
+    QFETCH(QByteArray, type);
+    QFETCH(QByteArray, values);
+
+    const QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<filter id=\"f\" x=\"0\" y=\"0\" width=\"1\" height=\"1\">"
+            "<feColorMatrix type=\"" + type + "\" values=\"" + values + "\"/></filter>"
+            "<g filter=\"url(#f)\"><rect width=\"1920\" height=\"1080\" fill=\"blue\" fill-opacity=\"0.5\"/>"
+            "<circle cx=\"50%\" cy=\"50%\" r=\"25%\" fill=\"orange\"/></g></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::composite_data()
+{
+    QTest::addColumn<QByteArray>("attributes");
+
+    QTest::newRow("over") << QByteArray("operator=\"over\"");
+    QTest::newRow("in") << QByteArray("operator=\"in\"");
+    QTest::newRow("out") << QByteArray("operator=\"out\"");
+    QTest::newRow("atop") << QByteArray("operator=\"atop\"");
+    QTest::newRow("xor") << QByteArray("operator=\"xor\"");
+    QTest::newRow("arithmetic") << QByteArray("operator=\"arithmetic\" k1=\"0.5\" k2=\"0.5\" k3=\"0.5\"");
+}
+
+void tst_QSvgRenderer::composite()
+{
+    QFETCH(QByteArray, attributes);
+
+    const QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<filter id=\"f\" x=\"0\" y=\"0\" width=\"1\" height=\"1\">"
+            "<feOffset dx=\"200\" dy=\"100\" result=\"moved\"/>"
+            "<feComposite in=\"SourceGraphic\" in2=\"moved\" " + attributes + "/></filter>"
+            "<g filter=\"url(#f)\"><rect width=\"1920\" height=\"1080\" fill=\"blue\" fill-opacity=\"0.5\"/>"
+            "<circle cx=\"50%\" cy=\"50%\" r=\"25%\" fill=\"orange\"/></g></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::blend_data()
+{
+    QTest::addColumn<QByteArray>("mode");
+
+    QTest::newRow("normal") << QByteArray("normal");
+    QTest::newRow("multiply") << QByteArray("multiply");
+    QTest::newRow("screen") << QByteArray("screen");
+    QTest::newRow("darken") << QByteArray("darken");
+    QTest::newRow("lighten") << QByteArray("lighten");
+}
+
+void tst_QSvgRenderer::blend()
+{
+    QFETCH(QByteArray, mode);
+
+    const QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<filter id=\"f\" x=\"0\" y=\"0\" width=\"1\" height=\"1\">"
+            "<feOffset dx=\"200\" dy=\"100\" result=\"moved\"/>"
+            "<feBlend in=\"SourceGraphic\" in2=\"moved\" mode=\"" + mode + "\"/></filter>"
+            "<g filter=\"url(#f)\"><rect width=\"1920\" height=\"1080\" fill=\"blue\" fill-opacity=\"0.5\"/>"
+            "<circle cx=\"50%\" cy=\"50%\" r=\"25%\" fill=\"orange\"/></g></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::convolveMatrix_data()
+{
+    QTest::addColumn<QByteArray>("attributes");
+
+    QTest::newRow("sharpen") << QByteArray("kernelMatrix=\"0 -1 0 -1 5 -1 0 -1 0\"");
+    QTest::newRow("emboss") << QByteArray("kernelMatrix=\"-2 -1 0 -1 1 1 0 1 2\" preserveAlpha=\"true\"");
+    QTest::newRow("box 7x7 separable")
+            << QByteArray("order=\"7\" kernelMatrix=\"" + QByteArray("1 ").repeated(49) + "\"");
+    QTest::newRow("box 7x7 wrap")
+            << QByteArray("order=\"7\" edgeMode=\"wrap\" kernelMatrix=\"" + QByteArray("1 ").repeated(49) + "\"");
+}
+
+void tst_QSvgRenderer::convolveMatrix()
+{
+    QFETCH(QByteArray, attributes);
+
+    const QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<filter id=\"f\" x=\"0\" y=\"0\" width=\"1\" height=\"1\">"
+            "<feConvolveMatrix " + attributes + "/></filter>"
+            "<g filter=\"url(#f)\"><rect width=\"1920\" height=\"1080\" fill=\"blue\" fill-opacity=\"0.5\"/>"
+            "<circle cx=\"50%\" cy=\"50%\" r=\"25%\" fill=\"orange\"/></g></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::morphology_data()
+{
+    QTest::addColumn<QByteArray>("attributes");
+
+    QTest::newRow("erode 2") << QByteArray("operator=\"erode\" radius=\"2\"");
+    QTest::newRow("erode 40") << QByteArray("operator=\"erode\" radius=\"40\"");
+    QTest::newRow("dilate 2") << QByteArray("operator=\"dilate\" radius=\"2\"");
+    QTest::newRow("dilate 40") << QByteArray("operator=\"dilate\" radius=\"40\"");
+}
+
+void tst_QSvgRenderer::morphology()
+{
+    QFETCH(QByteArray, attributes);
+
+    const QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<filter id=\"f\" x=\"0\" y=\"0\" width=\"1\" height=\"1\">"
+            "<feMorphology " + attributes + "/></filter>"
+            "<g filter=\"url(#f)\"><rect width=\"1920\" height=\"1080\" fill=\"blue\" fill-opacity=\"0.5\"/>"
+            "<circle cx=\"50%\" cy=\"50%\" r=\"25%\" fill=\"orange\"/></g></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::turbulence_data()
+{
+    QTest::addColumn<QByteArray>("attributes");
+
+    QTest::newRow("fractalNoise 1") << QByteArray("type=\"fractalNoise\" baseFrequency=\"0.01\"");
+    QTest::newRow("fractalNoise 4") << QByteArray("type=\"fractalNoise\" baseFrequency=\"0.01\" numOctaves=\"4\"");
+    QTest::newRow("turbulence 4") << QByteArray("type=\"turbulence\" baseFrequency=\"0.01\" numOctaves=\"4\"");
+    QTest::newRow("stitch 4") << QByteArray("baseFrequency=\"0.01\" numOctaves=\"4\" stitchTiles=\"stitch\"");
+}
+
+void tst_QSvgRenderer::turbulence()
+{
+    QFETCH(QByteArray, attributes);
+
+    const QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<filter id=\"f\" x=\"0\" y=\"0\" width=\"1\" height=\"1\">"
+            "<feTurbulence " + attributes + "/></filter>"
+            "<rect width=\"1920\" height=\"1080\" filter=\"url(#f)\"/></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::componentTransfer_data()
+{
+    QTest::addColumn<QByteArray>("colorSpace");
+    QTest::addColumn<QByteArray>("functions");
+
+    const QByteArray table = "<feFuncR type=\"table\" tableValues=\"0 0.5 1\"/>"
+                             "<feFuncG type=\"gamma\" amplitude=\"1\" exponent=\"2.2\"/>"
+                             "<feFuncB type=\"discrete\" tableValues=\"0 0.25 0.5 0.75 1\"/>";
+    const QByteArray alpha = "<feFuncA type=\"linear\" slope=\"0.5\"/>";
+
+    QTest::newRow("sRGB identity") << QByteArray("sRGB") << QByteArray();
+    QTest::newRow("sRGB color") << QByteArray("sRGB") << table;
+    QTest::newRow("sRGB alpha") << QByteArray("sRGB") << QByteArray(table + alpha);
+    QTest::newRow("linearRGB color") << QByteArray("linearRGB") << table;
+}
+
+void tst_QSvgRenderer::componentTransfer()
+{
+    QFETCH(QByteArray, colorSpace);
+    QFETCH(QByteArray, functions);
+
+    const QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<filter id=\"f\" x=\"0\" y=\"0\" width=\"1\" height=\"1\" "
+            "color-interpolation-filters=\"" + colorSpace + "\">"
+            "<feComponentTransfer>" + functions + "</feComponentTransfer></filter>"
+            "<g filter=\"url(#f)\"><rect width=\"1920\" height=\"1080\" fill=\"blue\" fill-opacity=\"0.5\"/>"
+            "<circle cx=\"50%\" cy=\"50%\" r=\"25%\" fill=\"orange\"/></g></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::dropShadow_data()
+{
+    QTest::addColumn<QByteArray>("primitives");
+
+    const QByteArray idiom = "<feGaussianBlur in=\"SourceAlpha\" stdDeviation=\"6\"/>"
+                             "<feOffset dx=\"8\" dy=\"8\" result=\"offset\"/>"
+                             "<feFlood flood-color=\"black\" flood-opacity=\"0.5\"/>"
+                             "<feComposite in2=\"offset\" operator=\"in\"/>";
+    const QByteArray merge = "<feMergeNode/><feMergeNode in=\"SourceGraphic\"/></feMerge>";
+
+    QTest::newRow("feDropShadow")
+            << QByteArray("<feDropShadow dx=\"8\" dy=\"8\" stdDeviation=\"6\" flood-opacity=\"0.5\"/>");
+    QTest::newRow("fused idiom") << QByteArray(idiom + "<feMerge>" + merge);
+    // An explicit subregion keeps the idiom from being fused
+    QTest::newRow("unfused idiom")
+            << QByteArray(idiom + "<feMerge x=\"0\" y=\"0\" width=\"1920\" height=\"1080\">" + merge);
+}
+
+void tst_QSvgRenderer::dropShadow()
+{
+    QFETCH(QByteArray, primitives);
+
+    const QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<filter id=\"f\" filterUnits=\"userSpaceOnUse\" x=\"0\" y=\"0\" width=\"1920\" height=\"1080\">"
+            + primitives + "</filter>"
+            "<g filter=\"url(#f)\"><rect x=\"10%\" y=\"10%\" width=\"40%\" height=\"40%\" fill=\"blue\"/>"
+            "<circle cx=\"60%\" cy=\"60%\" r=\"20%\" fill=\"orange\"/></g></svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::mask()
+{
+    // A grid of icons sharing one gradient mask
+    QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+            "<linearGradient id=\"g\"><stop offset=\"0\" stop-color=\"white\"/>"
+            "<stop offset=\"1\" stop-color=\"black\"/></linearGradient>"
+            "<mask id=\"m\" maskContentUnits=\"objectBoundingBox\">"
+            "<rect width=\"1\" height=\"1\" fill=\"url(#g)\"/></mask>"
+            "<defs><circle id=\"c\" cx=\"48\" cy=\"48\" r=\"48\" fill=\"blue\" mask=\"url(#m)\"/></defs>";
+    for (int y = 0; y < 1080; y += 120) {
+        for (int x = 0; x < 1920; x += 120)
+            data += "<use href=\"#c\" x=\"" + QByteArray::number(x) + "\" y=\"" + QByteArray::number(y) + "\"/>";
+    }
+    data += "</svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::clipPath_data()
+{
+    QTest::addColumn<QByteArray>("element");
+    QTest::addColumn<QByteArray>("reference");
+
+    const QByteArray shapes = "<circle cx=\"48\" cy=\"48\" r=\"40\"/>"
+                              "<rect x=\"8\" y=\"40\" width=\"80\" height=\"16\"/>";
+
+    QTest::newRow("clipPath") << QByteArray("<clipPath id=\"c\">" + shapes + "</clipPath>")
+                              << QByteArray("clip-path=\"url(#c)\"");
+    QTest::newRow("mask") << QByteArray("<mask id=\"c\" fill=\"white\">" + shapes + "</mask>")
+                          << QByteArray("mask=\"url(#c)\"");
+}
+
+void tst_QSvgRenderer::clipPath()
+{
+    QFETCH(QByteArray, element);
+    QFETCH(QByteArray, reference);
+
+    // The same region as a clip path and as a mask, on a grid of icons
+    QByteArray data = "<svg width=\"1920\" height=\"1080\">" + element;
+    for (int y = 0; y < 1080; y += 120) {
+        for (int x = 0; x < 1920; x += 120) {
+            data += "<g transform=\"translate(" + QByteArray::number(x) + " " + QByteArray::number(y) + ")\">"
+                    "<rect width=\"96\" height=\"96\" fill=\"blue\" " + reference + "/></g>";
+        }
+    }
+    data += "</svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::groupOpacity_data()
+{
+    QTest::addColumn<int>("gap");
+
+    QTest::newRow("disjoint") << 4;
+    QTest::newRow("overlapping") << -4;
+}
+
+void tst_QSvgRenderer::groupOpacity()
+{
+    QFETCH(int, gap);
+
+    // A bar chart with a semi-transparent group per series
+    QByteArray data = "<svg width=\"1920\" height=\"1080\">";
+    for (int y = 0; y < 1080; y += 60) {
+        data += "<g opacity=\"0.6\" fill=\"steelblue\">";
+        for (int x = 0; x < 1920; x += 24) {
+            data += "<rect x=\"" + QByteArray::number(x) + "\" y=\"" + QByteArray::number(y + (x * 7) % 40)
+                    + "\" width=\"" + QByteArray::number(24 - gap) + "\" height=\"20\"/>";
+        }
+        data += "</g>";
+    }
+    data += "</svg>";
+
+    QSvgRenderer renderer;
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::dashedStrokes_data()
+{
+    QTest::addColumn<int>("cacheLimit");
+
+    QTest::newRow("uncached") << 0;
+    QTest::newRow("cached") << 8 * 1024;
+}
+
+void tst_QSvgRenderer::dashedStrokes()
+{
+    QFETCH(int, cacheLimit);
+
+    // A drawing with many dashed hidden edges
+    QByteArray data = "<svg width=\"1920\" height=\"1080\"><g fill=\"none\" stroke=\"black\" "
+                      "stroke-width=\"2\" stroke-dasharray=\"6 3\">";
+    for (int y = 0; y < 1080; y += 40) {
+        for (int x = 0; x < 1920; x += 40) {
+            data += "<path d=\"M " + QByteArray::number(x + 4) + " " + QByteArray::number(y + 4)
+                    + " q 16 30 32 0 v 32 h -32 z\"/>";
+        }
+    }
+    data += "</g></svg>";
+
+    qputenv("QT_SVG_STROKE_CACHE_LIMIT", QByteArray::number(cacheLimit));
+    QSvgRenderer renderer;
+    const bool loaded = renderer.load(data);
+    qunsetenv("QT_SVG_STROKE_CACHE_LIMIT");
+    QVERIFY(loaded);
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::pattern_data()
+{
+    QTest::addColumn<int>("cacheLimit");
+
+    QTest::newRow("uncached") << 0;
+    QTest::newRow("cached") << 8 * 1024;
+}
+
+void tst_QSvgRenderer::pattern()
+{
+    QFETCH(int, cacheLimit);
+
+    // A floor plan with hatched rooms
+    QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+                      "<pattern id=\"hatch\" patternUnits=\"userSpaceOnUse\" width=\"12\" height=\"12\">"
+                      "<path d=\"M 0 12 L 12 0 M -3 3 L 3 -3 M 9 15 L 15 9\" stroke=\"gray\"/></pattern>";
+    for (int y = 0; y < 1080; y += 90) {
+        for (int x = 0; x < 1920; x += 120) {
+            data += "<rect x=\"" + QByteArray::number(x + 5) + "\" y=\"" + QByteArray::number(y + 5)
+                    + "\" width=\"110\" height=\"80\" fill=\"url(#hatch)\" stroke=\"black\"/>";
+        }
+    }
+    data += "</svg>";
+
+    qputenv("QT_SVG_PATTERN_CACHE_LIMIT", QByteArray::number(cacheLimit));
+    QSvgRenderer renderer;
+    const bool loaded = renderer.load(data);
+    qunsetenv("QT_SVG_PATTERN_CACHE_LIMIT");
+    QVERIFY(loaded);
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::markers_data()
+{
+    QTest::addColumn<int>("cacheLimit");
+
+    QTest::newRow("uncached") << 0;
+    QTest::newRow("cached") << 4 * 1024;
+}
+
+void tst_QSvgRenderer::markers()
+{
+    QFETCH(int, cacheLimit);
+
+    // A scatter plot, a dot at each of the points of a series
+    QByteArray data = "<svg width=\"1920\" height=\"1080\">"
+                      "<marker id=\"dot\" markerWidth=\"8\" markerHeight=\"8\" refX=\"4\" refY=\"4\" "
+                      "markerUnits=\"userSpaceOnUse\">"
+                      "<circle cx=\"4\" cy=\"4\" r=\"3\" fill=\"steelblue\" stroke=\"navy\"/></marker>";
+    for (int series = 0; series < 10; ++series) {
+        data += "<polyline fill=\"none\" stroke=\"none\" marker-start=\"url(#dot)\" "
+                "marker-mid=\"url(#dot)\" marker-end=\"url(#dot)\" points=\"";
+        for (int x = 0; x < 1920; x += 4) {
+            const int y = 540 + series * 40 - 400 + (x * (series + 3) * 37 % 211);
+            data += QByteArray::number(x) + ',' + QByteArray::number(y) + ' ';
+        }
+        data += "\"/>";
+    }
+    data += "</svg>";
+
+    qputenv("QT_SVG_MARKER_CACHE_LIMIT", QByteArray::number(cacheLimit));
+    QSvgRenderer renderer;
+    const bool loaded = renderer.load(data);
+    qunsetenv("QT_SVG_MARKER_CACHE_LIMIT");
+    QVERIFY(loaded);
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
+void tst_QSvgRenderer::useSymbols_data()
+{
+    QTest::addColumn<bool>("useCache");
+
+    QTest::newRow("uncached") << false;
+    QTest::newRow("cached") << true;
+}
+
+void tst_QSvgRenderer::useSymbols()
+{
+    QFETCH(bool, useCache);
+
+    // Map symbology, one pin icon placed at every point of interest
+    QByteArray data = "<svg width=\"1920\" height=\"1080\" xmlns:xlink=\"http://www.w3.org/1999/xlink\">"
+                      "<defs><g id=\"pin\">"
+                      "<path d=\"M 8 0 C 3 0 0 4 0 8 C 0 13 8 20 8 20 C 8 20 16 13 16 8 C 16 4 13 0 8 0 Z\" "
+                      "stroke=\"black\"/>"
+                      "<circle cx=\"8\" cy=\"8\" r=\"3\" fill=\"white\"/></g></defs>";
+    for (int y = 0; y < 1080; y += 30) {
+        for (int x = 0; x < 1920; x += 24) {
+            data += "<use xlink:href=\"#pin\" x=\"" + QByteArray::number(x + 4) + "\" y=\""
+                    + QByteArray::number(y + 5) + "\" fill=\"" + ((x + y) % 48 ? "crimson" : "teal")
+                    + "\"/>";
+        }
+    }
+    data += "</svg>";
+
+    QSvgRenderer renderer;
+    renderer.setOptions(useCache ? QtSvg::CacheUseElements : QtSvg::NoOption);
+    QVERIFY(renderer.load(data));
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        renderer.render(&p);
+    }
+}
+
 QTEST_MAIN(tst_QSvgRenderer)
 #include "tst_qsvgrenderer.moc"
@@ -0,0 +1,117 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qthreadpool.h>
+#include <QtGui/qguiapplication.h>
+#include <QtGui/qimage.h>
+#include <QtSvg/private/qsvgframesequence_p.h>
+
+#include <cstdio>
+
+using namespace Qt::Literals::StringLiterals;
+
+static bool parseSize(const QString &str, QSize *size)
+{
+    const QStringList parts = str.split(u'x');
+    if (parts.size() != 2)
+        return false;
+    bool okWidth = false;
+    bool okHeight = false;
+    const int width = parts.at(0).toInt(&okWidth);
+    const int height = parts.at(1).toInt(&okHeight);
+    if (!okWidth || !okHeight || width <= 0 || height <= 0)
+        return false;
+    *size = QSize(width, height);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName(u"svgframeexport"_s);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+            u"Renders every frame of an animated SVG document into a sequence of images."_s);
+    parser.addHelpOption();
+    parser.addPositionalArgument(u"input"_s, u"The SVG document to render."_s);
+    parser.addPositionalArgument(u"output"_s, u"The directory the frames are written to."_s);
+
+    QCommandLineOption fpsOption({ u"f"_s, u"fps"_s }, u"Frames per second (default 30)."_s,
+                                 u"fps"_s, u"30"_s);
+    parser.addOption(fpsOption);
+    QCommandLineOption durationOption({ u"d"_s, u"duration"_s },
+                                      u"Duration in milliseconds (default: the animation duration)."_s,
+                                      u"msecs"_s);
+    parser.addOption(durationOption);
+    QCommandLineOption sizeOption({ u"s"_s, u"size"_s },
+                                  u"Frame size as WIDTHxHEIGHT (default: the document size)."_s,
+                                  u"size"_s);
+    parser.addOption(sizeOption);
+    QCommandLineOption threadsOption({ u"j"_s, u"threads"_s },
+                                     u"Number of rendering threads (default: ideal thread count)."_s,
+                                     u"count"_s);
+    parser.addOption(threadsOption);
+    QCommandLineOption formatOption(u"format"_s, u"Image format of the frames (default png)."_s,
+                                    u"format"_s, u"png"_s);
+    parser.addOption(formatOption);
+
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2)
+        parser.showHelp(1);
+
+    QFile file(positional.at(0));
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "Cannot open %s: %s\n", qPrintable(file.fileName()),
+                qPrintable(file.errorString()));
+        return 1;
+    }
+
+    QSvgFrameSequenceExporter exporter(file.readAll());
+    if (!exporter.isValid()) {
+        fprintf(stderr, "Cannot load %s\n", qPrintable(file.fileName()));
+        return 1;
+    }
+
+    exporter.setFramesPerSecond(parser.value(fpsOption).toInt());
+    if (parser.isSet(durationOption))
+        exporter.setDuration(parser.value(durationOption).toInt());
+    if (parser.isSet(sizeOption)) {
+        QSize size;
+        if (!parseSize(parser.value(sizeOption), &size)) {
+            fprintf(stderr, "Invalid size %s\n", qPrintable(parser.value(sizeOption)));
+            return 1;
+        }
+        exporter.setSize(size);
+    }
+
+    QThreadPool pool;
+    if (parser.isSet(threadsOption))
+        pool.setMaxThreadCount(qMax(1, parser.value(threadsOption).toInt()));
+    exporter.setThreadPool(&pool);
+
+    const QDir outputDir(positional.at(1));
+    if (!outputDir.mkpath(u"."_s)) {
+        fprintf(stderr, "Cannot create %s\n", qPrintable(outputDir.path()));
+        return 1;
+    }
+
+    const QString format = parser.value(formatOption);
+    const int digits = QString::number(exporter.frameCount() - 1).size();
+    bool written = true;
+    const bool rendered = exporter.exportFrames([&](int frame, const QImage &image) {
+        const QString fileName = outputDir.filePath(u"frame_%1.%2"_s
+                                        .arg(frame, digits, 10, u'0').arg(format));
+        if (!image.save(fileName, qPrintable(format))) {
+            fprintf(stderr, "Cannot write %s\n", qPrintable(fileName));
+            written = false;
+        }
+    });
+
+    return rendered && written ? 0 : 1;
+}